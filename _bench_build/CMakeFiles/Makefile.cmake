@@ -0,0 +1,90 @@
+# CMAKE generated file: DO NOT EDIT!
+# Generated by "Unix Makefiles" Generator, CMake Version 3.25
+
+# The generator used is:
+set(CMAKE_DEPENDS_GENERATOR "Unix Makefiles")
+
+# The top level Makefile was generated from the following files:
+set(CMAKE_MAKEFILE_DEPENDS
+  "CMakeCache.txt"
+  "/root/repo/CMakeLists.txt"
+  "CMakeFiles/3.25.1/CMakeCCompiler.cmake"
+  "CMakeFiles/3.25.1/CMakeCXXCompiler.cmake"
+  "CMakeFiles/3.25.1/CMakeSystem.cmake"
+  "/root/repo/bench/CMakeLists.txt"
+  "/root/repo/generated/CMakeLists.txt"
+  "/root/repo/src/Ast.cpp"
+  "/root/repo/src/Ast.h"
+  "/root/repo/src/AstBuilder.cpp"
+  "/root/repo/src/AstBuilder.h"
+  "/root/repo/src/Builtins.cpp"
+  "/root/repo/src/Builtins.h"
+  "/root/repo/src/ConstantFolder.cpp"
+  "/root/repo/src/ConstantFolder.h"
+  "/root/repo/src/DescentParser.cpp"
+  "/root/repo/src/DescentParser.h"
+  "/root/repo/src/Frontend.cpp"
+  "/root/repo/src/LoopHoister.cpp"
+  "/root/repo/src/LoopHoister.h"
+  "/root/repo/src/Memo.cpp"
+  "/root/repo/src/Memo.h"
+  "/root/repo/src/Operators.h"
+  "/root/repo/src/ParallelParser.cpp"
+  "/root/repo/src/ParallelParser.h"
+  "/root/repo/src/ProgramCache.cpp"
+  "/root/repo/src/Resolver.cpp"
+  "/root/repo/src/Resolver.h"
+  "/root/repo/src/Tokenizer.cpp"
+  "/root/repo/src/Tokenizer.h"
+  "/root/repo/src/TypeInference.cpp"
+  "/root/repo/src/TypeInference.h"
+  "/root/repo/src/Value.cpp"
+  "/root/repo/src/Value.h"
+  "/usr/share/cmake-3.25/Modules/CMakeCInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCXXInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCommonLanguageInclude.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeGenericSystem.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeInitializeConfigs.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeLanguageInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeSystemSpecificInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeSystemSpecificInitialize.cmake"
+  "/usr/share/cmake-3.25/Modules/CheckCSourceCompiles.cmake"
+  "/usr/share/cmake-3.25/Modules/CheckIncludeFile.cmake"
+  "/usr/share/cmake-3.25/Modules/CheckLibraryExists.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/CMakeCommonCompilerMacros.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU-C.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU-CXX.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU.cmake"
+  "/usr/share/cmake-3.25/Modules/FindPackageHandleStandardArgs.cmake"
+  "/usr/share/cmake-3.25/Modules/FindPackageMessage.cmake"
+  "/usr/share/cmake-3.25/Modules/FindThreads.cmake"
+  "/usr/share/cmake-3.25/Modules/Internal/CheckSourceCompiles.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU-C.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU-CXX.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/UnixPaths.cmake"
+  )
+
+# The corresponding makefile is:
+set(CMAKE_MAKEFILE_OUTPUTS
+  "Makefile"
+  "CMakeFiles/cmake.check_cache"
+  )
+
+# Byproducts of CMake generate step:
+set(CMAKE_MAKEFILE_PRODUCTS
+  "CMakeFiles/CMakeDirectoryInformation.cmake"
+  "generated/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "bench/CMakeFiles/CMakeDirectoryInformation.cmake"
+  )
+
+# Dependency information for all targets:
+set(CMAKE_DEPEND_INFO_FILES
+  "CMakeFiles/code.dir/DependInfo.cmake"
+  "generated/CMakeFiles/PyAntlr.dir/DependInfo.cmake"
+  "bench/CMakeFiles/dispatch_bench_threaded.dir/DependInfo.cmake"
+  "bench/CMakeFiles/dispatch_bench_switch.dir/DependInfo.cmake"
+  "bench/CMakeFiles/lexer_bench.dir/DependInfo.cmake"
+  "bench/CMakeFiles/parser_bench.dir/DependInfo.cmake"
+  )
@@ -0,0 +1,43 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/Ast.cpp" "CMakeFiles/code.dir/src/Ast.cpp.o" "gcc" "CMakeFiles/code.dir/src/Ast.cpp.o.d"
+  "/root/repo/src/AstBuilder.cpp" "CMakeFiles/code.dir/src/AstBuilder.cpp.o" "gcc" "CMakeFiles/code.dir/src/AstBuilder.cpp.o.d"
+  "/root/repo/src/Builtins.cpp" "CMakeFiles/code.dir/src/Builtins.cpp.o" "gcc" "CMakeFiles/code.dir/src/Builtins.cpp.o.d"
+  "/root/repo/src/Bytecode.cpp" "CMakeFiles/code.dir/src/Bytecode.cpp.o" "gcc" "CMakeFiles/code.dir/src/Bytecode.cpp.o.d"
+  "/root/repo/src/ClosureEngine.cpp" "CMakeFiles/code.dir/src/ClosureEngine.cpp.o" "gcc" "CMakeFiles/code.dir/src/ClosureEngine.cpp.o.d"
+  "/root/repo/src/Compiler.cpp" "CMakeFiles/code.dir/src/Compiler.cpp.o" "gcc" "CMakeFiles/code.dir/src/Compiler.cpp.o.d"
+  "/root/repo/src/ConstantFolder.cpp" "CMakeFiles/code.dir/src/ConstantFolder.cpp.o" "gcc" "CMakeFiles/code.dir/src/ConstantFolder.cpp.o.d"
+  "/root/repo/src/DescentParser.cpp" "CMakeFiles/code.dir/src/DescentParser.cpp.o" "gcc" "CMakeFiles/code.dir/src/DescentParser.cpp.o.d"
+  "/root/repo/src/DfaCache.cpp" "CMakeFiles/code.dir/src/DfaCache.cpp.o" "gcc" "CMakeFiles/code.dir/src/DfaCache.cpp.o.d"
+  "/root/repo/src/Evalvisitor.cpp" "CMakeFiles/code.dir/src/Evalvisitor.cpp.o" "gcc" "CMakeFiles/code.dir/src/Evalvisitor.cpp.o.d"
+  "/root/repo/src/Frontend.cpp" "CMakeFiles/code.dir/src/Frontend.cpp.o" "gcc" "CMakeFiles/code.dir/src/Frontend.cpp.o.d"
+  "/root/repo/src/Interpreter.cpp" "CMakeFiles/code.dir/src/Interpreter.cpp.o" "gcc" "CMakeFiles/code.dir/src/Interpreter.cpp.o.d"
+  "/root/repo/src/Jit.cpp" "CMakeFiles/code.dir/src/Jit.cpp.o" "gcc" "CMakeFiles/code.dir/src/Jit.cpp.o.d"
+  "/root/repo/src/LoopHoister.cpp" "CMakeFiles/code.dir/src/LoopHoister.cpp.o" "gcc" "CMakeFiles/code.dir/src/LoopHoister.cpp.o.d"
+  "/root/repo/src/Memo.cpp" "CMakeFiles/code.dir/src/Memo.cpp.o" "gcc" "CMakeFiles/code.dir/src/Memo.cpp.o.d"
+  "/root/repo/src/NodeTable.cpp" "CMakeFiles/code.dir/src/NodeTable.cpp.o" "gcc" "CMakeFiles/code.dir/src/NodeTable.cpp.o.d"
+  "/root/repo/src/ParallelParser.cpp" "CMakeFiles/code.dir/src/ParallelParser.cpp.o" "gcc" "CMakeFiles/code.dir/src/ParallelParser.cpp.o.d"
+  "/root/repo/src/ProgramCache.cpp" "CMakeFiles/code.dir/src/ProgramCache.cpp.o" "gcc" "CMakeFiles/code.dir/src/ProgramCache.cpp.o.d"
+  "/root/repo/src/Resolver.cpp" "CMakeFiles/code.dir/src/Resolver.cpp.o" "gcc" "CMakeFiles/code.dir/src/Resolver.cpp.o.d"
+  "/root/repo/src/Tokenizer.cpp" "CMakeFiles/code.dir/src/Tokenizer.cpp.o" "gcc" "CMakeFiles/code.dir/src/Tokenizer.cpp.o.d"
+  "/root/repo/src/TypeInference.cpp" "CMakeFiles/code.dir/src/TypeInference.cpp.o" "gcc" "CMakeFiles/code.dir/src/TypeInference.cpp.o.d"
+  "/root/repo/src/Value.cpp" "CMakeFiles/code.dir/src/Value.cpp.o" "gcc" "CMakeFiles/code.dir/src/Value.cpp.o.d"
+  "/root/repo/src/Vm.cpp" "CMakeFiles/code.dir/src/Vm.cpp.o" "gcc" "CMakeFiles/code.dir/src/Vm.cpp.o.d"
+  "/root/repo/src/main.cpp" "CMakeFiles/code.dir/src/main.cpp.o" "gcc" "CMakeFiles/code.dir/src/main.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_bench_build/generated/CMakeFiles/PyAntlr.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,57 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/code.dir/src/Ast.cpp.o"
+  "CMakeFiles/code.dir/src/Ast.cpp.o.d"
+  "CMakeFiles/code.dir/src/AstBuilder.cpp.o"
+  "CMakeFiles/code.dir/src/AstBuilder.cpp.o.d"
+  "CMakeFiles/code.dir/src/Builtins.cpp.o"
+  "CMakeFiles/code.dir/src/Builtins.cpp.o.d"
+  "CMakeFiles/code.dir/src/Bytecode.cpp.o"
+  "CMakeFiles/code.dir/src/Bytecode.cpp.o.d"
+  "CMakeFiles/code.dir/src/ClosureEngine.cpp.o"
+  "CMakeFiles/code.dir/src/ClosureEngine.cpp.o.d"
+  "CMakeFiles/code.dir/src/Compiler.cpp.o"
+  "CMakeFiles/code.dir/src/Compiler.cpp.o.d"
+  "CMakeFiles/code.dir/src/ConstantFolder.cpp.o"
+  "CMakeFiles/code.dir/src/ConstantFolder.cpp.o.d"
+  "CMakeFiles/code.dir/src/DescentParser.cpp.o"
+  "CMakeFiles/code.dir/src/DescentParser.cpp.o.d"
+  "CMakeFiles/code.dir/src/DfaCache.cpp.o"
+  "CMakeFiles/code.dir/src/DfaCache.cpp.o.d"
+  "CMakeFiles/code.dir/src/Evalvisitor.cpp.o"
+  "CMakeFiles/code.dir/src/Evalvisitor.cpp.o.d"
+  "CMakeFiles/code.dir/src/Frontend.cpp.o"
+  "CMakeFiles/code.dir/src/Frontend.cpp.o.d"
+  "CMakeFiles/code.dir/src/Interpreter.cpp.o"
+  "CMakeFiles/code.dir/src/Interpreter.cpp.o.d"
+  "CMakeFiles/code.dir/src/Jit.cpp.o"
+  "CMakeFiles/code.dir/src/Jit.cpp.o.d"
+  "CMakeFiles/code.dir/src/LoopHoister.cpp.o"
+  "CMakeFiles/code.dir/src/LoopHoister.cpp.o.d"
+  "CMakeFiles/code.dir/src/Memo.cpp.o"
+  "CMakeFiles/code.dir/src/Memo.cpp.o.d"
+  "CMakeFiles/code.dir/src/NodeTable.cpp.o"
+  "CMakeFiles/code.dir/src/NodeTable.cpp.o.d"
+  "CMakeFiles/code.dir/src/ParallelParser.cpp.o"
+  "CMakeFiles/code.dir/src/ParallelParser.cpp.o.d"
+  "CMakeFiles/code.dir/src/ProgramCache.cpp.o"
+  "CMakeFiles/code.dir/src/ProgramCache.cpp.o.d"
+  "CMakeFiles/code.dir/src/Resolver.cpp.o"
+  "CMakeFiles/code.dir/src/Resolver.cpp.o.d"
+  "CMakeFiles/code.dir/src/Tokenizer.cpp.o"
+  "CMakeFiles/code.dir/src/Tokenizer.cpp.o.d"
+  "CMakeFiles/code.dir/src/TypeInference.cpp.o"
+  "CMakeFiles/code.dir/src/TypeInference.cpp.o.d"
+  "CMakeFiles/code.dir/src/Value.cpp.o"
+  "CMakeFiles/code.dir/src/Value.cpp.o.d"
+  "CMakeFiles/code.dir/src/Vm.cpp.o"
+  "CMakeFiles/code.dir/src/Vm.cpp.o.d"
+  "CMakeFiles/code.dir/src/main.cpp.o"
+  "CMakeFiles/code.dir/src/main.cpp.o.d"
+  "code"
+  "code.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/code.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,27 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/Ast.cpp" "bench/CMakeFiles/dispatch_bench_switch.dir/__/src/Ast.cpp.o" "gcc" "bench/CMakeFiles/dispatch_bench_switch.dir/__/src/Ast.cpp.o.d"
+  "/root/repo/src/Builtins.cpp" "bench/CMakeFiles/dispatch_bench_switch.dir/__/src/Builtins.cpp.o" "gcc" "bench/CMakeFiles/dispatch_bench_switch.dir/__/src/Builtins.cpp.o.d"
+  "/root/repo/src/Bytecode.cpp" "bench/CMakeFiles/dispatch_bench_switch.dir/__/src/Bytecode.cpp.o" "gcc" "bench/CMakeFiles/dispatch_bench_switch.dir/__/src/Bytecode.cpp.o.d"
+  "/root/repo/src/Jit.cpp" "bench/CMakeFiles/dispatch_bench_switch.dir/__/src/Jit.cpp.o" "gcc" "bench/CMakeFiles/dispatch_bench_switch.dir/__/src/Jit.cpp.o.d"
+  "/root/repo/src/Memo.cpp" "bench/CMakeFiles/dispatch_bench_switch.dir/__/src/Memo.cpp.o" "gcc" "bench/CMakeFiles/dispatch_bench_switch.dir/__/src/Memo.cpp.o.d"
+  "/root/repo/src/Resolver.cpp" "bench/CMakeFiles/dispatch_bench_switch.dir/__/src/Resolver.cpp.o" "gcc" "bench/CMakeFiles/dispatch_bench_switch.dir/__/src/Resolver.cpp.o.d"
+  "/root/repo/src/Value.cpp" "bench/CMakeFiles/dispatch_bench_switch.dir/__/src/Value.cpp.o" "gcc" "bench/CMakeFiles/dispatch_bench_switch.dir/__/src/Value.cpp.o.d"
+  "/root/repo/src/Vm.cpp" "bench/CMakeFiles/dispatch_bench_switch.dir/__/src/Vm.cpp.o" "gcc" "bench/CMakeFiles/dispatch_bench_switch.dir/__/src/Vm.cpp.o.d"
+  "/root/repo/bench/dispatch_bench.cpp" "bench/CMakeFiles/dispatch_bench_switch.dir/dispatch_bench.cpp.o" "gcc" "bench/CMakeFiles/dispatch_bench_switch.dir/dispatch_bench.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
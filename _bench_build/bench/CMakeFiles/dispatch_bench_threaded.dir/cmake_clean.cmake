@@ -0,0 +1,27 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/dispatch_bench_threaded.dir/__/src/Ast.cpp.o"
+  "CMakeFiles/dispatch_bench_threaded.dir/__/src/Ast.cpp.o.d"
+  "CMakeFiles/dispatch_bench_threaded.dir/__/src/Builtins.cpp.o"
+  "CMakeFiles/dispatch_bench_threaded.dir/__/src/Builtins.cpp.o.d"
+  "CMakeFiles/dispatch_bench_threaded.dir/__/src/Bytecode.cpp.o"
+  "CMakeFiles/dispatch_bench_threaded.dir/__/src/Bytecode.cpp.o.d"
+  "CMakeFiles/dispatch_bench_threaded.dir/__/src/Jit.cpp.o"
+  "CMakeFiles/dispatch_bench_threaded.dir/__/src/Jit.cpp.o.d"
+  "CMakeFiles/dispatch_bench_threaded.dir/__/src/Memo.cpp.o"
+  "CMakeFiles/dispatch_bench_threaded.dir/__/src/Memo.cpp.o.d"
+  "CMakeFiles/dispatch_bench_threaded.dir/__/src/Resolver.cpp.o"
+  "CMakeFiles/dispatch_bench_threaded.dir/__/src/Resolver.cpp.o.d"
+  "CMakeFiles/dispatch_bench_threaded.dir/__/src/Value.cpp.o"
+  "CMakeFiles/dispatch_bench_threaded.dir/__/src/Value.cpp.o.d"
+  "CMakeFiles/dispatch_bench_threaded.dir/__/src/Vm.cpp.o"
+  "CMakeFiles/dispatch_bench_threaded.dir/__/src/Vm.cpp.o.d"
+  "CMakeFiles/dispatch_bench_threaded.dir/dispatch_bench.cpp.o"
+  "CMakeFiles/dispatch_bench_threaded.dir/dispatch_bench.cpp.o.d"
+  "dispatch_bench_threaded"
+  "dispatch_bench_threaded.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/dispatch_bench_threaded.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
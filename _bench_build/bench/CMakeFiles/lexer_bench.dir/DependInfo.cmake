@@ -0,0 +1,21 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/Tokenizer.cpp" "bench/CMakeFiles/lexer_bench.dir/__/src/Tokenizer.cpp.o" "gcc" "bench/CMakeFiles/lexer_bench.dir/__/src/Tokenizer.cpp.o.d"
+  "/root/repo/bench/lexer_bench.cpp" "bench/CMakeFiles/lexer_bench.dir/lexer_bench.cpp.o" "gcc" "bench/CMakeFiles/lexer_bench.dir/lexer_bench.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_bench_build/generated/CMakeFiles/PyAntlr.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
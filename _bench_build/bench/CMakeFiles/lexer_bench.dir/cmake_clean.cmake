@@ -0,0 +1,13 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/lexer_bench.dir/__/src/Tokenizer.cpp.o"
+  "CMakeFiles/lexer_bench.dir/__/src/Tokenizer.cpp.o.d"
+  "CMakeFiles/lexer_bench.dir/lexer_bench.cpp.o"
+  "CMakeFiles/lexer_bench.dir/lexer_bench.cpp.o.d"
+  "lexer_bench"
+  "lexer_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/lexer_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
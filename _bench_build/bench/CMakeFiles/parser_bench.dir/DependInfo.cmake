@@ -0,0 +1,27 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/Ast.cpp" "bench/CMakeFiles/parser_bench.dir/__/src/Ast.cpp.o" "gcc" "bench/CMakeFiles/parser_bench.dir/__/src/Ast.cpp.o.d"
+  "/root/repo/src/AstBuilder.cpp" "bench/CMakeFiles/parser_bench.dir/__/src/AstBuilder.cpp.o" "gcc" "bench/CMakeFiles/parser_bench.dir/__/src/AstBuilder.cpp.o.d"
+  "/root/repo/src/Builtins.cpp" "bench/CMakeFiles/parser_bench.dir/__/src/Builtins.cpp.o" "gcc" "bench/CMakeFiles/parser_bench.dir/__/src/Builtins.cpp.o.d"
+  "/root/repo/src/DescentParser.cpp" "bench/CMakeFiles/parser_bench.dir/__/src/DescentParser.cpp.o" "gcc" "bench/CMakeFiles/parser_bench.dir/__/src/DescentParser.cpp.o.d"
+  "/root/repo/src/ParallelParser.cpp" "bench/CMakeFiles/parser_bench.dir/__/src/ParallelParser.cpp.o" "gcc" "bench/CMakeFiles/parser_bench.dir/__/src/ParallelParser.cpp.o.d"
+  "/root/repo/src/Tokenizer.cpp" "bench/CMakeFiles/parser_bench.dir/__/src/Tokenizer.cpp.o" "gcc" "bench/CMakeFiles/parser_bench.dir/__/src/Tokenizer.cpp.o.d"
+  "/root/repo/src/Value.cpp" "bench/CMakeFiles/parser_bench.dir/__/src/Value.cpp.o" "gcc" "bench/CMakeFiles/parser_bench.dir/__/src/Value.cpp.o.d"
+  "/root/repo/bench/parser_bench.cpp" "bench/CMakeFiles/parser_bench.dir/parser_bench.cpp.o" "gcc" "bench/CMakeFiles/parser_bench.dir/parser_bench.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_bench_build/generated/CMakeFiles/PyAntlr.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,25 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/parser_bench.dir/__/src/Ast.cpp.o"
+  "CMakeFiles/parser_bench.dir/__/src/Ast.cpp.o.d"
+  "CMakeFiles/parser_bench.dir/__/src/AstBuilder.cpp.o"
+  "CMakeFiles/parser_bench.dir/__/src/AstBuilder.cpp.o.d"
+  "CMakeFiles/parser_bench.dir/__/src/Builtins.cpp.o"
+  "CMakeFiles/parser_bench.dir/__/src/Builtins.cpp.o.d"
+  "CMakeFiles/parser_bench.dir/__/src/DescentParser.cpp.o"
+  "CMakeFiles/parser_bench.dir/__/src/DescentParser.cpp.o.d"
+  "CMakeFiles/parser_bench.dir/__/src/ParallelParser.cpp.o"
+  "CMakeFiles/parser_bench.dir/__/src/ParallelParser.cpp.o.d"
+  "CMakeFiles/parser_bench.dir/__/src/Tokenizer.cpp.o"
+  "CMakeFiles/parser_bench.dir/__/src/Tokenizer.cpp.o.d"
+  "CMakeFiles/parser_bench.dir/__/src/Value.cpp.o"
+  "CMakeFiles/parser_bench.dir/__/src/Value.cpp.o.d"
+  "CMakeFiles/parser_bench.dir/parser_bench.cpp.o"
+  "CMakeFiles/parser_bench.dir/parser_bench.cpp.o.d"
+  "parser_bench"
+  "parser_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/parser_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
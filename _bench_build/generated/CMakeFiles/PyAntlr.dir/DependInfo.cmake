@@ -0,0 +1,22 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/generated/Python3Lexer.cpp" "generated/CMakeFiles/PyAntlr.dir/Python3Lexer.cpp.o" "gcc" "generated/CMakeFiles/PyAntlr.dir/Python3Lexer.cpp.o.d"
+  "/root/repo/generated/Python3Parser.cpp" "generated/CMakeFiles/PyAntlr.dir/Python3Parser.cpp.o" "gcc" "generated/CMakeFiles/PyAntlr.dir/Python3Parser.cpp.o.d"
+  "/root/repo/generated/Python3ParserBaseVisitor.cpp" "generated/CMakeFiles/PyAntlr.dir/Python3ParserBaseVisitor.cpp.o" "gcc" "generated/CMakeFiles/PyAntlr.dir/Python3ParserBaseVisitor.cpp.o.d"
+  "/root/repo/generated/Python3ParserVisitor.cpp" "generated/CMakeFiles/PyAntlr.dir/Python3ParserVisitor.cpp.o" "gcc" "generated/CMakeFiles/PyAntlr.dir/Python3ParserVisitor.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,17 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/PyAntlr.dir/Python3Lexer.cpp.o"
+  "CMakeFiles/PyAntlr.dir/Python3Lexer.cpp.o.d"
+  "CMakeFiles/PyAntlr.dir/Python3Parser.cpp.o"
+  "CMakeFiles/PyAntlr.dir/Python3Parser.cpp.o.d"
+  "CMakeFiles/PyAntlr.dir/Python3ParserBaseVisitor.cpp.o"
+  "CMakeFiles/PyAntlr.dir/Python3ParserBaseVisitor.cpp.o.d"
+  "CMakeFiles/PyAntlr.dir/Python3ParserVisitor.cpp.o"
+  "CMakeFiles/PyAntlr.dir/Python3ParserVisitor.cpp.o.d"
+  "libPyAntlr.a"
+  "libPyAntlr.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/PyAntlr.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
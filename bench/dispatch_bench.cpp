@@ -0,0 +1,56 @@
+// Measures the cost of dispatching one VM instruction. The program is
+// assembled by hand so that nearly every executed instruction is a cheap
+// operation on booleans, and the number executed is known exactly.
+//
+// usage: dispatch_bench_{threaded,switch} [iterations]
+#include "Bytecode.h"
+#include "Vm.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#ifndef DISPATCH_KIND
+#define DISPATCH_KIND "default"
+#endif
+
+int main(int argc, char** argv) {
+    long long iterations = argc > 1 ? std::atoll(argv[1]) : 1000000;
+    const int unroll = 64;
+
+    ast::SymbolTable symbols;
+    BytecodeProgram program;
+    program.symbols = &symbols;
+    program.constants = {Value(true), Value(BigInt(iterations)), Value(BigInt(1)), Value()};
+
+    // r0 counts down from iterations and r2 holds True. The unrolled body
+    // mixes opcodes so each dispatch branch sees a varied successor, and
+    // is long enough to hide the big-int decrement.
+    auto module = std::make_unique<FunctionProto>();
+    module->name = ast::NO_SYMBOL;
+    module->frameSize = 5;
+    std::vector<Instr>& code = module->code;
+    code.push_back(Instr{Opcode::LOADK, 0, 0, 0, 0, 1});
+    code.push_back(Instr{Opcode::LOADK, 0, 1, 0, 0, 2});
+    code.push_back(Instr{Opcode::LOADK, 0, 2, 0, 0, 0});
+    uint32_t loop = code.size();
+    for (int i = 0; i < unroll; i++) {
+        code.push_back(Instr{Opcode::MOVE, 0, 3, 2, 0, 0});
+        code.push_back(Instr{Opcode::JUMPIFNOT, 0, 3, 0, 0, 0});
+        code.push_back(Instr{Opcode::JUMPIF, 0, 2, 0, 0, static_cast<uint32_t>(code.size() + 1)});
+        code.push_back(Instr{Opcode::JUMP, 0, 0, 0, 0, static_cast<uint32_t>(code.size() + 1)});
+    }
+    code.push_back(Instr{Opcode::SUB, 0, 0, 0, 1, 0});
+    code.push_back(Instr{Opcode::JUMPIF, 0, 0, 0, 0, loop});
+    code.push_back(Instr{Opcode::LOADK, 0, 4, 0, 0, 3});
+    code.push_back(Instr{Opcode::RETURN, 0, 4, 0, 0, 0});
+    program.functions.push_back(std::move(module));
+
+    long long executed = 3 + iterations * (unroll * 4 + 2) + 2;
+    auto start = std::chrono::steady_clock::now();
+    Vm(program).run();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::printf("%s dispatch: %lld instructions in %.3f s, %.2f ns/instruction\n", DISPATCH_KIND, executed,
+                elapsed.count(), elapsed.count() * 1e9 / executed);
+    return 0;
+}
@@ -0,0 +1,119 @@
+// Checks the hand-written tokenizer against the generated Python3Lexer and
+// compares their throughput. Every file must produce the same tokens from
+// both: same types, and the same text, line and column for every token;
+// the first difference is reported and fails the run.
+//
+// usage: lexer_bench [--repeat=N] file...
+#include "Python3Lexer.h"
+#include "Tokenizer.h"
+#include "antlr4-runtime.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<PyToken> antlrTokens(const std::string& source, std::vector<std::string>& texts) {
+    antlr4::ANTLRInputStream input(source);
+    Python3Lexer lexer(&input);
+    antlr4::CommonTokenStream stream(&lexer);
+    stream.fill();
+    std::vector<PyToken> tokens;
+    for (antlr4::Token* token : stream.getTokens()) {
+        texts.push_back(token->getText());
+        tokens.push_back(PyToken{token->getType(), {}, static_cast<uint32_t>(token->getLine()),
+                                 static_cast<uint32_t>(token->getCharPositionInLine()), 0});
+    }
+    return tokens;
+}
+
+void printToken(const char* label, const PyToken& token, const std::string& text) {
+    std::fprintf(stderr, "  %s: type %lld '%s' at %u:%u\n", label, static_cast<long long>(token.type), text.c_str(),
+                 token.line, token.column);
+}
+
+bool check(const char* path, const std::string& source) {
+    std::vector<std::string> texts;
+    std::vector<PyToken> expected = antlrTokens(source, texts);
+    std::vector<PyToken> actual = tokenize(source);
+    for (size_t i = 0; i < expected.size() || i < actual.size(); i++) {
+        if (i < expected.size() && i < actual.size()) {
+            const PyToken& e = expected[i];
+            const PyToken& a = actual[i];
+            if (e.type == a.type && texts[i] == a.text && e.line == a.line && e.column == a.column) continue;
+        }
+        std::fprintf(stderr, "%s: token %zu differs\n", path, i);
+        if (i < expected.size()) printToken("antlr", expected[i], texts[i]);
+        if (i < actual.size()) printToken("tokenizer", actual[i], std::string(actual[i].text));
+        return false;
+    }
+    return true;
+}
+
+template <typename F>
+double timeRuns(int repeat, F lex) {
+    auto start = Clock::now();
+    for (int i = 0; i < repeat; i++) lex();
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+}// namespace
+
+int main(int argc, char** argv) {
+    int repeat = 1;
+    std::vector<std::string> sources;
+    bool ok = true;
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "--repeat=", 9) == 0) {
+            repeat = std::max(1, std::atoi(argv[i] + 9));
+            continue;
+        }
+        std::ifstream file(argv[i], std::ios::binary);
+        if (!file) {
+            std::fprintf(stderr, "cannot read %s\n", argv[i]);
+            return 2;
+        }
+        sources.emplace_back((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        ok = check(argv[i], sources.back()) && ok;
+    }
+    std::printf("%zu files, %s\n", sources.size(), ok ? "token streams identical" : "TOKEN STREAMS DIFFER");
+
+    size_t bytes = 0;
+    size_t tokens = 0;
+    for (const std::string& source : sources) {
+        bytes += source.size();
+        tokens += tokenize(source).size();
+    }
+    double antlrSeconds = timeRuns(repeat, [&] {
+        for (const std::string& source : sources) {
+            antlr4::ANTLRInputStream input(source);
+            Python3Lexer lexer(&input);
+            antlr4::CommonTokenStream stream(&lexer);
+            stream.fill();
+        }
+    });
+    double tokenizerSeconds = timeRuns(repeat, [&] {
+        for (const std::string& source : sources) {
+            TokenizerSource tokenSource(source);
+            antlr4::CommonTokenStream stream(&tokenSource);
+            stream.fill();
+        }
+    });
+    double scanSeconds = timeRuns(repeat, [&] {
+        for (const std::string& source : sources) tokenize(source);
+    });
+
+    double megabytes = static_cast<double>(bytes) * repeat / 1e6;
+    std::printf("%zu bytes, %zu tokens, %d runs\n", bytes, tokens, repeat);
+    std::printf("antlr lexer:          %8.3f s, %8.2f MB/s\n", antlrSeconds, megabytes / antlrSeconds);
+    std::printf("tokenizer via stream: %8.3f s, %8.2f MB/s\n", tokenizerSeconds, megabytes / tokenizerSeconds);
+    std::printf("tokenizer alone:      %8.3f s, %8.2f MB/s\n", scanSeconds, megabytes / scanSeconds);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,369 @@
+// Checks the DescentParser against Python3Parser followed by AstBuilder and
+// compares their parse time and peak memory. Both must find as many syntax
+// errors in every file and lower it to the same AST, recovering alike from
+// any errors; the ASTs are compared by a dump that names symbols and
+// constants by their text and value, so interning order does not matter.
+// The first difference is reported and fails the run. Every file is also
+// parsed by parseParallel, which must give the DescentParser's AST with the
+// same symbol and constant numbering, and checked once more without its
+// final newline, which leaves the last statement to end at EOF.
+//
+// Peak memory is the maximum resident set of a child process that parses
+// every file once with one parser, next to a child that parses nothing.
+//
+// usage: parser_bench [--repeat=N] [--threads=N] file...
+#include "AstBuilder.h"
+#include "DescentParser.h"
+#include "ParallelParser.h"
+#include "Python3Parser.h"
+#include "Tokenizer.h"
+#include "antlr4-runtime.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace ast;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Python3Parser with the same SLL-then-LL strategy as the front end
+std::unique_ptr<Program> parseAntlr(const std::string& source, size_t& errors) {
+    auto program = std::make_unique<Program>();
+    TokenizerSource tokenSource(source);
+    antlr4::CommonTokenStream tokens(&tokenSource);
+    Python3Parser parser(&tokens);
+    parser.removeErrorListeners();
+    auto simulator = parser.getInterpreter<antlr4::atn::ParserATNSimulator>();
+    simulator->setPredictionMode(antlr4::atn::PredictionMode::SLL);
+    parser.setErrorHandler(std::make_shared<antlr4::BailErrorStrategy>());
+    Python3Parser::File_inputContext* tree;
+    try {
+        tree = parser.file_input();
+    } catch (const antlr4::ParseCancellationException&) {
+        parser.reset();
+        parser.setErrorHandler(std::make_shared<antlr4::DefaultErrorStrategy>());
+        simulator->setPredictionMode(antlr4::atn::PredictionMode::LL);
+        tree = parser.file_input();
+    }
+    errors = parser.getNumberOfSyntaxErrors();
+    AstBuilder(*program).build(tree);
+    return program;
+}
+
+std::unique_ptr<Program> parseDescent(const std::string& source, size_t& errors) {
+    auto program = std::make_unique<Program>();
+    std::vector<PyToken> tokens = tokenize(source);
+    DescentParser parser(tokens, *program);
+    parser.silenceErrors();
+    parser.parse();
+    errors = parser.syntaxErrors();
+    return program;
+}
+
+// As the front end does it: in parallel, or sequentially if that declines
+std::unique_ptr<Program> parseChunks(const std::string& source, unsigned threads, size_t& chunks) {
+    auto program = std::make_unique<Program>();
+    std::vector<PyToken> tokens = tokenize(source);
+    chunks = parseParallel(tokens, *program, threads);
+    if (chunks == 0) {
+        DescentParser parser(tokens, *program);
+        parser.silenceErrors();
+        parser.parse();
+    }
+    return program;
+}
+
+class Dumper {
+public:
+    explicit Dumper(const Program& program) : program(program) {}
+
+    std::string dump() {
+        block(program.body, 0);
+        return out;
+    }
+
+private:
+    const Program& program;
+    std::string out;
+
+    void line(int depth, const std::string& text) {
+        out.append(2 * depth, ' ');
+        out += text;
+        out += '\n';
+    }
+
+    std::string symbol(Symbol symbol) {
+        return symbol == NO_SYMBOL ? "_" : program.symbols.name(symbol);
+    }
+
+    std::string constant(uint32_t index) {
+        const Value& value = program.constants[index];
+        return std::to_string(static_cast<int>(value.type)) + ":" + value.toString();
+    }
+
+    std::string targets(Span<Target> list) {
+        std::string text;
+        for (const Target& target : list) text += symbol(target.name) + " ";
+        return text;
+    }
+
+    void block(Span<Stmt*> body, int depth) {
+        for (Stmt* stmt : body) statement(stmt, depth);
+    }
+
+    void statement(const Stmt* stmt, int depth) {
+        switch (stmt->kind) {
+            case StmtKind::EXPR:
+                line(depth, "expr " + expr(static_cast<const ExprStmt*>(stmt)->value));
+                break;
+            case StmtKind::ASSIGN: {
+                auto assign = static_cast<const Assign*>(stmt);
+                std::string text = "assign ";
+                for (Span<Target> list : assign->targets) text += "[" + targets(list) + "] ";
+                for (Expr* value : assign->values) text += expr(value) + " ";
+                line(depth, text);
+                break;
+            }
+            case StmtKind::AUG_ASSIGN: {
+                auto assign = static_cast<const AugAssign*>(stmt);
+                line(depth, "augassign " + std::to_string(static_cast<int>(assign->op)) + " " +
+                                    symbol(assign->target.name) + " " + expr(assign->value));
+                break;
+            }
+            case StmtKind::IF: {
+                auto ifStmt = static_cast<const If*>(stmt);
+                for (const IfBranch& branch : ifStmt->branches) {
+                    line(depth, "if " + expr(branch.condition));
+                    block(branch.body, depth + 1);
+                }
+                line(depth, "else");
+                block(ifStmt->orelse, depth + 1);
+                break;
+            }
+            case StmtKind::WHILE: {
+                auto loop = static_cast<const While*>(stmt);
+                line(depth, "while " + expr(loop->condition));
+                block(loop->body, depth + 1);
+                break;
+            }
+            case StmtKind::FUNCDEF: {
+                auto def = static_cast<const FuncDef*>(stmt);
+                std::string text = "def " + symbol(def->name) + " (";
+                for (Symbol param : def->params) text += symbol(param) + " ";
+                text += ") defaults ";
+                for (Expr* value : def->defaults) text += expr(value) + " ";
+                line(depth, text + "locals " + std::to_string(def->localCount));
+                block(def->body, depth + 1);
+                break;
+            }
+            case StmtKind::RETURN: {
+                auto ret = static_cast<const Return*>(stmt);
+                line(depth, "return " + (ret->value ? expr(ret->value) : std::string("-")));
+                break;
+            }
+            case StmtKind::BREAK: line(depth, "break"); break;
+            case StmtKind::CONTINUE: line(depth, "continue"); break;
+        }
+    }
+
+    std::string exprs(Span<Expr*> list) {
+        std::string text;
+        for (Expr* value : list) text += " " + expr(value);
+        return text;
+    }
+
+    std::string expr(const Expr* e) {
+        switch (e->kind) {
+            case ExprKind::CONSTANT: return constant(static_cast<const Constant*>(e)->index);
+            case ExprKind::NAME: return symbol(static_cast<const Name*>(e)->name);
+            case ExprKind::UNARY: {
+                auto unary = static_cast<const Unary*>(e);
+                return "(u" + std::to_string(static_cast<int>(unary->op)) + " " + expr(unary->operand) + ")";
+            }
+            case ExprKind::BINARY: {
+                auto binary = static_cast<const Binary*>(e);
+                return "(b" + std::to_string(static_cast<int>(binary->op)) + " " + expr(binary->lhs) + " " +
+                       expr(binary->rhs) + ")";
+            }
+            case ExprKind::COMPARE: {
+                auto compare = static_cast<const Compare*>(e);
+                std::string text = "(cmp";
+                for (CompareOp op : compare->ops) text += " " + std::to_string(static_cast<int>(op));
+                return text + exprs(compare->operands) + ")";
+            }
+            case ExprKind::BOOL_OP: {
+                auto boolOp = static_cast<const BoolOp*>(e);
+                return "(l" + std::to_string(static_cast<int>(boolOp->op)) + exprs(boolOp->operands) + ")";
+            }
+            case ExprKind::CALL: {
+                auto call = static_cast<const Call*>(e);
+                std::string text = "(call " + symbol(call->callee) + " " + std::to_string(static_cast<int>(call->builtin));
+                for (const Argument& arg : call->args) text += " " + symbol(arg.keyword) + "=" + expr(arg.value);
+                return text + ")";
+            }
+            case ExprKind::FORMAT: {
+                std::string text = "(f";
+                for (const FormatPart& part : static_cast<const FormatString*>(e)->parts) {
+                    text += part.literal == NO_CONSTANT ? " {" + exprs(part.values) + "}" : " " + constant(part.literal);
+                }
+                return text + ")";
+            }
+        }
+        return "?";
+    }
+};
+
+// Reports the first line in which two dumps differ
+bool sameDump(const char* path, const char* expectedName, const std::string& expectedDump, const char* actualName,
+              const std::string& actualDump) {
+    if (expectedDump == actualDump) return true;
+    size_t at = 0;
+    while (at < expectedDump.size() && at < actualDump.size() && expectedDump[at] == actualDump[at]) at++;
+    size_t lineStart = expectedDump.rfind('\n', at);
+    lineStart = lineStart == std::string::npos ? 0 : lineStart + 1;
+    auto lineAt = [&](const std::string& dump) { return dump.substr(lineStart, dump.find('\n', at) - lineStart); };
+    std::fprintf(stderr, "%s: ASTs differ\n  %-9s %s\n  %-9s %s\n", path, expectedName, lineAt(expectedDump).c_str(),
+                 actualName, lineAt(actualDump).c_str());
+    return false;
+}
+
+bool sameNumbering(const Program& expected, const Program& actual) {
+    if (expected.symbols.size() != actual.symbols.size() || expected.constants.size() != actual.constants.size()) {
+        return false;
+    }
+    for (Symbol symbol = 0; symbol < expected.symbols.size(); symbol++) {
+        if (expected.symbols.name(symbol) != actual.symbols.name(symbol)) return false;
+    }
+    for (size_t i = 0; i < expected.constants.size(); i++) {
+        if (expected.constants[i].toString() != actual.constants[i].toString()) return false;
+    }
+    return true;
+}
+
+bool checkSource(const std::string& name, const std::string& source, unsigned threads) {
+    const char* path = name.c_str();
+    size_t antlrErrors;
+    size_t descentErrors;
+    size_t chunks;
+    std::unique_ptr<Program> expected = parseAntlr(source, antlrErrors);
+    std::unique_ptr<Program> actual = parseDescent(source, descentErrors);
+    std::unique_ptr<Program> parallel = parseChunks(source, threads, chunks);
+    if (antlrErrors != descentErrors) {
+        std::fprintf(stderr, "%s: syntax errors (antlr %zu, descent %zu)\n", path, antlrErrors, descentErrors);
+        return false;
+    }
+    std::string actualDump = Dumper(*actual).dump();
+    if (!sameDump(path, "antlr:", Dumper(*expected).dump(), "descent:", actualDump)) return false;
+    if (!sameDump(path, "descent:", actualDump, "parallel:", Dumper(*parallel).dump())) return false;
+    if (!sameNumbering(*actual, *parallel)) {
+        std::fprintf(stderr, "%s: parallel parse of %zu chunks numbers symbols or constants differently\n", path,
+                     chunks);
+        return false;
+    }
+    return true;
+}
+
+bool check(const char* path, const std::string& source, unsigned threads) {
+    if (!checkSource(path, source, threads)) return false;
+    size_t last = source.find_last_not_of("\r\n");
+    if (last == std::string::npos || last + 1 == source.size()) return true;
+    return checkSource(std::string(path) + " without final newline", source.substr(0, last + 1), threads);
+}
+
+template <typename F>
+double timeRuns(int repeat, F parse) {
+    auto start = Clock::now();
+    for (int i = 0; i < repeat; i++) parse();
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Peak resident set, in KiB, of a child that runs work once
+template <typename F>
+long peakKilobytes(F work) {
+    std::fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        work();
+        _exit(0);
+    }
+    int status;
+    struct rusage usage {};
+    if (pid < 0 || wait4(pid, &status, 0, &usage) < 0) return -1;
+    return usage.ru_maxrss;
+}
+
+}// namespace
+
+int main(int argc, char** argv) {
+    int repeat = 1;
+    unsigned threads = 0;
+    std::vector<std::string> sources;
+    bool ok = true;
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "--repeat=", 9) == 0) {
+            repeat = std::max(1, std::atoi(argv[i] + 9));
+            continue;
+        }
+        if (std::strncmp(argv[i], "--threads=", 10) == 0) {
+            threads = std::max(0, std::atoi(argv[i] + 10));
+            continue;
+        }
+        std::ifstream file(argv[i], std::ios::binary);
+        if (!file) {
+            std::fprintf(stderr, "cannot read %s\n", argv[i]);
+            return 2;
+        }
+        sources.emplace_back((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        ok = check(argv[i], sources.back(), threads) && ok;
+    }
+    std::printf("%zu files, %s\n", sources.size(), ok ? "ASTs identical" : "ASTS DIFFER");
+
+    size_t bytes = 0;
+    for (const std::string& source : sources) bytes += source.size();
+    size_t errors;
+    auto antlr = [&] {
+        for (const std::string& source : sources) parseAntlr(source, errors);
+    };
+    auto descent = [&] {
+        for (const std::string& source : sources) parseDescent(source, errors);
+    };
+    size_t chunks = 0;
+    auto parallel = [&] {
+        chunks = 0;
+        for (const std::string& source : sources) {
+            size_t fileChunks;
+            parseChunks(source, threads, fileChunks);
+            chunks += fileChunks;
+        }
+    };
+    // The checks above already filled Python3Parser's DFA cache, which the
+    // children inherit along with everything else; what each parser adds
+    // over the child that does nothing is the memory its parses take
+    long baseKilobytes = peakKilobytes([] {});
+    long antlrKilobytes = peakKilobytes(antlr);
+    long descentKilobytes = peakKilobytes(descent);
+    double antlrSeconds = timeRuns(repeat, antlr);
+    double descentSeconds = timeRuns(repeat, descent);
+    double parallelSeconds = timeRuns(repeat, parallel);
+
+    double megabytes = static_cast<double>(bytes) * repeat / 1e6;
+    std::printf("%zu bytes, %d runs, tokenizing and lowering included\n", bytes, repeat);
+    std::printf("antlr parser + AstBuilder: %8.3f s, %8.2f MB/s, peak RSS %6ld KiB (+%ld)\n", antlrSeconds,
+                megabytes / antlrSeconds, antlrKilobytes, antlrKilobytes - baseKilobytes);
+    std::printf("recursive descent:         %8.3f s, %8.2f MB/s, peak RSS %6ld KiB (+%ld)\n", descentSeconds,
+                megabytes / descentSeconds, descentKilobytes, descentKilobytes - baseKilobytes);
+    std::printf("recursive descent, chunked: %7.3f s, %8.2f MB/s, %zu chunks on %u threads (0: one per core)\n",
+                parallelSeconds, megabytes / parallelSeconds, chunks, threads);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,39 @@
+#include "Ast.h"
+#include <algorithm>
+#include <iterator>
+
+namespace ast {
+
+void* Arena::allocate(size_t size, size_t align) {
+    size_t padding = (align - reinterpret_cast<uintptr_t>(cursor) % align) % align;
+    if (!cursor || padding + size > static_cast<size_t>(limit - cursor)) {
+        // Oversized requests get a block of their own
+        size_t blockSize = std::max(BLOCK_SIZE, size + align);
+        blocks.emplace_back(new char[blockSize]);
+        cursor = blocks.back().get();
+        limit = cursor + blockSize;
+        padding = (align - reinterpret_cast<uintptr_t>(cursor) % align) % align;
+    }
+    char* result = cursor + padding;
+    cursor = result + size;
+    used += size;
+    return result;
+}
+
+void Arena::absorb(Arena&& other) {
+    blocks.insert(blocks.end(), std::make_move_iterator(other.blocks.begin()),
+                  std::make_move_iterator(other.blocks.end()));
+    used += other.used;
+    other = Arena();
+}
+
+Symbol SymbolTable::intern(const std::string& name) {
+    auto it = ids.find(name);
+    if (it != ids.end()) return it->second;
+    Symbol symbol = names.size();
+    names.push_back(name);
+    ids.emplace(name, symbol);
+    return symbol;
+}
+
+}// namespace ast
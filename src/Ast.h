@@ -0,0 +1,284 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_AST_H
+#define PYTHON_INTERPRETER_AST_H
+
+#include "Builtins.h"
+#include "Value.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Compact AST the parse tree is lowered to before execution. Single-child
+// grammar chains (test -> or_test -> ... -> atom) are collapsed, literals
+// are decoded into the program's constant pool and names are interned.
+// All nodes live in one arena owned by the Program.
+namespace ast {
+
+// Bump allocator for AST nodes. Nodes are trivially destructible and are
+// released all at once together with the arena.
+class Arena {
+public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    Arena(Arena&&) = default;
+    Arena& operator=(Arena&&) = default;
+
+    template <typename T>
+    T* make() {
+        static_assert(std::is_trivially_destructible<T>::value, "arena objects are never destroyed");
+        return new (allocate(sizeof(T), alignof(T))) T();
+    }
+
+    template <typename T>
+    T* makeArray(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "arena objects are never destroyed");
+        if (count == 0) return nullptr;
+        T* items = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        for (size_t i = 0; i < count; i++) new (items + i) T();
+        return items;
+    }
+
+    size_t bytesUsed() const { return used; }
+
+    // Takes over the blocks of other, so that its objects live as long as
+    // this arena does
+    void absorb(Arena&& other);
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    void* allocate(size_t size, size_t align);
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    size_t used = 0;
+};
+
+// Fixed-size array stored in the arena
+template <typename T>
+struct Span {
+    T* data = nullptr;
+    uint32_t size = 0;
+
+    T& operator[](size_t i) const { return data[i]; }
+    T* begin() const { return data; }
+    T* end() const { return data + size; }
+    bool empty() const { return size == 0; }
+};
+
+template <typename T>
+Span<T> copyToArena(Arena& arena, const std::vector<T>& items) {
+    Span<T> span;
+    span.data = arena.makeArray<T>(items.size());
+    span.size = items.size();
+    for (size_t i = 0; i < items.size(); i++) span.data[i] = items[i];
+    return span;
+}
+
+using Symbol = uint32_t;
+constexpr Symbol NO_SYMBOL = UINT32_MAX;
+constexpr int32_t NO_SLOT = -1;
+constexpr uint32_t NO_CONSTANT = UINT32_MAX;
+
+// Interned identifiers
+class SymbolTable {
+public:
+    Symbol intern(const std::string& name);
+    const std::string& name(Symbol symbol) const { return names[symbol]; }
+    size_t size() const { return names.size(); }
+
+private:
+    std::vector<std::string> names;
+    std::unordered_map<std::string, Symbol> ids;
+};
+
+// ============ Expressions ============
+
+enum class ExprKind : uint8_t { CONSTANT, NAME, UNARY, BINARY, COMPARE, BOOL_OP, CALL, FORMAT };
+enum class UnaryOp : uint8_t { NEG, POS, NOT };
+enum class BinaryOp : uint8_t { ADD, SUB, MUL, DIV, FLOORDIV, MOD };
+enum class CompareOp : uint8_t { LT, GT, LE, GE, EQ, NE };
+enum class LogicOp : uint8_t { AND, OR };
+
+// Type every value of an expression or local is proven to have, see
+// inferTypes. ANY, the default, proves nothing.
+enum class StaticType : uint8_t { ANY, INT, FLOAT, BOOL, STR };
+
+struct Expr {
+    ExprKind kind;
+    StaticType type;
+};
+
+struct Constant : Expr {
+    static constexpr ExprKind KIND = ExprKind::CONSTANT;
+    uint32_t index;// into Program::constants
+};
+
+// Variable read. slot is the function-local slot the name resolves to, or
+// NO_SLOT when it can only name a global.
+struct Name : Expr {
+    static constexpr ExprKind KIND = ExprKind::NAME;
+    Symbol name;
+    int32_t slot;
+};
+
+struct Unary : Expr {
+    static constexpr ExprKind KIND = ExprKind::UNARY;
+    UnaryOp op;
+    Expr* operand;
+};
+
+struct Binary : Expr {
+    static constexpr ExprKind KIND = ExprKind::BINARY;
+    BinaryOp op;
+    Expr* lhs;
+    Expr* rhs;
+};
+
+// Chained comparison: operands[i] ops[i] operands[i + 1] for every i
+struct Compare : Expr {
+    static constexpr ExprKind KIND = ExprKind::COMPARE;
+    Span<Expr*> operands;
+    Span<CompareOp> ops;
+};
+
+// Short-circuit and / or over two or more operands
+struct BoolOp : Expr {
+    static constexpr ExprKind KIND = ExprKind::BOOL_OP;
+    LogicOp op;
+    Span<Expr*> operands;
+};
+
+struct Argument {
+    Symbol keyword;// NO_SYMBOL for positional arguments
+    Expr* value;
+};
+
+// Call of a named function; builtin is resolved from the name at lowering
+struct Call : Expr {
+    static constexpr ExprKind KIND = ExprKind::CALL;
+    Symbol callee;
+    Builtin builtin;
+    Span<Argument> args;
+};
+
+// f-string piece: either literal text or the values of one {testlist}
+struct FormatPart {
+    uint32_t literal;// constant index of the text, or NO_CONSTANT
+    Span<Expr*> values;
+};
+
+struct FormatString : Expr {
+    static constexpr ExprKind KIND = ExprKind::FORMAT;
+    Span<FormatPart> parts;
+};
+
+// ============ Statements ============
+
+enum class StmtKind : uint8_t { EXPR, ASSIGN, AUG_ASSIGN, IF, WHILE, FUNCDEF, RETURN, BREAK, CONTINUE };
+
+struct Stmt {
+    StmtKind kind;
+};
+
+struct ExprStmt : Stmt {
+    static constexpr StmtKind KIND = StmtKind::EXPR;
+    Expr* value;
+};
+
+// Assignment target; name is NO_SYMBOL when the target expression is not a
+// plain name, in which case the store is skipped
+struct Target {
+    Symbol name;
+    int32_t slot;
+};
+
+// targets[0] = targets[1] = ... = values. A target list matching the number
+// of values is unpacked pairwise; a single target takes the first value.
+struct Assign : Stmt {
+    static constexpr StmtKind KIND = StmtKind::ASSIGN;
+    Span<Span<Target>> targets;
+    Span<Expr*> values;
+};
+
+struct AugAssign : Stmt {
+    static constexpr StmtKind KIND = StmtKind::AUG_ASSIGN;
+    BinaryOp op;
+    Target target;
+    Expr* value;
+};
+
+struct IfBranch {
+    Expr* condition;
+    Span<Stmt*> body;
+};
+
+struct If : Stmt {
+    static constexpr StmtKind KIND = StmtKind::IF;
+    Span<IfBranch> branches;
+    Span<Stmt*> orelse;
+};
+
+struct While : Stmt {
+    static constexpr StmtKind KIND = StmtKind::WHILE;
+    Expr* condition;
+    Span<Stmt*> body;
+};
+
+// Function definition. Parameters occupy local slots 0..params.size - 1;
+// defaults belong to the last defaults.size parameters.
+struct FuncDef : Stmt {
+    static constexpr StmtKind KIND = StmtKind::FUNCDEF;
+    Symbol name;
+    Span<Symbol> params;
+    Span<Expr*> defaults;
+    Span<Stmt*> body;
+    uint32_t localCount;
+    Span<StaticType> localTypes;// by slot; empty unless some local has a type
+    uint32_t lazyBody;// token index of a body that is not parsed yet, see LazyProgram; 0 once it is
+};
+
+struct Return : Stmt {
+    static constexpr StmtKind KIND = StmtKind::RETURN;
+    Expr* value;// nullptr for a bare return
+    bool selfCall;// value calls the enclosing function by name: return f(...)
+};
+
+struct Break : Stmt {
+    static constexpr StmtKind KIND = StmtKind::BREAK;
+};
+
+struct Continue : Stmt {
+    static constexpr StmtKind KIND = StmtKind::CONTINUE;
+};
+
+// A lowered program together with everything its nodes refer to
+struct Program {
+    Arena arena;
+    SymbolTable symbols;
+    std::vector<Value> constants;
+    Span<Stmt*> body;
+
+    template <typename T>
+    T* make() {
+        T* node = arena.make<T>();
+        node->kind = T::KIND;
+        return node;
+    }
+
+    uint32_t addConstant(const Value& value) {
+        constants.push_back(value);
+        return constants.size() - 1;
+    }
+};
+
+}// namespace ast
+
+#endif//PYTHON_INTERPRETER_AST_H
@@ -0,0 +1,451 @@
+#include "AstBuilder.h"
+
+using namespace ast;
+
+namespace {
+
+// After a syntax error the parser recovers by leaving children out, or by
+// conjuring missing tokens as error nodes. Lowering drops whatever such a
+// child belongs to: an expression with a missing part lowers to nullptr,
+// and so does the statement holding it.
+bool present(antlr4::tree::TerminalNode* node) {
+    return node && !dynamic_cast<antlr4::tree::ErrorNode*>(node);
+}
+
+// Token type of the single operator token wrapped by an *_op rule, or
+// INVALID_TYPE if recovery left it out
+size_t opToken(antlr4::ParserRuleContext* ctx) {
+    auto terminal = ctx->children.empty() ? nullptr : dynamic_cast<antlr4::tree::TerminalNode*>(ctx->children[0]);
+    return present(terminal) ? terminal->getSymbol()->getType() : antlr4::Token::INVALID_TYPE;
+}
+
+BinaryOp binaryOp(size_t tokenType) {
+    switch (tokenType) {
+        case Python3Parser::ADD:
+        case Python3Parser::ADD_ASSIGN: return BinaryOp::ADD;
+        case Python3Parser::MINUS:
+        case Python3Parser::SUB_ASSIGN: return BinaryOp::SUB;
+        case Python3Parser::STAR:
+        case Python3Parser::MULT_ASSIGN: return BinaryOp::MUL;
+        case Python3Parser::DIV:
+        case Python3Parser::DIV_ASSIGN: return BinaryOp::DIV;
+        case Python3Parser::IDIV:
+        case Python3Parser::IDIV_ASSIGN: return BinaryOp::FLOORDIV;
+        default: return BinaryOp::MOD;
+    }
+}
+
+CompareOp compareOp(size_t tokenType) {
+    switch (tokenType) {
+        case Python3Parser::LESS_THAN: return CompareOp::LT;
+        case Python3Parser::GREATER_THAN: return CompareOp::GT;
+        case Python3Parser::LT_EQ: return CompareOp::LE;
+        case Python3Parser::GT_EQ: return CompareOp::GE;
+        case Python3Parser::EQUALS: return CompareOp::EQ;
+        default: return CompareOp::NE;
+    }
+}
+
+}// namespace
+
+void AstBuilder::build(Python3Parser::File_inputContext* ctx) {
+    std::vector<Stmt*> body;
+    if (ctx) {
+        for (auto stmt : ctx->stmt()) {
+            lowerStmt(stmt, body);
+        }
+    }
+    program.body = copyToArena(program.arena, body);
+}
+
+Span<Stmt*> AstBuilder::lowerSuite(Python3Parser::SuiteContext* ctx) {
+    std::vector<Stmt*> body;
+    if (ctx->simple_stmt()) {
+        if (Stmt* stmt = lowerSmallStmt(ctx->simple_stmt()->small_stmt())) {
+            body.push_back(stmt);
+        }
+    } else {
+        for (auto stmt : ctx->stmt()) {
+            lowerStmt(stmt, body);
+        }
+    }
+    return copyToArena(program.arena, body);
+}
+
+void AstBuilder::lowerStmt(Python3Parser::StmtContext* ctx, std::vector<Stmt*>& out) {
+    Stmt* stmt = nullptr;
+    if (ctx->simple_stmt()) {
+        stmt = lowerSmallStmt(ctx->simple_stmt()->small_stmt());
+    } else if (auto compound = ctx->compound_stmt()) {
+        if (compound->if_stmt()) stmt = lowerIf(compound->if_stmt());
+        else if (compound->while_stmt()) stmt = lowerWhile(compound->while_stmt());
+        else if (compound->funcdef()) stmt = lowerFuncdef(compound->funcdef());
+    }
+    if (stmt) out.push_back(stmt);
+}
+
+Stmt* AstBuilder::lowerSmallStmt(Python3Parser::Small_stmtContext* ctx) {
+    if (!ctx) return nullptr;
+    if (ctx->expr_stmt()) return lowerExprStmt(ctx->expr_stmt());
+    if (ctx->flow_stmt()) return lowerFlowStmt(ctx->flow_stmt());
+    return nullptr;
+}
+
+Stmt* AstBuilder::lowerExprStmt(Python3Parser::Expr_stmtContext* ctx) {
+    auto testlists = ctx->testlist();
+    if (testlists.empty()) return nullptr;
+
+    if (testlists.size() == 1) {
+        // Plain expression; like a testlist anywhere else it yields its first test
+        Expr* value = lowerTest(testlists[0]->test(0));
+        if (!value) return nullptr;
+        auto stmt = program.make<ExprStmt>();
+        stmt->value = value;
+        return stmt;
+    }
+
+    if (ctx->augassign()) {
+        // Only a single plain name can be augmented; anything else is a no-op
+        auto lhs = testlists[0]->test();
+        Symbol name = lhs.size() == 1 ? targetName(lhs[0], program.symbols) : NO_SYMBOL;
+        size_t op = opToken(ctx->augassign());
+        Expr* value = lowerTest(testlists[1]->test(0));
+        if (name == NO_SYMBOL || op == antlr4::Token::INVALID_TYPE || !value) return nullptr;
+
+        auto stmt = program.make<AugAssign>();
+        stmt->op = binaryOp(op);
+        stmt->target = Target{name, NO_SLOT};
+        stmt->value = value;
+        return stmt;
+    }
+
+    std::vector<Span<Target>> targets;
+    for (size_t i = 0; i + 1 < testlists.size(); i++) {
+        targets.push_back(lowerTargets(testlists[i]));
+    }
+    Span<Expr*> values = lowerTestlist(testlists.back());
+    if (values.empty()) return nullptr;
+    auto stmt = program.make<Assign>();
+    stmt->targets = copyToArena(program.arena, targets);
+    stmt->values = values;
+    return stmt;
+}
+
+Stmt* AstBuilder::lowerFlowStmt(Python3Parser::Flow_stmtContext* ctx) {
+    if (ctx->break_stmt()) return program.make<Break>();
+    if (ctx->continue_stmt()) return program.make<Continue>();
+    if (!ctx->return_stmt()) return nullptr;
+
+    auto testlist = ctx->return_stmt()->testlist();
+    Expr* value = testlist ? lowerTest(testlist->test(0)) : nullptr;
+    if (testlist && !value) return nullptr;
+    auto stmt = program.make<Return>();
+    stmt->value = value;
+    return stmt;
+}
+
+Stmt* AstBuilder::lowerIf(Python3Parser::If_stmtContext* ctx) {
+    auto tests = ctx->test();
+    auto suites = ctx->suite();
+
+    // A branch cut short by an error ends the statement there, like in the
+    // visitor, which pairs up tests and suites as far as they go
+    std::vector<IfBranch> branches;
+    bool complete = suites.size() >= tests.size();
+    for (size_t i = 0; i < tests.size() && i < suites.size(); i++) {
+        Expr* condition = lowerTest(tests[i]);
+        if (!condition) {
+            complete = false;
+            break;
+        }
+        branches.push_back(IfBranch{condition, lowerSuite(suites[i])});
+    }
+    if (branches.empty()) return nullptr;
+    auto stmt = program.make<If>();
+    stmt->branches = copyToArena(program.arena, branches);
+    if (complete && suites.size() > tests.size()) {
+        stmt->orelse = lowerSuite(suites.back());
+    }
+    return stmt;
+}
+
+Stmt* AstBuilder::lowerWhile(Python3Parser::While_stmtContext* ctx) {
+    Expr* condition = lowerTest(ctx->test());
+    if (!condition || !ctx->suite()) return nullptr;
+    auto stmt = program.make<While>();
+    stmt->condition = condition;
+    stmt->body = lowerSuite(ctx->suite());
+    return stmt;
+}
+
+Stmt* AstBuilder::lowerFuncdef(Python3Parser::FuncdefContext* ctx) {
+    if (!present(ctx->NAME()) || !ctx->parameters() || !ctx->suite()) return nullptr;
+    std::vector<Symbol> params;
+    std::vector<Expr*> defaults;
+    if (auto args = ctx->parameters()->typedargslist()) {
+        for (auto tfpdef : args->tfpdef()) {
+            if (!present(tfpdef->NAME())) return nullptr;
+            params.push_back(program.symbols.intern(tfpdef->NAME()->getText()));
+        }
+        for (auto test : args->test()) {
+            Expr* value = lowerTest(test);
+            if (!value) return nullptr;
+            defaults.push_back(value);
+        }
+        if (defaults.size() > params.size()) return nullptr;
+    }
+
+    auto stmt = program.make<FuncDef>();
+    stmt->name = program.symbols.intern(ctx->NAME()->getText());
+    stmt->params = copyToArena(program.arena, params);
+    stmt->defaults = copyToArena(program.arena, defaults);
+    stmt->body = lowerSuite(ctx->suite());
+    stmt->localCount = params.size();
+    return stmt;
+}
+
+Span<Target> AstBuilder::lowerTargets(Python3Parser::TestlistContext* ctx) {
+    std::vector<Target> targets;
+    for (auto test : ctx->test()) {
+        targets.push_back(Target{targetName(test, program.symbols), NO_SLOT});
+    }
+    return copyToArena(program.arena, targets);
+}
+
+// Empty if some test can not be lowered; a testlist has at least one
+Span<Expr*> AstBuilder::lowerTestlist(Python3Parser::TestlistContext* ctx) {
+    std::vector<Expr*> values;
+    for (auto test : ctx->test()) {
+        Expr* value = lowerTest(test);
+        if (!value) return {};
+        values.push_back(value);
+    }
+    return copyToArena(program.arena, values);
+}
+
+Expr* AstBuilder::lowerTest(Python3Parser::TestContext* ctx) {
+    if (!ctx || !ctx->or_test()) return nullptr;
+    return lowerOrTest(ctx->or_test());
+}
+
+Expr* AstBuilder::lowerOrTest(Python3Parser::Or_testContext* ctx) {
+    auto operands = ctx->and_test();
+    if (operands.empty()) return nullptr;
+    if (operands.size() == 1) return lowerAndTest(operands[0]);
+
+    std::vector<Expr*> lowered;
+    for (auto operand : operands) {
+        Expr* value = lowerAndTest(operand);
+        if (!value) return nullptr;
+        lowered.push_back(value);
+    }
+    auto expr = program.make<BoolOp>();
+    expr->op = LogicOp::OR;
+    expr->operands = copyToArena(program.arena, lowered);
+    return expr;
+}
+
+Expr* AstBuilder::lowerAndTest(Python3Parser::And_testContext* ctx) {
+    auto operands = ctx->not_test();
+    if (operands.empty()) return nullptr;
+    if (operands.size() == 1) return lowerNotTest(operands[0]);
+
+    std::vector<Expr*> lowered;
+    for (auto operand : operands) {
+        Expr* value = lowerNotTest(operand);
+        if (!value) return nullptr;
+        lowered.push_back(value);
+    }
+    auto expr = program.make<BoolOp>();
+    expr->op = LogicOp::AND;
+    expr->operands = copyToArena(program.arena, lowered);
+    return expr;
+}
+
+Expr* AstBuilder::lowerNotTest(Python3Parser::Not_testContext* ctx) {
+    if (ctx->not_test()) {
+        Expr* operand = lowerNotTest(ctx->not_test());
+        if (!operand) return nullptr;
+        auto expr = program.make<Unary>();
+        expr->op = UnaryOp::NOT;
+        expr->operand = operand;
+        return expr;
+    }
+    return ctx->comparison() ? lowerComparison(ctx->comparison()) : nullptr;
+}
+
+Expr* AstBuilder::lowerComparison(Python3Parser::ComparisonContext* ctx) {
+    auto operands = ctx->arith_expr();
+    auto compOps = ctx->comp_op();
+    if (operands.empty() || compOps.size() + 1 != operands.size()) return nullptr;
+    if (operands.size() == 1) return lowerArithExpr(operands[0]);
+
+    std::vector<Expr*> lowered;
+    std::vector<CompareOp> ops;
+    for (auto operand : operands) {
+        Expr* value = lowerArithExpr(operand);
+        if (!value) return nullptr;
+        lowered.push_back(value);
+    }
+    for (auto op : compOps) {
+        size_t token = opToken(op);
+        if (token == antlr4::Token::INVALID_TYPE) return nullptr;
+        ops.push_back(compareOp(token));
+    }
+    auto expr = program.make<Compare>();
+    expr->operands = copyToArena(program.arena, lowered);
+    expr->ops = copyToArena(program.arena, ops);
+    return expr;
+}
+
+Expr* AstBuilder::lowerArithExpr(Python3Parser::Arith_exprContext* ctx) {
+    auto terms = ctx->term();
+    auto ops = ctx->addorsub_op();
+    if (terms.empty() || ops.size() + 1 != terms.size()) return nullptr;
+    Expr* result = lowerTerm(terms[0]);
+    for (size_t i = 0; result && i < ops.size(); i++) {
+        size_t op = opToken(ops[i]);
+        Expr* rhs = lowerTerm(terms[i + 1]);
+        if (op == antlr4::Token::INVALID_TYPE || !rhs) return nullptr;
+        auto expr = program.make<Binary>();
+        expr->op = binaryOp(op);
+        expr->lhs = result;
+        expr->rhs = rhs;
+        result = expr;
+    }
+    return result;
+}
+
+Expr* AstBuilder::lowerTerm(Python3Parser::TermContext* ctx) {
+    auto factors = ctx->factor();
+    auto ops = ctx->muldivmod_op();
+    if (factors.empty() || ops.size() + 1 != factors.size()) return nullptr;
+    Expr* result = lowerFactor(factors[0]);
+    for (size_t i = 0; result && i < ops.size(); i++) {
+        size_t op = opToken(ops[i]);
+        Expr* rhs = lowerFactor(factors[i + 1]);
+        if (op == antlr4::Token::INVALID_TYPE || !rhs) return nullptr;
+        auto expr = program.make<Binary>();
+        expr->op = binaryOp(op);
+        expr->lhs = result;
+        expr->rhs = rhs;
+        result = expr;
+    }
+    return result;
+}
+
+Expr* AstBuilder::lowerFactor(Python3Parser::FactorContext* ctx) {
+    if (!ctx->factor()) return ctx->atom_expr() ? lowerAtomExpr(ctx->atom_expr()) : nullptr;
+
+    // Unary plus leaves its operand untouched, so only minus needs a node
+    Expr* operand = lowerFactor(ctx->factor());
+    size_t op = opToken(ctx);
+    if (!operand || op == antlr4::Token::INVALID_TYPE) return nullptr;
+    if (op != Python3Parser::MINUS) return operand;
+    auto expr = program.make<Unary>();
+    expr->op = UnaryOp::NEG;
+    expr->operand = operand;
+    return expr;
+}
+
+Expr* AstBuilder::lowerAtomExpr(Python3Parser::Atom_exprContext* ctx) {
+    if (!ctx->atom()) return nullptr;
+    if (!ctx->trailer()) return lowerAtom(ctx->atom());
+
+    // Only plain names can be called; anything else evaluates to None
+    if (!present(ctx->atom()->NAME())) return makeConstant(Value());
+
+    std::string name = ctx->atom()->NAME()->getText();
+    std::vector<Argument> args;
+    if (auto arglist = ctx->trailer()->arglist()) {
+        for (auto arg : arglist->argument()) {
+            auto tests = arg->test();
+            Expr* value = tests.empty() ? nullptr : lowerTest(tests.back());
+            if (!value) return nullptr;
+            Symbol keyword = tests.size() == 2 ? program.symbols.intern(tests[0]->getText()) : NO_SYMBOL;
+            args.push_back(Argument{keyword, value});
+        }
+    }
+    auto expr = program.make<Call>();
+    expr->callee = program.symbols.intern(name);
+    expr->builtin = lookupBuiltin(name);
+    expr->args = copyToArena(program.arena, args);
+    return expr;
+}
+
+Expr* AstBuilder::lowerAtom(Python3Parser::AtomContext* ctx) {
+    if (ctx->NAME()) {
+        if (!present(ctx->NAME())) return nullptr;
+        auto expr = program.make<Name>();
+        expr->name = program.symbols.intern(ctx->NAME()->getText());
+        expr->slot = NO_SLOT;
+        return expr;
+    }
+    if (ctx->NUMBER()) {
+        if (!present(ctx->NUMBER())) return nullptr;
+        std::string num = ctx->NUMBER()->getText();
+        if (num.find('.') != std::string::npos) {
+            return makeConstant(Value(std::stod(num)));
+        }
+        return makeConstant(Value(BigInt(num)));
+    }
+    if (!ctx->STRING().empty()) {
+        std::string result;
+        for (auto str : ctx->STRING()) {
+            if (!present(str)) return nullptr;
+            result += decodeStringLiteral(str->getText());
+        }
+        return makeConstant(Value(result));
+    }
+    if (ctx->NONE()) return makeConstant(Value());
+    if (ctx->TRUE()) return makeConstant(Value(true));
+    if (ctx->FALSE()) return makeConstant(Value(false));
+    if (ctx->test()) return lowerTest(ctx->test());
+    return ctx->format_string() ? lowerFormatString(ctx->format_string()) : nullptr;
+}
+
+Expr* AstBuilder::lowerFormatString(Python3Parser::Format_stringContext* ctx) {
+    std::vector<FormatPart> parts;
+    for (auto child : ctx->children) {
+        if (auto terminal = dynamic_cast<antlr4::tree::TerminalNode*>(child)) {
+            // Quotation marks and braces only delimit the parts
+            size_t type = terminal->getSymbol()->getType();
+            if (type != Python3Parser::FORMAT_STRING_LITERAL) continue;
+            parts.push_back(FormatPart{program.addConstant(Value(terminal->getText())), {}});
+        } else if (auto testlist = dynamic_cast<Python3Parser::TestlistContext*>(child)) {
+            Span<Expr*> values = lowerTestlist(testlist);
+            if (values.empty()) return nullptr;
+            parts.push_back(FormatPart{NO_CONSTANT, values});
+        }
+    }
+    auto expr = program.make<FormatString>();
+    expr->parts = copyToArena(program.arena, parts);
+    return expr;
+}
+
+Expr* AstBuilder::makeConstant(const Value& value) {
+    auto expr = program.make<Constant>();
+    expr->index = program.addConstant(value);
+    return expr;
+}
+
+Symbol AstBuilder::targetName(Python3Parser::TestContext* test, SymbolTable& symbols) {
+    // A target must reduce to a NAME atom through single-child rules
+    auto orTest = test->or_test();
+    if (!orTest || orTest->and_test().size() != 1 || orTest->and_test(0)->not_test().size() != 1) {
+        return NO_SYMBOL;
+    }
+    auto comparison = orTest->and_test(0)->not_test(0)->comparison();
+    if (!comparison || comparison->arith_expr().size() != 1) {
+        return NO_SYMBOL;
+    }
+    auto arith = comparison->arith_expr(0);
+    if (arith->term().size() != 1 || arith->term(0)->factor().size() != 1) {
+        return NO_SYMBOL;
+    }
+    auto atomExpr = arith->term(0)->factor(0)->atom_expr();
+    if (!atomExpr || atomExpr->trailer() || !atomExpr->atom() || !present(atomExpr->atom()->NAME())) {
+        return NO_SYMBOL;
+    }
+    return symbols.intern(atomExpr->atom()->NAME()->getText());
+}
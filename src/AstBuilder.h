@@ -0,0 +1,49 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_ASTBUILDER_H
+#define PYTHON_INTERPRETER_ASTBUILDER_H
+
+#include "Ast.h"
+#include "Python3Parser.h"
+#include <vector>
+
+// Lowers an ANTLR parse tree into the compact AST. The resulting program
+// holds no references into the parse tree, so the tree and its token
+// stream can be released as soon as lowering is done.
+class AstBuilder {
+public:
+    explicit AstBuilder(ast::Program& program) : program(program) {}
+
+    void build(Python3Parser::File_inputContext* ctx);
+
+private:
+    ast::Program& program;
+
+    ast::Span<ast::Stmt*> lowerSuite(Python3Parser::SuiteContext* ctx);
+    void lowerStmt(Python3Parser::StmtContext* ctx, std::vector<ast::Stmt*>& out);
+    ast::Stmt* lowerSmallStmt(Python3Parser::Small_stmtContext* ctx);
+    ast::Stmt* lowerExprStmt(Python3Parser::Expr_stmtContext* ctx);
+    ast::Stmt* lowerFlowStmt(Python3Parser::Flow_stmtContext* ctx);
+    ast::Stmt* lowerIf(Python3Parser::If_stmtContext* ctx);
+    ast::Stmt* lowerWhile(Python3Parser::While_stmtContext* ctx);
+    ast::Stmt* lowerFuncdef(Python3Parser::FuncdefContext* ctx);
+
+    ast::Span<ast::Target> lowerTargets(Python3Parser::TestlistContext* ctx);
+    ast::Span<ast::Expr*> lowerTestlist(Python3Parser::TestlistContext* ctx);
+
+    ast::Expr* lowerTest(Python3Parser::TestContext* ctx);
+    ast::Expr* lowerOrTest(Python3Parser::Or_testContext* ctx);
+    ast::Expr* lowerAndTest(Python3Parser::And_testContext* ctx);
+    ast::Expr* lowerNotTest(Python3Parser::Not_testContext* ctx);
+    ast::Expr* lowerComparison(Python3Parser::ComparisonContext* ctx);
+    ast::Expr* lowerArithExpr(Python3Parser::Arith_exprContext* ctx);
+    ast::Expr* lowerTerm(Python3Parser::TermContext* ctx);
+    ast::Expr* lowerFactor(Python3Parser::FactorContext* ctx);
+    ast::Expr* lowerAtomExpr(Python3Parser::Atom_exprContext* ctx);
+    ast::Expr* lowerAtom(Python3Parser::AtomContext* ctx);
+    ast::Expr* lowerFormatString(Python3Parser::Format_stringContext* ctx);
+
+    ast::Expr* makeConstant(const Value& value);
+    static ast::Symbol targetName(Python3Parser::TestContext* test, ast::SymbolTable& symbols);
+};
+
+#endif//PYTHON_INTERPRETER_ASTBUILDER_H
@@ -0,0 +1,40 @@
+#include "Builtins.h"
+#include <iostream>
+
+Builtin lookupBuiltin(const std::string& name) {
+    if (name == "print") return Builtin::PRINT;
+    if (name == "int") return Builtin::INT;
+    if (name == "float") return Builtin::FLOAT;
+    if (name == "str") return Builtin::STR;
+    if (name == "bool") return Builtin::BOOL;
+    return Builtin::NONE;
+}
+
+Value invokeBuiltin(Builtin builtin, const Value* args, size_t count) {
+    if (builtin == Builtin::PRINT) {
+        for (size_t i = 0; i < count; i++) {
+            if (i > 0) std::cout << " ";
+            std::cout << args[i].toString();
+        }
+        std::cout << std::endl;
+        return Value();
+    }
+    
+    // Type conversions take a single argument
+    if (count > 0) {
+        switch (builtin) {
+            case Builtin::INT: return args[0].toInt();
+            case Builtin::FLOAT: return args[0].toFloat();
+            case Builtin::STR: return args[0].toStr();
+            case Builtin::BOOL: return Value(args[0].toBool());
+            default: break;
+        }
+    }
+    switch (builtin) {
+        case Builtin::INT: return Value(BigInt(0));
+        case Builtin::FLOAT: return Value(0.0);
+        case Builtin::STR: return Value("");
+        case Builtin::BOOL: return Value(false);
+        default: return Value();
+    }
+}
@@ -0,0 +1,16 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_BUILTINS_H
+#define PYTHON_INTERPRETER_BUILTINS_H
+
+#include "Value.h"
+#include <string>
+
+// Built-in functions, resolved by name once per call site
+enum class Builtin { NONE, PRINT, INT, FLOAT, STR, BOOL };
+
+Builtin lookupBuiltin(const std::string& name);
+
+// Calls a builtin on arguments that have already been evaluated
+Value invokeBuiltin(Builtin builtin, const Value* args, size_t count);
+
+#endif//PYTHON_INTERPRETER_BUILTINS_H
@@ -0,0 +1,178 @@
+#include "Bytecode.h"
+#include <iomanip>
+
+const char* opcodeName(Opcode op) {
+    switch (op) {
+        case Opcode::LOADK: return "LOADK";
+        case Opcode::MOVE: return "MOVE";
+        case Opcode::GETGLOBAL: return "GETGLOBAL";
+        case Opcode::SETGLOBAL: return "SETGLOBAL";
+        case Opcode::GETNAME: return "GETNAME";
+        case Opcode::SETNAME: return "SETNAME";
+        case Opcode::ADD: return "ADD";
+        case Opcode::SUB: return "SUB";
+        case Opcode::MUL: return "MUL";
+        case Opcode::DIV: return "DIV";
+        case Opcode::FLOORDIV: return "FLOORDIV";
+        case Opcode::MOD: return "MOD";
+        case Opcode::NEG: return "NEG";
+        case Opcode::NOT: return "NOT";
+        case Opcode::LT: return "LT";
+        case Opcode::GT: return "GT";
+        case Opcode::LE: return "LE";
+        case Opcode::GE: return "GE";
+        case Opcode::EQ: return "EQ";
+        case Opcode::NE: return "NE";
+        case Opcode::JUMP: return "JUMP";
+        case Opcode::JUMPIF: return "JUMPIF";
+        case Opcode::JUMPIFNOT: return "JUMPIFNOT";
+        case Opcode::CALL: return "CALL";
+        case Opcode::BUILTIN: return "BUILTIN";
+        case Opcode::FORMAT: return "FORMAT";
+        case Opcode::DEFINE: return "DEFINE";
+        case Opcode::LOOP: return "LOOP";
+        case Opcode::TAILCALL: return "TAILCALL";
+        case Opcode::RETURN: return "RETURN";
+        case Opcode::ADD_INT: return "ADD_INT";
+        case Opcode::SUB_INT: return "SUB_INT";
+        case Opcode::MUL_INT: return "MUL_INT";
+        case Opcode::FLOORDIV_INT: return "FLOORDIV_INT";
+        case Opcode::MOD_INT: return "MOD_INT";
+        case Opcode::ADD_FLOAT: return "ADD_FLOAT";
+        case Opcode::SUB_FLOAT: return "SUB_FLOAT";
+        case Opcode::MUL_FLOAT: return "MUL_FLOAT";
+        case Opcode::DIV_FLOAT: return "DIV_FLOAT";
+        case Opcode::ADD_STR: return "ADD_STR";
+        case Opcode::LT_INT: return "LT_INT";
+        case Opcode::GT_INT: return "GT_INT";
+        case Opcode::LE_INT: return "LE_INT";
+        case Opcode::GE_INT: return "GE_INT";
+        case Opcode::EQ_INT: return "EQ_INT";
+        case Opcode::NE_INT: return "NE_INT";
+        case Opcode::LOADK_ADD: return "LOADK_ADD";
+        case Opcode::LOADK_SUB: return "LOADK_SUB";
+        case Opcode::LOADK_MOD: return "LOADK_MOD";
+        case Opcode::LT_JUMPIFNOT: return "LT_JUMPIFNOT";
+        case Opcode::GT_JUMPIFNOT: return "GT_JUMPIFNOT";
+        case Opcode::LE_JUMPIFNOT: return "LE_JUMPIFNOT";
+        case Opcode::GE_JUMPIFNOT: return "GE_JUMPIFNOT";
+        case Opcode::EQ_JUMPIFNOT: return "EQ_JUMPIFNOT";
+        case Opcode::NE_JUMPIFNOT: return "NE_JUMPIFNOT";
+        case Opcode::LOADK_LT_JUMPIFNOT: return "LOADK_LT_JUMPIFNOT";
+        case Opcode::LOADK_GT_JUMPIFNOT: return "LOADK_GT_JUMPIFNOT";
+        case Opcode::LOADK_LE_JUMPIFNOT: return "LOADK_LE_JUMPIFNOT";
+        case Opcode::LOADK_GE_JUMPIFNOT: return "LOADK_GE_JUMPIFNOT";
+        case Opcode::LOADK_EQ_JUMPIFNOT: return "LOADK_EQ_JUMPIFNOT";
+        case Opcode::LOADK_NE_JUMPIFNOT: return "LOADK_NE_JUMPIFNOT";
+    }
+    return "?";
+}
+
+Opcode genericOpcode(Opcode op) {
+    switch (op) {
+        case Opcode::ADD_INT:
+        case Opcode::ADD_FLOAT:
+        case Opcode::ADD_STR: return Opcode::ADD;
+        case Opcode::SUB_INT:
+        case Opcode::SUB_FLOAT: return Opcode::SUB;
+        case Opcode::MUL_INT:
+        case Opcode::MUL_FLOAT: return Opcode::MUL;
+        case Opcode::DIV_FLOAT: return Opcode::DIV;
+        case Opcode::FLOORDIV_INT: return Opcode::FLOORDIV;
+        case Opcode::MOD_INT: return Opcode::MOD;
+        case Opcode::LT_INT: return Opcode::LT;
+        case Opcode::GT_INT: return Opcode::GT;
+        case Opcode::LE_INT: return Opcode::LE;
+        case Opcode::GE_INT: return Opcode::GE;
+        case Opcode::EQ_INT: return Opcode::EQ;
+        case Opcode::NE_INT: return Opcode::NE;
+        case Opcode::LOADK_ADD:
+        case Opcode::LOADK_SUB:
+        case Opcode::LOADK_MOD:
+        case Opcode::LOADK_LT_JUMPIFNOT:
+        case Opcode::LOADK_GT_JUMPIFNOT:
+        case Opcode::LOADK_LE_JUMPIFNOT:
+        case Opcode::LOADK_GE_JUMPIFNOT:
+        case Opcode::LOADK_EQ_JUMPIFNOT:
+        case Opcode::LOADK_NE_JUMPIFNOT: return Opcode::LOADK;
+        case Opcode::LT_JUMPIFNOT: return Opcode::LT;
+        case Opcode::GT_JUMPIFNOT: return Opcode::GT;
+        case Opcode::LE_JUMPIFNOT: return Opcode::LE;
+        case Opcode::GE_JUMPIFNOT: return Opcode::GE;
+        case Opcode::EQ_JUMPIFNOT: return Opcode::EQ;
+        case Opcode::NE_JUMPIFNOT: return Opcode::NE;
+        default: return op;
+    }
+}
+
+namespace {
+
+// The compare-and-branch superinstruction for a comparison, or op itself
+Opcode branchingCompare(Opcode op) {
+    switch (op) {
+        case Opcode::LT: return Opcode::LT_JUMPIFNOT;
+        case Opcode::GT: return Opcode::GT_JUMPIFNOT;
+        case Opcode::LE: return Opcode::LE_JUMPIFNOT;
+        case Opcode::GE: return Opcode::GE_JUMPIFNOT;
+        case Opcode::EQ: return Opcode::EQ_JUMPIFNOT;
+        case Opcode::NE: return Opcode::NE_JUMPIFNOT;
+        default: return op;
+    }
+}
+
+// The same with a constant loaded first
+Opcode loadingCompare(Opcode op) {
+    switch (op) {
+        case Opcode::LT_JUMPIFNOT: return Opcode::LOADK_LT_JUMPIFNOT;
+        case Opcode::GT_JUMPIFNOT: return Opcode::LOADK_GT_JUMPIFNOT;
+        case Opcode::LE_JUMPIFNOT: return Opcode::LOADK_LE_JUMPIFNOT;
+        case Opcode::GE_JUMPIFNOT: return Opcode::LOADK_GE_JUMPIFNOT;
+        case Opcode::EQ_JUMPIFNOT: return Opcode::LOADK_EQ_JUMPIFNOT;
+        case Opcode::NE_JUMPIFNOT: return Opcode::LOADK_NE_JUMPIFNOT;
+        default: return op;
+    }
+}
+
+}// namespace
+
+// Fuses back to front so that a LOADK sees whether the comparison after
+// it has already become a compare-and-branch
+void fuseSuperinstructions(FunctionProto& proto) {
+    std::vector<Instr>& code = proto.code;
+    for (size_t i = code.size(); i-- > 1;) {
+        Instr& first = code[i - 1];
+        const Instr& next = code[i];
+        if (first.op == Opcode::LOADK) {
+            switch (next.op) {
+                case Opcode::ADD: first.op = Opcode::LOADK_ADD; break;
+                case Opcode::SUB: first.op = Opcode::LOADK_SUB; break;
+                case Opcode::MOD: first.op = Opcode::LOADK_MOD; break;
+                default:
+                    if (loadingCompare(next.op) != next.op) first.op = loadingCompare(next.op);
+                    break;
+            }
+        } else if (next.op == Opcode::JUMPIFNOT && next.a == first.a) {
+            first.op = branchingCompare(first.op);
+        }
+    }
+}
+
+void disassemble(const BytecodeProgram& program, std::ostream& out) {
+    for (size_t f = 0; f < program.functions.size(); f++) {
+        const FunctionProto& proto = *program.functions[f];
+        const std::string& name = proto.name == ast::NO_SYMBOL ? "<module>" : program.symbols->name(proto.name);
+        out << "function " << f << " " << name << " locals=" << proto.localCount
+            << " frame=" << proto.frameSize << "\n";
+        for (size_t pc = 0; pc < proto.code.size(); pc++) {
+            const Instr& in = proto.code[pc];
+            out << "  " << std::setw(4) << pc << "  " << std::left << std::setw(18) << opcodeName(in.op)
+                << std::right << " " << in.a << " " << in.b << " " << in.c << " " << in.d;
+            if (genericOpcode(in.op) == Opcode::LOADK) out << "  ; " << program.constants[in.d].toString();
+            if (in.op == Opcode::GETGLOBAL || in.op == Opcode::SETGLOBAL || in.op == Opcode::GETNAME
+                || in.op == Opcode::SETNAME) {
+                out << "  ; " << program.symbols->name(in.d);
+            }
+            out << "\n";
+        }
+    }
+}
@@ -0,0 +1,147 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_BYTECODE_H
+#define PYTHON_INTERPRETER_BYTECODE_H
+
+#include "Ast.h"
+#include "Value.h"
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Register-based bytecode. Every function (and the module body) owns a
+// window of registers: parameters first, then the other locals, then
+// temporaries. R[x] is a register, K[x] a constant and G[x] the global
+// variable of symbol x.
+enum class Opcode : uint8_t {
+    LOADK,      // R[a] = K[d]
+    MOVE,       // R[a] = R[b]
+    GETGLOBAL,  // R[a] = G[d], or None if unbound
+    SETGLOBAL,  // G[d] = R[a]
+    GETNAME,    // R[a] = R[b] if local b is bound, else G[d]
+    SETNAME,    // local b = R[a] if bound or G[d] is unbound, else G[d] = R[a]
+    ADD,        // R[a] = R[b] + R[c]
+    SUB,        // R[a] = R[b] - R[c]
+    MUL,        // R[a] = R[b] * R[c]
+    DIV,        // R[a] = R[b] / R[c]
+    FLOORDIV,   // R[a] = R[b] // R[c]
+    MOD,        // R[a] = R[b] % R[c]
+    NEG,        // R[a] = -R[b]
+    NOT,        // R[a] = not R[b]
+    LT,         // R[a] = R[b] < R[c]
+    GT,         // R[a] = R[b] > R[c]
+    LE,         // R[a] = R[b] <= R[c]
+    GE,         // R[a] = R[b] >= R[c]
+    EQ,         // R[a] = R[b] == R[c]
+    NE,         // R[a] = R[b] != R[c]
+    JUMP,       // pc = d
+    JUMPIF,     // if R[a]: pc = d
+    JUMPIFNOT,  // if not R[a]: pc = d
+    CALL,       // R[a] = call site d with c arguments in R[b..]
+    BUILTIN,    // R[a] = builtin x applied to R[b..b+c)
+    FORMAT,     // R[a] = concatenation of str(R[b..b+c))
+    DEFINE,     // bind function proto d, with c defaults in R[b..]
+    LOOP,       // while loop header, loops[a] of the function
+    TAILCALL,   // CALL followed by RETURN R[a]; the callee takes over the frame
+    RETURN,     // return R[a]
+
+    // Quickened forms the VM rewrites generic instructions to once it has
+    // seen their operand types. Each checks those types and reverts to the
+    // generic opcode when they differ.
+    ADD_INT,    // ADD of two ints
+    SUB_INT,    // SUB of two ints
+    MUL_INT,    // MUL of two ints
+    FLOORDIV_INT, // FLOORDIV of two ints
+    MOD_INT,    // MOD of two ints
+    ADD_FLOAT,  // ADD of two floats
+    SUB_FLOAT,  // SUB of two floats
+    MUL_FLOAT,  // MUL of two floats
+    DIV_FLOAT,  // DIV of two floats
+    ADD_STR,    // ADD of two strings
+    LT_INT,     // LT of two ints
+    GT_INT,     // GT of two ints
+    LE_INT,     // LE of two ints
+    GE_INT,     // GE of two ints
+    EQ_INT,     // EQ of two ints
+    NE_INT,     // NE of two ints
+
+    // Superinstructions that fuseSuperinstructions puts in place of the
+    // first instruction of a common sequence. They run the whole sequence
+    // in one dispatch; the rest of it stays in place behind them, so jumps
+    // into the middle and the JIT still find the original instructions.
+    LOADK_ADD,  // LOADK, then ADD
+    LOADK_SUB,  // LOADK, then SUB
+    LOADK_MOD,  // LOADK, then MOD
+    LT_JUMPIFNOT, // LT into R[a], then JUMPIFNOT R[a]
+    GT_JUMPIFNOT, // GT into R[a], then JUMPIFNOT R[a]
+    LE_JUMPIFNOT, // LE into R[a], then JUMPIFNOT R[a]
+    GE_JUMPIFNOT, // GE into R[a], then JUMPIFNOT R[a]
+    EQ_JUMPIFNOT, // EQ into R[a], then JUMPIFNOT R[a]
+    NE_JUMPIFNOT, // NE into R[a], then JUMPIFNOT R[a]
+    LOADK_LT_JUMPIFNOT, // LOADK, then LT_JUMPIFNOT
+    LOADK_GT_JUMPIFNOT, // LOADK, then GT_JUMPIFNOT
+    LOADK_LE_JUMPIFNOT, // LOADK, then LE_JUMPIFNOT
+    LOADK_GE_JUMPIFNOT, // LOADK, then GE_JUMPIFNOT
+    LOADK_EQ_JUMPIFNOT, // LOADK, then EQ_JUMPIFNOT
+    LOADK_NE_JUMPIFNOT, // LOADK, then NE_JUMPIFNOT
+};
+
+constexpr size_t OPCODE_COUNT = static_cast<size_t>(Opcode::LOADK_NE_JUMPIFNOT) + 1;// LOADK_NE_JUMPIFNOT stays last
+
+struct Instr {
+    Opcode op;
+    uint8_t x;// builtin of BUILTIN; failed type checks of quickenable opcodes
+    uint16_t a;
+    uint16_t b;
+    uint16_t c;
+    uint32_t d;
+    int32_t handler = 0;// set by the VM when it links the code for threaded dispatch
+};
+
+// A call to a user function by name. keywords has one entry per argument,
+// NO_SYMBOL for positional ones; it is empty when all are positional.
+struct CallSite {
+    ast::Symbol callee;
+    std::vector<ast::Symbol> keywords;
+};
+
+struct JitLoop;
+
+// A while loop: code[header] is its LOOP instruction and code[exit] the
+// first instruction after it. The VM counts iterations to find hot loops.
+struct LoopSite {
+    uint32_t header;
+    uint32_t exit;
+    uint32_t hits = 0;
+    bool rejected = false;// not compilable, or the JIT is off
+    JitLoop* compiled = nullptr;
+};
+
+struct FunctionProto {
+    ast::Symbol name;
+    std::vector<ast::Symbol> params;
+    uint16_t localCount = 0;// parameters included
+    uint16_t frameSize = 0;// locals plus temporaries
+    std::vector<Instr> code;
+    std::vector<LoopSite> loops;
+};
+
+// Output of the compiler. functions[0] is the module body. Constant
+// indices of the source AST are preserved.
+struct BytecodeProgram {
+    std::vector<Value> constants;
+    std::vector<std::unique_ptr<FunctionProto>> functions;
+    std::vector<CallSite> callSites;
+    const ast::SymbolTable* symbols = nullptr;
+};
+
+const char* opcodeName(Opcode op);
+// The generic opcode a quickened one was rewritten from, the first
+// instruction of a superinstruction, or op itself
+Opcode genericOpcode(Opcode op);
+// Rewrites the instruction sequences that have a superinstruction
+void fuseSuperinstructions(FunctionProto& proto);
+void disassemble(const BytecodeProgram& program, std::ostream& out);
+
+#endif//PYTHON_INTERPRETER_BYTECODE_H
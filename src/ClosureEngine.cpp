@@ -0,0 +1,641 @@
+#include "ClosureEngine.h"
+#include "Builtins.h"
+#include "Operators.h"
+#include "Resolver.h"
+
+using namespace ast;
+using namespace closure;
+
+namespace {
+
+const Value noneValue;
+
+// Operand readers the specialised closures are instantiated with. Reading
+// by reference is safe for locals, which a callee can not rebind, and for
+// globals as long as no other operand runs code in between.
+struct LocalRead {
+    uint32_t slot;
+    const Value& operator()(Context& c) const { return c.frame->locals[slot]; }
+};
+
+struct GlobalRead {
+    Symbol name;
+    const Value& operator()(Context& c) const { return c.globalBound[name] ? c.globals[name] : noneValue; }
+};
+
+struct ConstantRead {
+    Value value;
+    const Value& operator()(Context&) const { return value; }
+};
+
+struct ExprRead {
+    ExprFn fn;
+    Value operator()(Context& c) const { return fn(c); }
+};
+
+template <typename Make>
+auto withOperand(const Operand& operand, Make make) {
+    switch (operand.kind) {
+        case Operand::Kind::LOCAL: return make(LocalRead{operand.index});
+        case Operand::Kind::GLOBAL: return make(GlobalRead{operand.index});
+        case Operand::Kind::CONSTANT: return make(ConstantRead{operand.constant});
+        case Operand::Kind::EXPR: break;
+    }
+    return make(ExprRead{operand.fn});
+}
+
+// A global left operand is copied out before a right operand that may call
+// a function reassigning it
+Operand settle(Operand lhs, const Operand& rhs) {
+    if (lhs.kind == Operand::Kind::GLOBAL && rhs.kind == Operand::Kind::EXPR) lhs.kind = Operand::Kind::EXPR;
+    return lhs;
+}
+
+template <BinaryOp OP>
+ExprFn makeBinary(const Operand& lhs, const Operand& rhs) {
+    return withOperand(settle(lhs, rhs), [&](auto l) {
+        return withOperand(rhs, [&](auto r) -> ExprFn {
+            return [l, r](Context& c) {
+                const Value& a = l(c);
+                const Value& b = r(c);
+                return applyBinary(OP, a, b);
+            };
+        });
+    });
+}
+
+ExprFn makeBinary(BinaryOp op, const Operand& lhs, const Operand& rhs) {
+    switch (op) {
+        case BinaryOp::ADD: return makeBinary<BinaryOp::ADD>(lhs, rhs);
+        case BinaryOp::SUB: return makeBinary<BinaryOp::SUB>(lhs, rhs);
+        case BinaryOp::MUL: return makeBinary<BinaryOp::MUL>(lhs, rhs);
+        case BinaryOp::DIV: return makeBinary<BinaryOp::DIV>(lhs, rhs);
+        case BinaryOp::FLOORDIV: return makeBinary<BinaryOp::FLOORDIV>(lhs, rhs);
+        case BinaryOp::MOD: return makeBinary<BinaryOp::MOD>(lhs, rhs);
+    }
+    return nullptr;
+}
+
+template <CompareOp OP>
+CondFn makeCompare(const Operand& lhs, const Operand& rhs) {
+    return withOperand(settle(lhs, rhs), [&](auto l) {
+        return withOperand(rhs, [&](auto r) -> CondFn {
+            return [l, r](Context& c) {
+                const Value& a = l(c);
+                const Value& b = r(c);
+                return applyCompare(OP, a, b);
+            };
+        });
+    });
+}
+
+CondFn makeCompare(CompareOp op, const Operand& lhs, const Operand& rhs) {
+    switch (op) {
+        case CompareOp::LT: return makeCompare<CompareOp::LT>(lhs, rhs);
+        case CompareOp::GT: return makeCompare<CompareOp::GT>(lhs, rhs);
+        case CompareOp::LE: return makeCompare<CompareOp::LE>(lhs, rhs);
+        case CompareOp::GE: return makeCompare<CompareOp::GE>(lhs, rhs);
+        case CompareOp::EQ: return makeCompare<CompareOp::EQ>(lhs, rhs);
+        case CompareOp::NE: return makeCompare<CompareOp::NE>(lhs, rhs);
+    }
+    return nullptr;
+}
+
+// x op= y on a plain local updates the slot in place
+template <BinaryOp OP>
+StmtFn makeLocalUpdate(uint32_t slot, const Operand& rhs) {
+    return withOperand(rhs, [&](auto r) -> StmtFn {
+        return [slot, r](Context& c) {
+            Value& target = c.frame->locals[slot];
+            const Value& value = r(c);
+            target = applyBinary(OP, target, value);
+            return Flow::NORMAL;
+        };
+    });
+}
+
+StmtFn makeLocalUpdate(BinaryOp op, uint32_t slot, const Operand& rhs) {
+    switch (op) {
+        case BinaryOp::ADD: return makeLocalUpdate<BinaryOp::ADD>(slot, rhs);
+        case BinaryOp::SUB: return makeLocalUpdate<BinaryOp::SUB>(slot, rhs);
+        case BinaryOp::MUL: return makeLocalUpdate<BinaryOp::MUL>(slot, rhs);
+        case BinaryOp::DIV: return makeLocalUpdate<BinaryOp::DIV>(slot, rhs);
+        case BinaryOp::FLOORDIV: return makeLocalUpdate<BinaryOp::FLOORDIV>(slot, rhs);
+        case BinaryOp::MOD: return makeLocalUpdate<BinaryOp::MOD>(slot, rhs);
+    }
+    return nullptr;
+}
+
+struct CallArg {
+    Symbol keyword;
+    ExprFn value;
+};
+
+void bindArguments(Context& c, const Function& function, const std::vector<CallArg>& args, Frame& callee) {
+    const FuncDef* def = function.def;
+    callee.function = &function;
+    callee.locals.resize(def->localCount);
+    callee.bound.resize(def->localCount);
+
+    // Arguments are evaluated in the caller's frame, left to right;
+    // positional ones fill parameters in order, keywords match by name
+    size_t position = 0;
+    for (const CallArg& arg : args) {
+        if (arg.keyword == NO_SYMBOL) {
+            if (position < def->params.size) {
+                callee.locals[position] = arg.value(c);
+                callee.bound[position] = true;
+                position++;
+            }
+            continue;
+        }
+        Value value = arg.value(c);
+        for (size_t i = 0; i < def->params.size; i++) {
+            if (def->params[i] == arg.keyword) {
+                callee.locals[i] = std::move(value);
+                callee.bound[i] = true;
+                break;
+            }
+        }
+    }
+
+    // Missing parameters take their default, or None
+    size_t firstDefault = def->params.size - def->defaults.size;
+    for (size_t i = 0; i < def->params.size; i++) {
+        if (callee.bound[i]) continue;
+        if (i >= firstDefault) callee.locals[i] = function.defaults[i - firstDefault];
+        callee.bound[i] = true;
+    }
+}
+
+// The caller keeps function alive for the duration of the call
+Value callFunction(Context& c, const Function& function, const std::vector<CallArg>& args) {
+    Frame callee;
+    bindArguments(c, function, args, callee);
+    const FuncDef* def = function.def;
+    std::string key;
+    bool memoized = c.memo && c.memo->memoizes(def->name)
+                    && MemoCache::makeKey(def->name, callee.locals.data(), def->params.size, key);
+    if (memoized) {
+        if (const Value* result = c.memo->lookup(def->name, key)) return *result;
+    }
+
+    // A self tail call rebinds the frame and has the body run again, so
+    // tail recursion runs in constant C++ stack
+    const StmtFn& body = *function.body;
+    Frame* caller = c.frame;
+    c.frame = &callee;
+    do {
+        callee.tailCall = false;
+        body(c);
+    } while (callee.tailCall);
+    c.frame = caller;
+    if (memoized) c.memo->store(std::move(key), callee.returnValue);
+    return std::move(callee.returnValue);
+}
+
+}// namespace
+
+ClosureEngine::ClosureEngine(const Program& program, MemoCache* memo) : program(program) {
+    context.memo = memo;
+}
+
+void ClosureEngine::run() {
+    moduleAssigned = moduleAssignedNames(program);
+    context.globals.resize(program.symbols.size());
+    context.globalBound.resize(program.symbols.size());
+    context.functions.resize(program.symbols.size());
+    StmtFn main = compileBlock(program.body);
+    main(context);
+}
+
+// ============ Statements ============
+
+StmtFn ClosureEngine::compileBlock(Span<Stmt*> body) {
+    std::vector<StmtFn> stmts;
+    for (const Stmt* stmt : body) stmts.push_back(compileStmt(stmt));
+    if (stmts.empty()) return [](Context&) { return Flow::NORMAL; };
+    if (stmts.size() == 1) return stmts[0];
+    return [stmts](Context& c) {
+        for (const StmtFn& stmt : stmts) {
+            Flow flow = stmt(c);
+            if (flow != Flow::NORMAL) return flow;
+        }
+        return Flow::NORMAL;
+    };
+}
+
+StmtFn ClosureEngine::compileStmt(const Stmt* stmt) {
+    switch (stmt->kind) {
+        case StmtKind::EXPR: {
+            ExprFn value = compileExpr(static_cast<const ExprStmt*>(stmt)->value);
+            return [value](Context& c) {
+                value(c);
+                return Flow::NORMAL;
+            };
+        }
+        case StmtKind::ASSIGN:
+            return compileAssign(static_cast<const Assign*>(stmt));
+        case StmtKind::AUG_ASSIGN:
+            return compileAugAssign(static_cast<const AugAssign*>(stmt));
+        case StmtKind::IF:
+            return compileIf(static_cast<const If*>(stmt));
+        case StmtKind::WHILE:
+            return compileWhile(static_cast<const While*>(stmt));
+        case StmtKind::FUNCDEF:
+            return compileFuncdef(static_cast<const FuncDef*>(stmt));
+        case StmtKind::RETURN: {
+            auto ret = static_cast<const Return*>(stmt);
+            if (ret->selfCall) {
+                // Replaces the frame by a call of the same function if the
+                // name still refers to the running function
+                auto call = static_cast<const Call*>(ret->value);
+                Symbol callee = call->callee;
+                std::vector<CallArg> args;
+                for (const Argument& arg : call->args) args.push_back(CallArg{arg.keyword, compileExpr(arg.value)});
+                ExprFn value = compileExpr(call);
+                return [callee, args, value](Context& c) {
+                    if (c.functions[callee].get() != c.frame->function) {
+                        c.frame->returnValue = value(c);
+                        return Flow::RETURN;
+                    }
+                    Frame next;
+                    bindArguments(c, *c.frame->function, args, next);
+                    std::swap(c.frame->locals, next.locals);
+                    std::swap(c.frame->bound, next.bound);
+                    c.frame->tailCall = true;
+                    return Flow::RETURN;
+                };
+            }
+            ExprFn value = ret->value ? compileExpr(ret->value) : [](Context&) { return Value(); };
+            return [value](Context& c) {
+                Value result = value(c);
+                if (c.frame) c.frame->returnValue = std::move(result);
+                return Flow::RETURN;
+            };
+        }
+        case StmtKind::BREAK:
+            return [](Context&) { return Flow::BREAK; };
+        case StmtKind::CONTINUE:
+            return [](Context&) { return Flow::CONTINUE; };
+    }
+    return nullptr;
+}
+
+StmtFn ClosureEngine::compileAssign(const Assign* stmt) {
+    if (stmt->targets.size == 1 && stmt->targets[0].size == 1 && stmt->values.size == 1) {
+        const Target& target = stmt->targets[0][0];
+        ExprFn value = compileExpr(stmt->values[0]);
+        if (target.name != NO_SYMBOL && storageOf(target.name, target.slot) == Storage::LOCAL) {
+            uint32_t slot = target.slot;
+            return [slot, value](Context& c) {
+                Value result = value(c);
+                c.frame->locals[slot] = std::move(result);
+                return Flow::NORMAL;
+            };
+        }
+        auto store = compileStore(target);
+        return [value, store](Context& c) {
+            store(c, value(c));
+            return Flow::NORMAL;
+        };
+    }
+
+    // Every value is computed before any target is written
+    std::vector<ExprFn> values;
+    for (const Expr* value : stmt->values) values.push_back(compileExpr(value));
+    std::vector<std::pair<std::function<void(Context&, Value)>, size_t>> stores;
+    for (const Span<Target>& targets : stmt->targets) {
+        if (targets.size == stmt->values.size) {
+            for (size_t i = 0; i < targets.size; i++) stores.emplace_back(compileStore(targets[i]), i);
+        } else if (targets.size == 1) {
+            stores.emplace_back(compileStore(targets[0]), 0);
+        }
+    }
+    return [values, stores](Context& c) {
+        std::vector<Value> results;
+        results.reserve(values.size());
+        for (const ExprFn& value : values) results.push_back(value(c));
+        for (const auto& store : stores) store.first(c, results[store.second]);
+        return Flow::NORMAL;
+    };
+}
+
+StmtFn ClosureEngine::compileAugAssign(const AugAssign* stmt) {
+    const Target& target = stmt->target;
+    if (storageOf(target.name, target.slot) == Storage::LOCAL) {
+        return makeLocalUpdate(stmt->op, target.slot, compileOperand(stmt->value));
+    }
+    ExprFn load = compileLoad(target.name, target.slot);
+    ExprFn value = compileExpr(stmt->value);
+    auto store = compileStore(target);
+    BinaryOp op = stmt->op;
+    return [load, value, store, op](Context& c) {
+        Value oldVal = load(c);
+        Value rhsVal = value(c);
+        store(c, applyBinary(op, oldVal, rhsVal));
+        return Flow::NORMAL;
+    };
+}
+
+StmtFn ClosureEngine::compileIf(const If* stmt) {
+    std::vector<std::pair<CondFn, StmtFn>> branches;
+    for (const IfBranch& branch : stmt->branches) {
+        branches.emplace_back(compileCond(branch.condition), compileBlock(branch.body));
+    }
+    if (branches.size() == 1 && stmt->orelse.empty()) {
+        CondFn cond = branches[0].first;
+        StmtFn body = branches[0].second;
+        return [cond, body](Context& c) { return cond(c) ? body(c) : Flow::NORMAL; };
+    }
+    StmtFn orelse = compileBlock(stmt->orelse);
+    return [branches, orelse](Context& c) {
+        for (const auto& branch : branches) {
+            if (branch.first(c)) return branch.second(c);
+        }
+        return orelse(c);
+    };
+}
+
+StmtFn ClosureEngine::compileWhile(const While* stmt) {
+    CondFn cond = compileCond(stmt->condition);
+    StmtFn body = compileBlock(stmt->body);
+    return [cond, body](Context& c) {
+        while (cond(c)) {
+            Flow flow = body(c);
+            if (flow == Flow::BREAK) break;
+            if (flow == Flow::RETURN) return flow;
+        }
+        return Flow::NORMAL;
+    };
+}
+
+StmtFn ClosureEngine::compileFuncdef(const FuncDef* def) {
+    // Defaults belong to the defining scope, the body to its own
+    std::vector<ExprFn> defaults;
+    for (const Expr* value : def->defaults) defaults.push_back(compileExpr(value));
+    size_t outerParams = paramCount;
+    paramCount = def->params.size;
+    bodies.push_back(compileBlock(def->body));
+    paramCount = outerParams;
+
+    const StmtFn* body = &bodies.back();
+    return [def, body, defaults](Context& c) {
+        auto function = std::make_shared<Function>();
+        function->def = def;
+        function->body = body;
+        for (const ExprFn& value : defaults) function->defaults.push_back(value(c));
+        c.functions[def->name] = std::move(function);
+        return Flow::NORMAL;
+    };
+}
+
+// ============ Expressions ============
+
+ExprFn ClosureEngine::compileExpr(const Expr* expr) {
+    switch (expr->kind) {
+        case ExprKind::CONSTANT: {
+            Value value = program.constants[static_cast<const Constant*>(expr)->index];
+            return [value](Context&) { return value; };
+        }
+        case ExprKind::NAME: {
+            auto name = static_cast<const Name*>(expr);
+            return compileLoad(name->name, name->slot);
+        }
+        case ExprKind::UNARY: {
+            auto unary = static_cast<const Unary*>(expr);
+            if (unary->op == UnaryOp::NOT) {
+                CondFn operand = compileCond(unary->operand);
+                return [operand](Context& c) { return Value(!operand(c)); };
+            }
+            ExprFn operand = compileExpr(unary->operand);
+            if (unary->op == UnaryOp::POS) return operand;
+            return [operand](Context& c) { return -operand(c); };
+        }
+        case ExprKind::BINARY: {
+            auto binary = static_cast<const Binary*>(expr);
+            return makeBinary(binary->op, compileOperand(binary->lhs), compileOperand(binary->rhs));
+        }
+        case ExprKind::COMPARE:
+            return compileCompare(static_cast<const Compare*>(expr));
+        case ExprKind::BOOL_OP: {
+            // Yields the first operand that decides the result, like Python
+            auto boolOp = static_cast<const BoolOp*>(expr);
+            std::vector<ExprFn> operands;
+            for (const Expr* operand : boolOp->operands) operands.push_back(compileExpr(operand));
+            bool isOr = boolOp->op == LogicOp::OR;
+            return [operands, isOr](Context& c) {
+                Value result = operands[0](c);
+                for (size_t i = 1; i < operands.size(); i++) {
+                    if (result.toBool() == isOr) return result;
+                    result = operands[i](c);
+                }
+                return result;
+            };
+        }
+        case ExprKind::CALL:
+            return compileCall(static_cast<const Call*>(expr));
+        case ExprKind::FORMAT:
+            return compileFormat(static_cast<const FormatString*>(expr));
+    }
+    return nullptr;
+}
+
+// Conditions produce a bool directly instead of a boxed Value
+CondFn ClosureEngine::compileCond(const Expr* expr) {
+    switch (expr->kind) {
+        case ExprKind::CONSTANT: {
+            bool truth = program.constants[static_cast<const Constant*>(expr)->index].toBool();
+            return [truth](Context&) { return truth; };
+        }
+        case ExprKind::UNARY:
+            if (static_cast<const Unary*>(expr)->op == UnaryOp::NOT) {
+                CondFn operand = compileCond(static_cast<const Unary*>(expr)->operand);
+                return [operand](Context& c) { return !operand(c); };
+            }
+            break;
+        case ExprKind::COMPARE: {
+            auto compare = static_cast<const Compare*>(expr);
+            if (compare->ops.size != 1) break;
+            return makeCompare(compare->ops[0], compileOperand(compare->operands[0]),
+                               compileOperand(compare->operands[1]));
+        }
+        case ExprKind::BOOL_OP: {
+            auto boolOp = static_cast<const BoolOp*>(expr);
+            std::vector<CondFn> operands;
+            for (const Expr* operand : boolOp->operands) operands.push_back(compileCond(operand));
+            if (boolOp->op == LogicOp::AND) {
+                return [operands](Context& c) {
+                    for (const CondFn& operand : operands) {
+                        if (!operand(c)) return false;
+                    }
+                    return true;
+                };
+            }
+            return [operands](Context& c) {
+                for (const CondFn& operand : operands) {
+                    if (operand(c)) return true;
+                }
+                return false;
+            };
+        }
+        default:
+            break;
+    }
+    ExprFn value = compileExpr(expr);
+    return [value](Context& c) { return value(c).toBool(); };
+}
+
+ExprFn ClosureEngine::compileCompare(const Compare* expr) {
+    if (expr->ops.size == 1) {
+        CondFn test = makeCompare(expr->ops[0], compileOperand(expr->operands[0]), compileOperand(expr->operands[1]));
+        return [test](Context& c) { return Value(test(c)); };
+    }
+    std::vector<ExprFn> operands;
+    for (const Expr* operand : expr->operands) operands.push_back(compileExpr(operand));
+    std::vector<CompareOp> ops(expr->ops.begin(), expr->ops.end());
+    return [operands, ops](Context& c) {
+        Value result = operands[0](c);
+        for (size_t i = 0; i < ops.size(); i++) {
+            Value right = operands[i + 1](c);
+            if (!applyCompare(ops[i], result, right)) return Value(false);
+            result = std::move(right);
+        }
+        return Value(true);
+    };
+}
+
+ExprFn ClosureEngine::compileCall(const Call* expr) {
+    if (expr->builtin != Builtin::NONE) {
+        Builtin builtin = expr->builtin;
+        std::vector<ExprFn> args;
+        for (const Argument& arg : expr->args) args.push_back(compileExpr(arg.value));
+        if (args.size() == 1) {
+            ExprFn arg = args[0];
+            return [builtin, arg](Context& c) {
+                Value value = arg(c);
+                return invokeBuiltin(builtin, &value, 1);
+            };
+        }
+        return [builtin, args](Context& c) {
+            std::vector<Value> values;
+            values.reserve(args.size());
+            for (const ExprFn& arg : args) values.push_back(arg(c));
+            return invokeBuiltin(builtin, values.data(), values.size());
+        };
+    }
+
+    // Calling a name that is not (yet) a function yields None
+    Symbol callee = expr->callee;
+    std::vector<CallArg> args;
+    for (const Argument& arg : expr->args) args.push_back(CallArg{arg.keyword, compileExpr(arg.value)});
+    return [callee, args](Context& c) {
+        std::shared_ptr<const Function> function = c.functions[callee];
+        if (!function) return Value();
+        return callFunction(c, *function, args);
+    };
+}
+
+ExprFn ClosureEngine::compileFormat(const FormatString* expr) {
+    struct Part {
+        std::string literal;
+        std::vector<ExprFn> values;
+    };
+    std::vector<Part> parts;
+    for (const FormatPart& part : expr->parts) {
+        Part compiled;
+        if (part.literal != NO_CONSTANT) {
+            compiled.literal = program.constants[part.literal].stringVal;
+        } else {
+            for (const Expr* value : part.values) compiled.values.push_back(compileExpr(value));
+        }
+        parts.push_back(std::move(compiled));
+    }
+    return [parts](Context& c) {
+        std::string result;
+        for (const Part& part : parts) {
+            result += part.literal;
+            for (size_t i = 0; i < part.values.size(); i++) {
+                if (i > 0) result += ", ";
+                result += part.values[i](c).toString();
+            }
+        }
+        return Value(result);
+    };
+}
+
+Operand ClosureEngine::compileOperand(const Expr* expr) {
+    Operand operand{Operand::Kind::EXPR, 0, Value(), compileExpr(expr)};
+    if (expr->kind == ExprKind::CONSTANT) {
+        operand.kind = Operand::Kind::CONSTANT;
+        operand.constant = program.constants[static_cast<const Constant*>(expr)->index];
+    } else if (expr->kind == ExprKind::NAME) {
+        auto name = static_cast<const Name*>(expr);
+        switch (storageOf(name->name, name->slot)) {
+            case Storage::LOCAL:
+                operand.kind = Operand::Kind::LOCAL;
+                operand.index = name->slot;
+                break;
+            case Storage::GLOBAL:
+                operand.kind = Operand::Kind::GLOBAL;
+                operand.index = name->name;
+                break;
+            case Storage::NAME:
+                break;
+        }
+    }
+    return operand;
+}
+
+// ============ Names ============
+
+// Parameters, and locals no module-level code assigns, are plain slots;
+// other locals can fall back to a global of the same name
+ClosureEngine::Storage ClosureEngine::storageOf(Symbol name, int32_t slot) const {
+    if (slot == NO_SLOT) return Storage::GLOBAL;
+    if (static_cast<size_t>(slot) < paramCount || !moduleAssigned[name]) return Storage::LOCAL;
+    return Storage::NAME;
+}
+
+ExprFn ClosureEngine::compileLoad(Symbol name, int32_t slot) {
+    switch (storageOf(name, slot)) {
+        case Storage::LOCAL:
+            return [slot](Context& c) { return c.frame->locals[slot]; };
+        case Storage::GLOBAL:
+            return [name](Context& c) { return c.globalBound[name] ? c.globals[name] : Value(); };
+        case Storage::NAME:
+            break;
+    }
+    return [name, slot](Context& c) {
+        if (c.frame->bound[slot]) return c.frame->locals[slot];
+        return c.globalBound[name] ? c.globals[name] : Value();
+    };
+}
+
+std::function<void(Context&, Value)> ClosureEngine::compileStore(const Target& target) {
+    Symbol name = target.name;
+    int32_t slot = target.slot;
+    if (name == NO_SYMBOL) return [](Context&, Value) {};
+    switch (storageOf(name, slot)) {
+        case Storage::LOCAL:
+            return [slot](Context& c, Value value) { c.frame->locals[slot] = std::move(value); };
+        case Storage::GLOBAL:
+            return [name](Context& c, Value value) {
+                c.globals[name] = std::move(value);
+                c.globalBound[name] = true;
+            };
+        case Storage::NAME:
+            break;
+    }
+    // An unbound local only shadows a global that does not exist yet
+    return [name, slot](Context& c, Value value) {
+        Frame* frame = c.frame;
+        if (frame->bound[slot] || !c.globalBound[name]) {
+            frame->locals[slot] = std::move(value);
+            frame->bound[slot] = true;
+            return;
+        }
+        c.globals[name] = std::move(value);
+        c.globalBound[name] = true;
+    };
+}
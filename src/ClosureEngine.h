@@ -0,0 +1,99 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_CLOSUREENGINE_H
+#define PYTHON_INTERPRETER_CLOSUREENGINE_H
+
+#include "Ast.h"
+#include "Memo.h"
+#include "Value.h"
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Runtime state shared by the closures the engine builds
+namespace closure {
+
+enum class Flow { NORMAL, BREAK, CONTINUE, RETURN };
+
+struct Function;
+
+struct Frame {
+    const Function* function;
+    std::vector<Value> locals;
+    std::vector<char> bound;
+    Value returnValue;
+    bool tailCall = false;// the body returned to be run again, rebound
+};
+
+struct Context;
+using ExprFn = std::function<Value(Context&)>;
+using CondFn = std::function<bool(Context&)>;
+using StmtFn = std::function<Flow(Context&)>;
+
+// A def that has been executed, with its defaults evaluated at that time
+struct Function {
+    const ast::FuncDef* def;
+    const StmtFn* body;
+    std::vector<Value> defaults;
+};
+
+struct Context {
+    std::vector<Value> globals;
+    std::vector<char> globalBound;
+    std::vector<std::shared_ptr<const Function>> functions;// by symbol
+    Frame* frame = nullptr;// innermost call, nullptr at module level
+    MemoCache* memo = nullptr;
+};
+
+// How an operand is read: straight from a local slot, a global or a
+// constant, or through the generic closure fn, which is always set
+struct Operand {
+    enum class Kind { LOCAL, GLOBAL, CONSTANT, EXPR } kind;
+    uint32_t index;// slot or symbol
+    Value constant;
+    ExprFn fn;
+};
+
+}// namespace closure
+
+// Compiles every AST node once into a C++ closure specialised for the shape
+// of its operands, e.g. "add two locals" or "compare a local with a
+// constant", then runs the program by invoking those closures. Semantics
+// match the AST interpreter.
+class ClosureEngine {
+public:
+    // memo: cache for the results of pure functions, or nullptr
+    explicit ClosureEngine(const ast::Program& program, MemoCache* memo = nullptr);
+
+    void run();
+
+private:
+    enum class Storage { GLOBAL, LOCAL, NAME };
+
+    const ast::Program& program;
+    std::vector<char> moduleAssigned;// by symbol
+    size_t paramCount = 0;// of the function being compiled
+    std::deque<closure::StmtFn> bodies;// compiled function bodies
+    closure::Context context;
+
+    closure::StmtFn compileBlock(ast::Span<ast::Stmt*> body);
+    closure::StmtFn compileStmt(const ast::Stmt* stmt);
+    closure::StmtFn compileAssign(const ast::Assign* stmt);
+    closure::StmtFn compileAugAssign(const ast::AugAssign* stmt);
+    closure::StmtFn compileIf(const ast::If* stmt);
+    closure::StmtFn compileWhile(const ast::While* stmt);
+    closure::StmtFn compileFuncdef(const ast::FuncDef* def);
+
+    closure::ExprFn compileExpr(const ast::Expr* expr);
+    closure::CondFn compileCond(const ast::Expr* expr);
+    closure::ExprFn compileCompare(const ast::Compare* expr);
+    closure::ExprFn compileCall(const ast::Call* expr);
+    closure::ExprFn compileFormat(const ast::FormatString* expr);
+    closure::Operand compileOperand(const ast::Expr* expr);
+
+    Storage storageOf(ast::Symbol name, int32_t slot) const;
+    closure::ExprFn compileLoad(ast::Symbol name, int32_t slot);
+    std::function<void(closure::Context&, Value)> compileStore(const ast::Target& target);
+};
+
+#endif//PYTHON_INTERPRETER_CLOSUREENGINE_H
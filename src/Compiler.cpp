@@ -0,0 +1,685 @@
+#include "Compiler.h"
+#include "Resolver.h"
+
+using namespace ast;
+
+namespace {
+
+Opcode binaryOpcode(BinaryOp op) {
+    switch (op) {
+        case BinaryOp::ADD: return Opcode::ADD;
+        case BinaryOp::SUB: return Opcode::SUB;
+        case BinaryOp::MUL: return Opcode::MUL;
+        case BinaryOp::DIV: return Opcode::DIV;
+        case BinaryOp::FLOORDIV: return Opcode::FLOORDIV;
+        case BinaryOp::MOD: return Opcode::MOD;
+    }
+    return Opcode::ADD;
+}
+
+Opcode compareOpcode(CompareOp op) {
+    switch (op) {
+        case CompareOp::LT: return Opcode::LT;
+        case CompareOp::GT: return Opcode::GT;
+        case CompareOp::LE: return Opcode::LE;
+        case CompareOp::GE: return Opcode::GE;
+        case CompareOp::EQ: return Opcode::EQ;
+        case CompareOp::NE: return Opcode::NE;
+    }
+    return Opcode::EQ;
+}
+
+// Largest body, in statements and expressions, that is inlined
+constexpr size_t MAX_INLINE_NODES = 40;
+
+// Checks whether a def is small and simple enough to inline: no loops or
+// nested defs, every local in a plain register, constant defaults and no
+// calls of itself
+class InlineChecker {
+public:
+    InlineChecker(const FuncDef* def, const std::vector<char>& moduleAssigned)
+        : def(def), moduleAssigned(moduleAssigned) {}
+
+    bool check() {
+        for (const Expr* value : def->defaults) {
+            if (value->kind != ExprKind::CONSTANT) return false;
+        }
+        return checkBlock(def->body) && nodes <= MAX_INLINE_NODES;
+    }
+
+private:
+    const FuncDef* def;
+    const std::vector<char>& moduleAssigned;
+    size_t nodes = 0;
+
+    bool checkSlot(Symbol name, int32_t slot) const {
+        return slot == NO_SLOT || static_cast<size_t>(slot) < def->params.size || !moduleAssigned[name];
+    }
+
+    bool checkBlock(Span<Stmt*> body) {
+        for (const Stmt* stmt : body) {
+            if (!checkStmt(stmt)) return false;
+        }
+        return true;
+    }
+
+    bool checkStmt(const Stmt* stmt) {
+        nodes++;
+        switch (stmt->kind) {
+            case StmtKind::EXPR:
+                return checkExpr(static_cast<const ExprStmt*>(stmt)->value);
+            case StmtKind::ASSIGN: {
+                auto assign = static_cast<const Assign*>(stmt);
+                for (const Span<Target>& targets : assign->targets) {
+                    for (const Target& target : targets) {
+                        if (!checkSlot(target.name, target.slot)) return false;
+                    }
+                }
+                for (const Expr* value : assign->values) {
+                    if (!checkExpr(value)) return false;
+                }
+                return true;
+            }
+            case StmtKind::AUG_ASSIGN: {
+                auto assign = static_cast<const AugAssign*>(stmt);
+                return assign->target.name != NO_SYMBOL && checkSlot(assign->target.name, assign->target.slot)
+                       && checkExpr(assign->value);
+            }
+            case StmtKind::IF: {
+                auto ifStmt = static_cast<const If*>(stmt);
+                for (const IfBranch& branch : ifStmt->branches) {
+                    if (!checkExpr(branch.condition) || !checkBlock(branch.body)) return false;
+                }
+                return checkBlock(ifStmt->orelse);
+            }
+            case StmtKind::RETURN: {
+                auto ret = static_cast<const Return*>(stmt);
+                return !ret->value || checkExpr(ret->value);
+            }
+            case StmtKind::WHILE:
+            case StmtKind::FUNCDEF:
+            case StmtKind::BREAK:
+            case StmtKind::CONTINUE:
+                return false;
+        }
+        return false;
+    }
+
+    bool checkExpr(const Expr* expr) {
+        nodes++;
+        switch (expr->kind) {
+            case ExprKind::CONSTANT:
+                return true;
+            case ExprKind::NAME: {
+                auto name = static_cast<const Name*>(expr);
+                return checkSlot(name->name, name->slot);
+            }
+            case ExprKind::UNARY:
+                return checkExpr(static_cast<const Unary*>(expr)->operand);
+            case ExprKind::BINARY: {
+                auto binary = static_cast<const Binary*>(expr);
+                return checkExpr(binary->lhs) && checkExpr(binary->rhs);
+            }
+            case ExprKind::COMPARE:
+                for (const Expr* operand : static_cast<const Compare*>(expr)->operands) {
+                    if (!checkExpr(operand)) return false;
+                }
+                return true;
+            case ExprKind::BOOL_OP:
+                for (const Expr* operand : static_cast<const BoolOp*>(expr)->operands) {
+                    if (!checkExpr(operand)) return false;
+                }
+                return true;
+            case ExprKind::CALL: {
+                auto call = static_cast<const Call*>(expr);
+                if (call->builtin == Builtin::NONE && call->callee == def->name) return false;
+                for (const Argument& arg : call->args) {
+                    if (!checkExpr(arg.value)) return false;
+                }
+                return true;
+            }
+            case ExprKind::FORMAT:
+                for (const FormatPart& part : static_cast<const FormatString*>(expr)->parts) {
+                    for (const Expr* value : part.values) {
+                        if (!checkExpr(value)) return false;
+                    }
+                }
+                return true;
+        }
+        return false;
+    }
+};
+
+}// namespace
+
+Compiler::Compiler(const Program& source) : source(source) {}
+
+std::unique_ptr<BytecodeProgram> Compiler::compile() {
+    program = std::make_unique<BytecodeProgram>();
+    program->constants = source.constants;
+    program->symbols = &source.symbols;
+    noneConstant = addConstant(Value());
+    falseConstant = addConstant(Value(false));
+    separatorConstant = addConstant(Value(std::string(", ")));
+
+    moduleAssigned = moduleAssignedNames(source);
+
+    // A function with a single def, made by a module statement, is bound
+    // for good once that statement has run: any call compiled as part of a
+    // later module statement, including the bodies it defines, reaches it
+    std::vector<uint32_t> defs = definitionCounts(source);
+    inlinable.assign(source.symbols.size(), nullptr);
+    definedAt.assign(source.symbols.size(), 0);
+    for (size_t i = 0; i < source.body.size; i++) {
+        if (source.body[i]->kind != StmtKind::FUNCDEF) continue;
+        auto def = static_cast<const FuncDef*>(source.body[i]);
+        if (defs[def->name] != 1 || !InlineChecker(def, moduleAssigned).check()) continue;
+        inlinable[def->name] = def;
+        definedAt[def->name] = i;
+    }
+
+    auto module = std::make_unique<FunctionProto>();
+    module->name = NO_SYMBOL;
+    Scope moduleScope{module.get(), 0, 0, {}};
+    program->functions.push_back(std::move(module));
+    scope = &moduleScope;
+    for (statement = 0; statement < source.body.size; statement++) compileStmt(source.body[statement]);
+    compileReturn(nullptr);
+    scope = nullptr;
+    for (const auto& function : program->functions) fuseSuperinstructions(*function);
+    return std::move(program);
+}
+
+uint32_t Compiler::compileFunction(const FuncDef* def) {
+    auto proto = std::make_unique<FunctionProto>();
+    proto->name = def->name;
+    proto->params.assign(def->params.begin(), def->params.end());
+    proto->localCount = def->localCount;
+    proto->frameSize = def->localCount;
+
+    Scope inner{proto.get(), def->params.size, static_cast<uint16_t>(def->localCount), {}};
+    uint32_t index = program->functions.size();
+    program->functions.push_back(std::move(proto));
+
+    Scope* outer = scope;
+    scope = &inner;
+    compileBlock(def->body);
+    compileReturn(nullptr);
+    scope = outer;
+    return index;
+}
+
+// ============ Statements ============
+
+void Compiler::compileBlock(Span<Stmt*> body) {
+    for (const Stmt* stmt : body) compileStmt(stmt);
+}
+
+void Compiler::compileStmt(const Stmt* stmt) {
+    uint16_t mark = scope->top;
+    switch (stmt->kind) {
+        case StmtKind::EXPR:
+            compileExpr(static_cast<const ExprStmt*>(stmt)->value);
+            break;
+        case StmtKind::ASSIGN:
+            compileAssign(static_cast<const Assign*>(stmt));
+            break;
+        case StmtKind::AUG_ASSIGN:
+            compileAugAssign(static_cast<const AugAssign*>(stmt));
+            break;
+        case StmtKind::IF:
+            compileIf(static_cast<const If*>(stmt));
+            break;
+        case StmtKind::WHILE:
+            compileWhile(static_cast<const While*>(stmt));
+            break;
+        case StmtKind::FUNCDEF: {
+            // Defaults are evaluated now, in the defining scope
+            auto def = static_cast<const FuncDef*>(stmt);
+            uint16_t first = scope->top;
+            for (const Expr* value : def->defaults) {
+                uint16_t reg = allocTemp();
+                compileExpr(value, reg);
+                scope->top = reg + 1;
+            }
+            emit(Opcode::DEFINE, 0, first, def->defaults.size, compileFunction(def));
+            break;
+        }
+        case StmtKind::RETURN: {
+            auto ret = static_cast<const Return*>(stmt);
+            compileReturn(ret->value);
+            break;
+        }
+        case StmtKind::BREAK:
+            if (scope->loops.empty()) {
+                compileReturn(nullptr);
+            } else {
+                scope->loops.back().breaks.push_back(emit(Opcode::JUMP));
+            }
+            break;
+        case StmtKind::CONTINUE:
+            // Outside a loop, break and continue end the enclosing body
+            if (scope->loops.empty()) {
+                compileReturn(nullptr);
+            } else {
+                emit(Opcode::JUMP, 0, 0, 0, scope->loops.back().start);
+            }
+            break;
+    }
+    scope->top = mark;
+}
+
+void Compiler::compileAssign(const Assign* stmt) {
+    // a = b evaluates straight into a's register when it has one
+    if (stmt->targets.size == 1 && stmt->targets[0].size == 1 && stmt->values.size == 1) {
+        const Target& target = stmt->targets[0][0];
+        if (target.name != NO_SYMBOL && storageOf(target.name, target.slot) == Storage::REGISTER) {
+            compileExpr(stmt->values[0], registerOf(target.slot));
+        } else {
+            storeTarget(target, compileExpr(stmt->values[0]));
+        }
+        return;
+    }
+
+    // Every value is computed before any target is written
+    uint16_t first = scope->top;
+    for (const Expr* value : stmt->values) {
+        uint16_t reg = allocTemp();
+        compileExpr(value, reg);
+        scope->top = reg + 1;
+    }
+    for (const Span<Target>& targets : stmt->targets) {
+        if (targets.size == stmt->values.size) {
+            for (size_t i = 0; i < targets.size; i++) storeTarget(targets[i], first + i);
+        } else if (targets.size == 1) {
+            storeTarget(targets[0], first);
+        }
+    }
+}
+
+void Compiler::compileAugAssign(const AugAssign* stmt) {
+    const Target& target = stmt->target;
+    Opcode op = binaryOpcode(stmt->op);
+    switch (storageOf(target.name, target.slot)) {
+        case Storage::REGISTER: {
+            uint16_t rhs = compileExpr(stmt->value);
+            emit(op, registerOf(target.slot), registerOf(target.slot), rhs);
+            break;
+        }
+        case Storage::GLOBAL: {
+            uint16_t reg = allocTemp();
+            emit(Opcode::GETGLOBAL, reg, 0, 0, target.name);
+            uint16_t rhs = compileExpr(stmt->value);
+            emit(op, reg, reg, rhs);
+            emit(Opcode::SETGLOBAL, reg, 0, 0, target.name);
+            break;
+        }
+        case Storage::NAME: {
+            uint16_t reg = allocTemp();
+            emit(Opcode::GETNAME, reg, target.slot, 0, target.name);
+            uint16_t rhs = compileExpr(stmt->value);
+            emit(op, reg, reg, rhs);
+            emit(Opcode::SETNAME, reg, target.slot, 0, target.name);
+            break;
+        }
+    }
+}
+
+void Compiler::compileIf(const If* stmt) {
+    std::vector<size_t> exits;
+    for (size_t i = 0; i < stmt->branches.size; i++) {
+        const IfBranch& branch = stmt->branches[i];
+        std::vector<size_t> skip;
+        compileBranch(branch.condition, false, skip);
+        compileBlock(branch.body);
+        bool last = i + 1 == stmt->branches.size && stmt->orelse.empty();
+        if (!last) exits.push_back(emit(Opcode::JUMP));
+        for (size_t at : skip) patch(at);
+    }
+    compileBlock(stmt->orelse);
+    for (size_t at : exits) patch(at);
+}
+
+void Compiler::compileWhile(const While* stmt) {
+    std::vector<size_t> exits;
+    size_t start = here();
+    size_t site = scope->proto->loops.size();
+    scope->proto->loops.push_back({static_cast<uint32_t>(start), 0});
+    emit(Opcode::LOOP, site);
+    compileBranch(stmt->condition, false, exits);
+    scope->loops.push_back({start, {}});
+    compileBlock(stmt->body);
+    emit(Opcode::JUMP, 0, 0, 0, start);
+    scope->proto->loops[site].exit = here();
+    for (size_t at : scope->loops.back().breaks) patch(at);
+    for (size_t at : exits) patch(at);
+    scope->loops.pop_back();
+}
+
+void Compiler::compileReturn(const Expr* value) {
+    if (Inline* body = scope->inlined) {
+        if (value) {
+            compileExpr(value, body->result);
+        } else {
+            emit(Opcode::LOADK, body->result, 0, 0, noneConstant);
+        }
+        body->returns.push_back(emit(Opcode::JUMP));
+        return;
+    }
+    uint16_t reg;
+    if (value) {
+        reg = compileExpr(value);
+        // Returning what a user function returns: the call becomes a tail call
+        Instr& last = scope->proto->code.back();
+        if (value->kind == ExprKind::CALL && last.op == Opcode::CALL && last.a == reg) last.op = Opcode::TAILCALL;
+    } else {
+        reg = allocTemp();
+        emit(Opcode::LOADK, reg, 0, 0, noneConstant);
+    }
+    emit(Opcode::RETURN, reg);
+}
+
+// ============ Expressions ============
+
+// Evaluates expr and returns the register holding the result; with dst set
+// the result is left there. dst is only written by the final instruction,
+// so the expression may still read the old value of a local it targets.
+uint16_t Compiler::compileExpr(const Expr* expr, int dst) {
+    uint16_t mark = scope->top;
+    switch (expr->kind) {
+        case ExprKind::CONSTANT: {
+            uint16_t reg = resultRegister(dst);
+            emit(Opcode::LOADK, reg, 0, 0, static_cast<const Constant*>(expr)->index);
+            return reg;
+        }
+        case ExprKind::NAME: {
+            auto name = static_cast<const Name*>(expr);
+            switch (storageOf(name->name, name->slot)) {
+                case Storage::REGISTER: {
+                    uint16_t reg = registerOf(name->slot);
+                    if (dst < 0) return reg;
+                    if (dst != reg) emit(Opcode::MOVE, dst, reg);
+                    return dst;
+                }
+                case Storage::GLOBAL: {
+                    uint16_t reg = resultRegister(dst);
+                    emit(Opcode::GETGLOBAL, reg, 0, 0, name->name);
+                    return reg;
+                }
+                case Storage::NAME: {
+                    uint16_t reg = resultRegister(dst);
+                    emit(Opcode::GETNAME, reg, name->slot, 0, name->name);
+                    return reg;
+                }
+            }
+            return 0;
+        }
+        case ExprKind::UNARY: {
+            auto unary = static_cast<const Unary*>(expr);
+            if (unary->op == UnaryOp::POS) return compileExpr(unary->operand, dst);
+            uint16_t operand = compileExpr(unary->operand);
+            scope->top = mark;
+            uint16_t reg = resultRegister(dst);
+            emit(unary->op == UnaryOp::NEG ? Opcode::NEG : Opcode::NOT, reg, operand);
+            return reg;
+        }
+        case ExprKind::BINARY: {
+            auto binary = static_cast<const Binary*>(expr);
+            uint16_t lhs = compileExpr(binary->lhs);
+            uint16_t rhs = compileExpr(binary->rhs);
+            scope->top = mark;
+            uint16_t reg = resultRegister(dst);
+            emit(binaryOpcode(binary->op), reg, lhs, rhs);
+            return reg;
+        }
+        case ExprKind::COMPARE:
+            return compileCompare(static_cast<const Compare*>(expr), dst);
+        case ExprKind::BOOL_OP:
+            return compileBoolOp(static_cast<const BoolOp*>(expr), dst);
+        case ExprKind::CALL:
+            return compileCall(static_cast<const Call*>(expr), dst);
+        case ExprKind::FORMAT:
+            return compileFormat(static_cast<const FormatString*>(expr), dst);
+    }
+    return 0;
+}
+
+uint16_t Compiler::compileCompare(const Compare* expr, int dst) {
+    uint16_t mark = scope->top;
+    std::vector<size_t> fails;
+    uint16_t lhs = compileExpr(expr->operands[0]);
+    for (size_t i = 0; i + 1 < expr->ops.size; i++) {
+        uint16_t rhs = compileExpr(expr->operands[i + 1]);
+        uint16_t test = allocTemp();
+        emit(compareOpcode(expr->ops[i]), test, lhs, rhs);
+        fails.push_back(emit(Opcode::JUMPIFNOT, test));
+        lhs = rhs;
+    }
+    uint16_t rhs = compileExpr(expr->operands[expr->ops.size]);
+    scope->top = mark;
+    uint16_t reg = resultRegister(dst);
+    emit(compareOpcode(expr->ops[expr->ops.size - 1]), reg, lhs, rhs);
+    if (!fails.empty()) {
+        size_t done = emit(Opcode::JUMP);
+        for (size_t at : fails) patch(at);
+        emit(Opcode::LOADK, reg, 0, 0, falseConstant);
+        patch(done);
+    }
+    return reg;
+}
+
+// and / or yield the operand that decided the result
+uint16_t Compiler::compileBoolOp(const BoolOp* expr, int dst) {
+    // A temporary target may be written early; a local may still be read
+    // by a later operand
+    uint16_t work = dst >= 0 && isTemporary(dst) ? dst : allocTemp();
+    uint16_t mark = scope->top;
+    Opcode exit = expr->op == LogicOp::OR ? Opcode::JUMPIF : Opcode::JUMPIFNOT;
+    std::vector<size_t> exits;
+    for (size_t i = 0; i < expr->operands.size; i++) {
+        compileExpr(expr->operands[i], work);
+        scope->top = mark;
+        if (i + 1 < expr->operands.size) exits.push_back(emit(exit, work));
+    }
+    for (size_t at : exits) patch(at);
+    if (dst >= 0 && dst != work) emit(Opcode::MOVE, dst, work);
+    return dst >= 0 ? dst : work;
+}
+
+// Arguments go to consecutive registers at the top of the frame; a user
+// function's frame starts at the first of them
+uint16_t Compiler::compileCall(const Call* expr, int dst) {
+    // Module code outside loops runs once and gains nothing from inlining
+    bool hot = scope->proto->name != NO_SYMBOL || !scope->loops.empty();
+    if (expr->builtin == Builtin::NONE && hot && !scope->inlined) {
+        const FuncDef* def = inlinable[expr->callee];
+        if (def && definedAt[expr->callee] < statement) return compileInline(expr, def, dst);
+    }
+
+    uint16_t first = scope->top;
+    bool hasKeywords = false;
+    for (const Argument& arg : expr->args) {
+        uint16_t reg = allocTemp();
+        compileExpr(arg.value, reg);
+        scope->top = reg + 1;
+        hasKeywords |= arg.keyword != NO_SYMBOL;
+    }
+    scope->top = first;
+    uint16_t reg = resultRegister(dst);
+
+    if (expr->builtin != Builtin::NONE) {
+        emit(Opcode::BUILTIN, reg, first, expr->args.size, 0, static_cast<uint8_t>(expr->builtin));
+        return reg;
+    }
+    CallSite site;
+    site.callee = expr->callee;
+    if (hasKeywords) {
+        for (const Argument& arg : expr->args) site.keywords.push_back(arg.keyword);
+    }
+    program->callSites.push_back(std::move(site));
+    emit(Opcode::CALL, reg, first, expr->args.size, program->callSites.size() - 1);
+    return reg;
+}
+
+// Binds the arguments the way the VM does and runs the body of def in
+// registers above the caller's temporaries; its returns jump to the end
+uint16_t Compiler::compileInline(const Call* expr, const FuncDef* def, int dst) {
+    uint16_t mark = scope->top;
+    uint16_t result = resultRegister(dst);
+    Inline body{scope->top, static_cast<uint16_t>(def->localCount), def->params.size, result, {}};
+    for (size_t i = 0; i < def->localCount; i++) allocTemp();
+
+    // Positional arguments fill parameters in order and keywords match by
+    // name; the others are still evaluated, then dropped
+    std::vector<char> given(def->params.size, false);
+    size_t position = 0;
+    for (const Argument& arg : expr->args) {
+        size_t param = def->params.size;
+        if (arg.keyword == NO_SYMBOL) {
+            if (position < def->params.size) param = position++;
+        } else {
+            for (size_t i = 0; i < def->params.size; i++) {
+                if (def->params[i] == arg.keyword) {
+                    param = i;
+                    break;
+                }
+            }
+        }
+        uint16_t top = scope->top;
+        if (param < def->params.size) {
+            compileExpr(arg.value, body.base + param);
+            given[param] = true;
+        } else {
+            compileExpr(arg.value);
+        }
+        scope->top = top;
+    }
+    size_t firstDefault = def->params.size - def->defaults.size;
+    for (size_t i = 0; i < def->localCount; i++) {
+        if (i < def->params.size && given[i]) continue;
+        uint32_t value = noneConstant;
+        if (i < def->params.size && i >= firstDefault) {
+            value = static_cast<const Constant*>(def->defaults[i - firstDefault])->index;
+        }
+        emit(Opcode::LOADK, body.base + i, 0, 0, value);
+    }
+
+    scope->inlined = &body;
+    compileBlock(def->body);
+    scope->inlined = nullptr;
+    if (!def->body.empty() && def->body[def->body.size - 1]->kind == StmtKind::RETURN) {
+        // The final return falls through to the end
+        scope->proto->code.pop_back();
+        body.returns.pop_back();
+    } else {
+        emit(Opcode::LOADK, result, 0, 0, noneConstant);
+    }
+    for (size_t at : body.returns) patch(at);
+    scope->top = dst >= 0 ? mark : result + 1;
+    return result;
+}
+
+uint16_t Compiler::compileFormat(const FormatString* expr, int dst) {
+    uint16_t first = scope->top;
+    for (const FormatPart& part : expr->parts) {
+        if (part.literal != NO_CONSTANT) {
+            emit(Opcode::LOADK, allocTemp(), 0, 0, part.literal);
+            continue;
+        }
+        for (size_t i = 0; i < part.values.size; i++) {
+            if (i > 0) emit(Opcode::LOADK, allocTemp(), 0, 0, separatorConstant);
+            uint16_t reg = allocTemp();
+            compileExpr(part.values[i], reg);
+            scope->top = reg + 1;
+        }
+    }
+    uint16_t count = scope->top - first;
+    scope->top = first;
+    uint16_t reg = resultRegister(dst);
+    emit(Opcode::FORMAT, reg, first, count);
+    return reg;
+}
+
+// Emits jumps, collected in jumps, that are taken when the truth value of
+// expr equals jumpIf. Logic operators become control flow, so conditions
+// never materialise the value of an and / or.
+void Compiler::compileBranch(const Expr* expr, bool jumpIf, std::vector<size_t>& jumps) {
+    if (expr->kind == ExprKind::UNARY && static_cast<const Unary*>(expr)->op == UnaryOp::NOT) {
+        compileBranch(static_cast<const Unary*>(expr)->operand, !jumpIf, jumps);
+        return;
+    }
+    if (expr->kind == ExprKind::BOOL_OP) {
+        auto boolOp = static_cast<const BoolOp*>(expr);
+        bool isOr = boolOp->op == LogicOp::OR;
+        size_t last = boolOp->operands.size - 1;
+        if (jumpIf == isOr) {
+            // Any deciding operand takes the jump
+            for (const Expr* operand : boolOp->operands) compileBranch(operand, jumpIf, jumps);
+            return;
+        }
+        std::vector<size_t> skip;
+        for (size_t i = 0; i < last; i++) compileBranch(boolOp->operands[i], isOr, skip);
+        compileBranch(boolOp->operands[last], jumpIf, jumps);
+        for (size_t at : skip) patch(at);
+        return;
+    }
+    uint16_t mark = scope->top;
+    uint16_t reg = compileExpr(expr);
+    scope->top = mark;
+    jumps.push_back(emit(jumpIf ? Opcode::JUMPIF : Opcode::JUMPIFNOT, reg));
+}
+
+// ============ Helpers ============
+
+Compiler::Storage Compiler::storageOf(Symbol name, int32_t slot) const {
+    if (slot == NO_SLOT) return Storage::GLOBAL;
+    size_t paramCount = scope->inlined ? scope->inlined->paramCount : scope->paramCount;
+    if (static_cast<size_t>(slot) < paramCount || !moduleAssigned[name]) return Storage::REGISTER;
+    return Storage::NAME;
+}
+
+// Local slots of an inlined body are offset to its registers
+uint16_t Compiler::registerOf(int32_t slot) const {
+    return scope->inlined ? scope->inlined->base + slot : slot;
+}
+
+bool Compiler::isTemporary(uint16_t reg) const {
+    if (reg < scope->proto->localCount) return false;
+    const Inline* body = scope->inlined;
+    return !body || reg < body->base || reg >= body->base + body->localCount;
+}
+
+void Compiler::storeTarget(const Target& target, uint16_t src) {
+    if (target.name == NO_SYMBOL) return;
+    switch (storageOf(target.name, target.slot)) {
+        case Storage::REGISTER:
+            if (src != registerOf(target.slot)) emit(Opcode::MOVE, registerOf(target.slot), src);
+            break;
+        case Storage::GLOBAL:
+            emit(Opcode::SETGLOBAL, src, 0, 0, target.name);
+            break;
+        case Storage::NAME:
+            emit(Opcode::SETNAME, src, target.slot, 0, target.name);
+            break;
+    }
+}
+
+size_t Compiler::emit(Opcode op, uint16_t a, uint16_t b, uint16_t c, uint32_t d, uint8_t x) {
+    scope->proto->code.push_back(Instr{op, x, a, b, c, d});
+    return scope->proto->code.size() - 1;
+}
+
+void Compiler::patch(size_t at) {
+    scope->proto->code[at].d = here();
+}
+
+uint16_t Compiler::allocTemp() {
+    uint16_t reg = scope->top++;
+    if (scope->top > scope->proto->frameSize) scope->proto->frameSize = scope->top;
+    return reg;
+}
+
+uint32_t Compiler::addConstant(const Value& value) {
+    program->constants.push_back(value);
+    return program->constants.size() - 1;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_COMPILER_H
+#define PYTHON_INTERPRETER_COMPILER_H
+
+#include "Ast.h"
+#include "Bytecode.h"
+#include <memory>
+#include <vector>
+
+// Compiles a resolved AST into register bytecode.
+//
+// Parameters, and locals whose name is never assigned at module level, can
+// not alias a global and live purely in registers. The remaining locals go
+// through GETNAME / SETNAME, which implement the global fallback of unbound
+// locals at run time.
+//
+// Calls in loops and function bodies of small functions with a single def
+// at module level are inlined when that def has certainly run: the callee's
+// body is compiled into the caller, its locals in fresh registers.
+class Compiler {
+public:
+    explicit Compiler(const ast::Program& source);
+
+    std::unique_ptr<BytecodeProgram> compile();
+
+private:
+    enum class Storage { GLOBAL, REGISTER, NAME };
+
+    struct Loop {
+        size_t start;
+        std::vector<size_t> breaks;
+    };
+
+    // Body of a function being compiled into its caller
+    struct Inline {
+        uint16_t base;// register of the callee's local slot 0
+        uint16_t localCount;
+        size_t paramCount;
+        uint16_t result;
+        std::vector<size_t> returns;// jumps to the end of the body
+    };
+
+    // Function currently being compiled
+    struct Scope {
+        FunctionProto* proto;
+        size_t paramCount;
+        uint16_t top;// first free temporary register
+        std::vector<Loop> loops;
+        Inline* inlined = nullptr;
+    };
+
+    const ast::Program& source;
+    std::unique_ptr<BytecodeProgram> program;
+    std::vector<char> moduleAssigned;// by symbol
+    std::vector<const ast::FuncDef*> inlinable;// by symbol, nullptr if not
+    std::vector<size_t> definedAt;// by symbol, module statement of the single def
+    size_t statement = 0;// module statement being compiled
+    Scope* scope = nullptr;
+    uint32_t noneConstant = 0;
+    uint32_t falseConstant = 0;
+    uint32_t separatorConstant = 0;
+
+    uint32_t compileFunction(const ast::FuncDef* def);
+
+    void compileBlock(ast::Span<ast::Stmt*> body);
+    void compileStmt(const ast::Stmt* stmt);
+    void compileAssign(const ast::Assign* stmt);
+    void compileAugAssign(const ast::AugAssign* stmt);
+    void compileIf(const ast::If* stmt);
+    void compileWhile(const ast::While* stmt);
+    void compileReturn(const ast::Expr* value);
+
+    uint16_t compileExpr(const ast::Expr* expr, int dst = -1);
+    uint16_t compileCompare(const ast::Compare* expr, int dst);
+    uint16_t compileBoolOp(const ast::BoolOp* expr, int dst);
+    uint16_t compileCall(const ast::Call* expr, int dst);
+    uint16_t compileInline(const ast::Call* expr, const ast::FuncDef* def, int dst);
+    uint16_t compileFormat(const ast::FormatString* expr, int dst);
+    void compileBranch(const ast::Expr* expr, bool jumpIf, std::vector<size_t>& jumps);
+
+    Storage storageOf(ast::Symbol name, int32_t slot) const;
+    uint16_t registerOf(int32_t slot) const;
+    bool isTemporary(uint16_t reg) const;
+    void storeTarget(const ast::Target& target, uint16_t src);
+
+    size_t emit(Opcode op, uint16_t a = 0, uint16_t b = 0, uint16_t c = 0, uint32_t d = 0, uint8_t x = 0);
+    void patch(size_t at);
+    size_t here() const { return scope->proto->code.size(); }
+    uint16_t allocTemp();
+    uint16_t resultRegister(int dst) { return dst >= 0 ? dst : allocTemp(); }
+    uint32_t addConstant(const Value& value);
+};
+
+#endif//PYTHON_INTERPRETER_COMPILER_H
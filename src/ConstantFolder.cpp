@@ -0,0 +1,237 @@
+#include "ConstantFolder.h"
+#include "Operators.h"
+
+using namespace ast;
+
+namespace {
+
+// Longest string repetition worth materialising at compile time; longer
+// results are left to run time, where the code may never execute
+constexpr double MAX_FOLDED_STRING = 4096;
+
+class ConstantFolder {
+public:
+    explicit ConstantFolder(Program& program) : program(program) {}
+
+    Span<Stmt*> foldBlock(Span<Stmt*> body) {
+        std::vector<Stmt*> kept;
+        for (Stmt* stmt : body) foldStmt(stmt, kept);
+        if (kept.size() == body.size) {
+            for (size_t i = 0; i < kept.size(); i++) body[i] = kept[i];
+            return body;
+        }
+        return copyToArena(program.arena, kept);
+    }
+
+private:
+    Program& program;
+
+    const Value* constantOf(const Expr* expr) const {
+        if (expr->kind != ExprKind::CONSTANT) return nullptr;
+        return &program.constants[static_cast<const Constant*>(expr)->index];
+    }
+
+    Expr* makeConstant(const Value& value) {
+        auto constant = program.make<Constant>();
+        constant->index = program.addConstant(value);
+        return constant;
+    }
+
+    // Appends stmt, or whatever is left of it, to out
+    void foldStmt(Stmt* stmt, std::vector<Stmt*>& out) {
+        switch (stmt->kind) {
+            case StmtKind::EXPR: {
+                auto exprStmt = static_cast<ExprStmt*>(stmt);
+                exprStmt->value = foldExpr(exprStmt->value);
+                break;
+            }
+            case StmtKind::ASSIGN:
+                for (Expr*& value : static_cast<Assign*>(stmt)->values) value = foldExpr(value);
+                break;
+            case StmtKind::AUG_ASSIGN: {
+                auto assign = static_cast<AugAssign*>(stmt);
+                assign->value = foldExpr(assign->value);
+                break;
+            }
+            case StmtKind::IF:
+                foldIf(static_cast<If*>(stmt), out);
+                return;
+            case StmtKind::WHILE: {
+                auto loop = static_cast<While*>(stmt);
+                loop->condition = foldExpr(loop->condition);
+                const Value* condition = constantOf(loop->condition);
+                if (condition && !condition->toBool()) return;
+                loop->body = foldBlock(loop->body);
+                break;
+            }
+            case StmtKind::FUNCDEF: {
+                auto def = static_cast<FuncDef*>(stmt);
+                for (Expr*& value : def->defaults) value = foldExpr(value);
+                def->body = foldBlock(def->body);
+                break;
+            }
+            case StmtKind::RETURN: {
+                auto ret = static_cast<Return*>(stmt);
+                if (ret->value) ret->value = foldExpr(ret->value);
+                break;
+            }
+            case StmtKind::BREAK:
+            case StmtKind::CONTINUE:
+                break;
+        }
+        out.push_back(stmt);
+    }
+
+    // Branches whose condition is constantly false disappear; a constantly
+    // true one becomes the else block and ends the chain. Conditions before
+    // it are still evaluated. With no branch left the statement is replaced
+    // by its else block.
+    void foldIf(If* stmt, std::vector<Stmt*>& out) {
+        std::vector<IfBranch> branches;
+        Span<Stmt*> orelse = stmt->orelse;
+        bool decided = false;
+        for (IfBranch branch : stmt->branches) {
+            branch.condition = foldExpr(branch.condition);
+            const Value* condition = constantOf(branch.condition);
+            if (condition && !condition->toBool()) continue;
+            branch.body = foldBlock(branch.body);
+            if (condition) {
+                orelse = branch.body;
+                decided = true;
+                break;
+            }
+            branches.push_back(branch);
+        }
+        if (!decided) orelse = foldBlock(orelse);
+        if (branches.empty()) {
+            out.insert(out.end(), orelse.begin(), orelse.end());
+            return;
+        }
+        stmt->branches = copyToArena(program.arena, branches);
+        stmt->orelse = orelse;
+        out.push_back(stmt);
+    }
+
+    Expr* foldExpr(Expr* expr) {
+        switch (expr->kind) {
+            case ExprKind::CONSTANT:
+            case ExprKind::NAME:
+                return expr;
+            case ExprKind::UNARY:
+                return foldUnary(static_cast<Unary*>(expr));
+            case ExprKind::BINARY:
+                return foldBinary(static_cast<Binary*>(expr));
+            case ExprKind::COMPARE:
+                return foldCompare(static_cast<Compare*>(expr));
+            case ExprKind::BOOL_OP:
+                return foldBoolOp(static_cast<BoolOp*>(expr));
+            case ExprKind::CALL:
+                for (Argument& arg : static_cast<Call*>(expr)->args) arg.value = foldExpr(arg.value);
+                return expr;
+            case ExprKind::FORMAT:
+                return foldFormat(static_cast<FormatString*>(expr));
+        }
+        return expr;
+    }
+
+    Expr* foldUnary(Unary* expr) {
+        expr->operand = foldExpr(expr->operand);
+        const Value* operand = constantOf(expr->operand);
+        if (!operand) return expr;
+        switch (expr->op) {
+            case UnaryOp::NEG: return makeConstant(-*operand);
+            case UnaryOp::NOT: return makeConstant(Value(!operand->toBool()));
+            case UnaryOp::POS: return expr->operand;
+        }
+        return expr;
+    }
+
+    Expr* foldBinary(Binary* expr) {
+        expr->lhs = foldExpr(expr->lhs);
+        expr->rhs = foldExpr(expr->rhs);
+        const Value* lhs = constantOf(expr->lhs);
+        const Value* rhs = constantOf(expr->rhs);
+        if (!lhs || !rhs || !foldable(expr->op, *lhs, *rhs)) return expr;
+        return makeConstant(applyBinary(expr->op, *lhs, *rhs));
+    }
+
+    // Leaves the operations that fail or get expensive to run time
+    static bool foldable(BinaryOp op, const Value& lhs, const Value& rhs) {
+        bool division = op == BinaryOp::DIV || op == BinaryOp::FLOORDIV || op == BinaryOp::MOD;
+        if (division && rhs.type != ValueType::STRING && !rhs.toBool()) return false;
+        if (op == BinaryOp::MUL && (lhs.type == ValueType::STRING || rhs.type == ValueType::STRING)) {
+            const Value& text = lhs.type == ValueType::STRING ? lhs : rhs;
+            const Value& count = lhs.type == ValueType::STRING ? rhs : lhs;
+            double repeat = count.type == ValueType::INT ? count.intVal.toDouble() : count.type == ValueType::BOOL;
+            return repeat * text.stringVal.size() <= MAX_FOLDED_STRING;
+        }
+        return true;
+    }
+
+    Expr* foldCompare(Compare* expr) {
+        bool constant = true;
+        for (Expr*& operand : expr->operands) {
+            operand = foldExpr(operand);
+            constant = constant && constantOf(operand);
+        }
+        if (!constant) return expr;
+        bool result = true;
+        for (size_t i = 0; result && i < expr->ops.size; i++) {
+            result = applyCompare(expr->ops[i], *constantOf(expr->operands[i]), *constantOf(expr->operands[i + 1]));
+        }
+        return makeConstant(Value(result));
+    }
+
+    // Leading constants either decide the result, which drops the operands
+    // after them, or are passed over and can be dropped themselves
+    Expr* foldBoolOp(BoolOp* expr) {
+        bool isOr = expr->op == LogicOp::OR;
+        std::vector<Expr*> operands;
+        for (size_t i = 0; i < expr->operands.size; i++) {
+            Expr* operand = foldExpr(expr->operands[i]);
+            const Value* constant = constantOf(operand);
+            bool last = i + 1 == expr->operands.size;
+            if (operands.empty() && constant && !last) {
+                if (constant->toBool() == isOr) return operand;
+                continue;
+            }
+            operands.push_back(operand);
+        }
+        if (operands.size() == 1) return operands[0];
+        expr->operands = copyToArena(program.arena, operands);
+        return expr;
+    }
+
+    Expr* foldFormat(FormatString* expr) {
+        bool constant = true;
+        for (FormatPart& part : expr->parts) {
+            for (Expr*& value : part.values) {
+                value = foldExpr(value);
+                constant = constant && constantOf(value);
+            }
+        }
+        if (!constant) return expr;
+        std::string text;
+        for (const FormatPart& part : expr->parts) {
+            if (part.literal != NO_CONSTANT) {
+                text += program.constants[part.literal].stringVal;
+                continue;
+            }
+            for (size_t i = 0; i < part.values.size; i++) {
+                if (i > 0) text += ", ";
+                text += constantOf(part.values[i])->toString();
+            }
+        }
+        return makeConstant(Value(text));
+    }
+};
+
+}// namespace
+
+void foldConstants(Program& program) {
+    program.body = ConstantFolder(program).foldBlock(program.body);
+}
+
+void foldFunction(Program& program, FuncDef* def) {
+    def->body = ConstantFolder(program).foldBlock(def->body);
+}
@@ -0,0 +1,19 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_CONSTANTFOLDER_H
+#define PYTHON_INTERPRETER_CONSTANTFOLDER_H
+
+#include "Ast.h"
+
+// Evaluates operators whose operands are all constants once, ahead of time,
+// with the same Value operations the engines use, and drops the if / elif
+// branches and while loops whose condition is a constant that never lets
+// them run. Calls are never folded, so their side effects stay in place.
+//
+// Runs after resolveScopes: removed code keeps its local slots, which is
+// harmless since the dead assignments could not have bound them anyway.
+void foldConstants(ast::Program& program);
+
+// Folds the body of one def of the program, after it was parsed late
+void foldFunction(ast::Program& program, ast::FuncDef* def);
+
+#endif//PYTHON_INTERPRETER_CONSTANTFOLDER_H
@@ -0,0 +1,685 @@
+#include "DescentParser.h"
+#include "Python3Lexer.h"
+#include <iostream>
+
+using namespace ast;
+
+namespace {
+
+constexpr size_t TOKEN_EOF = antlr4::Token::EOF;
+
+size_t setIndex(size_t type) {
+    return type == TOKEN_EOF ? 0 : type;
+}
+
+template <typename... Types>
+std::bitset<128> tokenSet(Types... types) {
+    std::bitset<128> set;
+    (set.set(setIndex(types)), ...);
+    return set;
+}
+
+// Tokens that can start a factor, a test, a statement and a suite, and
+// the other tokens that are expected at those points
+const std::bitset<128> FIRST_FACTOR =
+        tokenSet(Python3Lexer::STRING, Python3Lexer::NUMBER, Python3Lexer::NONE, Python3Lexer::TRUE,
+                 Python3Lexer::FALSE, Python3Lexer::NAME, Python3Lexer::OPEN_PAREN, Python3Lexer::ADD,
+                 Python3Lexer::MINUS, Python3Lexer::FORMAT_QUOTATION);
+const std::bitset<128> FIRST_TEST = FIRST_FACTOR | tokenSet(Python3Lexer::NOT);
+const std::bitset<128> FIRST_SIMPLE_STMT =
+        FIRST_TEST | tokenSet(Python3Lexer::RETURN, Python3Lexer::BREAK, Python3Lexer::CONTINUE);
+const std::bitset<128> FIRST_STMT =
+        FIRST_SIMPLE_STMT | tokenSet(Python3Lexer::DEF, Python3Lexer::IF, Python3Lexer::WHILE);
+const std::bitset<128> FIRST_SUITE = FIRST_SIMPLE_STMT | tokenSet(Python3Lexer::NEWLINE);
+const std::bitset<128> FILE_LEVEL = FIRST_STMT | tokenSet(TOKEN_EOF, Python3Lexer::NEWLINE);
+const std::bitset<128> BLOCK_LEVEL = FIRST_STMT | tokenSet(Python3Lexer::DEDENT);
+const std::bitset<128> AFTER_SIMPLE_STMT =
+        FILE_LEVEL | tokenSet(Python3Lexer::DEDENT, Python3Lexer::ELIF, Python3Lexer::ELSE);
+const std::bitset<128> AFTER_FUNCTION_NAME = tokenSet(Python3Lexer::OPEN_PAREN);
+const std::bitset<128> FIRST_PARAMETERS = tokenSet(Python3Lexer::NAME, Python3Lexer::CLOSE_PAREN);
+const std::bitset<128> AFTER_PARAMETER_NAME =
+        tokenSet(Python3Lexer::ASSIGN, Python3Lexer::COMMA, Python3Lexer::CLOSE_PAREN);
+const std::bitset<128> ARGUMENT_OR_CLOSE = FIRST_TEST | tokenSet(Python3Lexer::CLOSE_PAREN);
+const std::bitset<128> FORMAT_PARTS =
+        tokenSet(Python3Lexer::FORMAT_STRING_LITERAL, Python3Lexer::OPEN_BRACE, Python3Lexer::QUOTATION);
+
+// The generated lexer's vocabulary names tokens in messages, as it does for
+// Python3Parser. It is only needed once there is an error to report.
+const antlr4::dfa::Vocabulary& vocabulary() {
+    static antlr4::ANTLRInputStream input;
+    static Python3Lexer lexer(&input);
+    return static_cast<const antlr4::Recognizer&>(lexer).getVocabulary();
+}
+
+std::string tokenName(size_t type) {
+    return type == TOKEN_EOF ? "<EOF>" : vocabulary().getDisplayName(type);
+}
+
+std::string setNames(const std::bitset<128>& set) {
+    std::string names;
+    for (size_t i = 0; i < set.size(); i++) {
+        if (!set.test(i)) continue;
+        if (!names.empty()) names += ", ";
+        names += tokenName(i == 0 ? TOKEN_EOF : i);
+    }
+    return set.count() > 1 ? "{" + names + "}" : names;
+}
+
+// A token as DefaultErrorStrategy::getTokenErrorDisplay shows it
+std::string display(const PyToken& token) {
+    std::string text(token.text);
+    if (text.empty()) text = token.type == TOKEN_EOF ? "<EOF>" : "<" + std::to_string(token.type) + ">";
+    std::string escaped;
+    for (char c : text) {
+        if (c == '\n') escaped += "\\n";
+        else if (c == '\r') escaped += "\\r";
+        else if (c == '\t') escaped += "\\t";
+        else escaped += c;
+    }
+    return "'" + escaped + "'";
+}
+
+bool isAugassign(size_t type) {
+    switch (type) {
+        case Python3Lexer::ADD_ASSIGN:
+        case Python3Lexer::SUB_ASSIGN:
+        case Python3Lexer::MULT_ASSIGN:
+        case Python3Lexer::DIV_ASSIGN:
+        case Python3Lexer::IDIV_ASSIGN:
+        case Python3Lexer::MOD_ASSIGN: return true;
+        default: return false;
+    }
+}
+
+bool isCompareOp(size_t type) {
+    switch (type) {
+        case Python3Lexer::LESS_THAN:
+        case Python3Lexer::GREATER_THAN:
+        case Python3Lexer::EQUALS:
+        case Python3Lexer::GT_EQ:
+        case Python3Lexer::LT_EQ:
+        case Python3Lexer::NOT_EQ_2: return true;
+        default: return false;
+    }
+}
+
+BinaryOp binaryOp(size_t tokenType) {
+    switch (tokenType) {
+        case Python3Lexer::ADD:
+        case Python3Lexer::ADD_ASSIGN: return BinaryOp::ADD;
+        case Python3Lexer::MINUS:
+        case Python3Lexer::SUB_ASSIGN: return BinaryOp::SUB;
+        case Python3Lexer::STAR:
+        case Python3Lexer::MULT_ASSIGN: return BinaryOp::MUL;
+        case Python3Lexer::DIV:
+        case Python3Lexer::DIV_ASSIGN: return BinaryOp::DIV;
+        case Python3Lexer::IDIV:
+        case Python3Lexer::IDIV_ASSIGN: return BinaryOp::FLOORDIV;
+        default: return BinaryOp::MOD;
+    }
+}
+
+CompareOp compareOp(size_t tokenType) {
+    switch (tokenType) {
+        case Python3Lexer::LESS_THAN: return CompareOp::LT;
+        case Python3Lexer::GREATER_THAN: return CompareOp::GT;
+        case Python3Lexer::LT_EQ: return CompareOp::LE;
+        case Python3Lexer::GT_EQ: return CompareOp::GE;
+        case Python3Lexer::EQUALS: return CompareOp::EQ;
+        default: return CompareOp::NE;
+    }
+}
+
+}// namespace
+
+void DescentParser::parse() {
+    std::vector<Stmt*> body;
+    parseStatements(body, false);
+    program.body = copyToArena(program.arena, body);
+}
+
+void DescentParser::parseRange(size_t begin, size_t limit) {
+    pos = begin;
+    end = limit;
+    parse();
+}
+
+void DescentParser::parseBody(FuncDef* def) {
+    size_t resume = pos;
+    pos = def->lazyBody;
+    def->lazyBody = 0;
+    bareName = nullptr;
+    recovering = false;
+    try {
+        def->body = parseSuite();
+    } catch (const SyntaxError&) {
+    }
+    pos = resume;
+}
+
+bool DescentParser::parseNext(std::vector<Stmt*>& out) {
+    if (scanner && pos > 0) {
+        scanner->discard(pos);
+        discarded += pos;
+        pos = 0;
+    }
+    while (la() == Python3Lexer::NEWLINE) pos++;
+    if (la() == TOKEN_EOF) return false;
+    parseStatement(out, false, discarded + pos == 0);
+    return true;
+}
+
+size_t DescentParser::la(size_t k) {
+    size_t index = pos + k - 1;
+    if (index >= end) return TOKEN_EOF;
+    while (index >= tokens.size() && scanner && scanner->scan()) {}
+    return index < tokens.size() ? tokens[index].type : TOKEN_EOF;
+}
+
+const PyToken& DescentParser::consume() {
+    const PyToken& token = tokens[pos];
+    recovering = false;
+    if (token.type != TOKEN_EOF && pos < end) pos++;
+    return token;
+}
+
+const PyToken& DescentParser::expect(size_t type, const TokenSet* follow) {
+    if (la() == type) return consume();
+
+    // Like ANTLR's recoverInline: drop one stray token, or assume a missing
+    // one when the current token could follow it
+    PyToken token = tokens[pos];// copied, as looking ahead may scan more tokens
+    if (la(2) == type) {
+        report(token, "extraneous input " + display(token) + " expecting " + tokenName(type));
+        pos++;
+        return consume();
+    }
+    if (follow && follow->test(setIndex(la()))) {
+        report(token, "missing " + tokenName(type) + " at " + display(token));
+        conjured = PyToken{type, {}, token.line, token.column, token.offset};
+        return conjured;
+    }
+    report(token, "mismatched input " + display(token) + " expecting " + tokenName(type));
+    throw SyntaxError();
+}
+
+void DescentParser::expectStart(const TokenSet& first) {
+    if (first.test(setIndex(la()))) return;
+    PyToken token = tokens[pos];// copied, as looking ahead may scan more tokens
+    if (first.test(setIndex(la(2)))) {
+        report(token, "extraneous input " + display(token) + " expecting " + setNames(first));
+        pos++;
+        return;
+    }
+    report(token, "mismatched input " + display(token) + " expecting " + setNames(first));
+    throw SyntaxError();
+}
+
+void DescentParser::report(const PyToken& token, const std::string& message) {
+    if (recovering) return;
+    recovering = true;
+    errors++;
+    if (quiet) return;
+    std::cerr << "line " << token.line << ":" << token.column << " " << message << std::endl;
+}
+
+void DescentParser::skipStatement() {
+    // Lines only start or end blocks at their beginning, so skipping to the
+    // end of the line and over any block it opens keeps INDENT and DEDENT
+    // balanced for the statements around it
+    while (la() != Python3Lexer::NEWLINE && la() != Python3Lexer::INDENT && la() != Python3Lexer::DEDENT &&
+           la() != TOKEN_EOF) {
+        pos++;
+    }
+    if (la() == Python3Lexer::NEWLINE) pos++;
+    if (la() != Python3Lexer::INDENT) return;
+    size_t depth = 0;
+    do {
+        if (la() == Python3Lexer::INDENT) depth++;
+        if (la() == Python3Lexer::DEDENT) depth--;
+        pos++;
+    } while (depth > 0 && la() != TOKEN_EOF);
+}
+
+void DescentParser::parseStatements(std::vector<Stmt*>& out, bool block) {
+    size_t first = pos;
+    while (la() != TOKEN_EOF && !(block && la() == Python3Lexer::DEDENT)) {
+        if (!block && la() == Python3Lexer::NEWLINE) {
+            pos++;
+            continue;
+        }
+        parseStatement(out, block, pos == first);
+    }
+}
+
+void DescentParser::parseStatement(std::vector<Stmt*>& out, bool block, bool first) {
+    size_t start = pos;
+    try {
+        parseStmt(out, block ? BLOCK_LEVEL : FILE_LEVEL, first);
+    } catch (const SyntaxError&) {
+        if (pos == start && la() != TOKEN_EOF && !(block && la() == Python3Lexer::DEDENT)) pos++;
+        while (!AFTER_SIMPLE_STMT.test(setIndex(la()))) pos++;
+    }
+}
+
+void DescentParser::parseStmt(std::vector<Stmt*>& out, const TokenSet& expected, bool first) {
+    if (first) {
+        expectStart(expected);
+    } else if (!expected.test(setIndex(la()))) {
+        // Like ANTLR's sync between loop iterations: report the stray token
+        // and skip to something that can come next, which may end the loop
+        report(tokens[pos], "extraneous input " + display(tokens[pos]) + " expecting " + setNames(expected));
+        while (!expected.test(setIndex(la())) && la() != TOKEN_EOF) pos++;
+    }
+    if (!FIRST_STMT.test(setIndex(la()))) return;
+    Stmt* stmt;
+    switch (la()) {
+        case Python3Lexer::IF: stmt = parseIf(); break;
+        case Python3Lexer::WHILE: stmt = parseWhile(); break;
+        case Python3Lexer::DEF: stmt = parseFuncdef(); break;
+        default: stmt = parseSimpleStmt(); break;
+    }
+    if (stmt) out.push_back(stmt);
+}
+
+Span<Stmt*> DescentParser::parseSuite() {
+    std::vector<Stmt*> body;
+    if (la() == Python3Lexer::NEWLINE) {
+        consume();
+        expect(Python3Lexer::INDENT, &FIRST_STMT);
+        parseStatements(body, true);
+        expect(Python3Lexer::DEDENT, &AFTER_SIMPLE_STMT);
+    } else {
+        expectStart(FIRST_SUITE);
+        if (Stmt* stmt = parseSimpleStmt()) body.push_back(stmt);
+    }
+    return copyToArena(program.arena, body);
+}
+
+Stmt* DescentParser::parseSimpleStmt() {
+    Stmt* stmt;
+    switch (la()) {
+        case Python3Lexer::BREAK:
+            consume();
+            stmt = program.make<Break>();
+            break;
+        case Python3Lexer::CONTINUE:
+            consume();
+            stmt = program.make<Continue>();
+            break;
+        case Python3Lexer::RETURN: stmt = parseReturn(); break;
+        default: stmt = parseExprStmt(); break;
+    }
+    try {
+        expect(Python3Lexer::NEWLINE, &AFTER_SIMPLE_STMT);
+    } catch (const SyntaxError&) {
+        // Python3Parser's simple_stmt keeps what it parsed before the stray
+        // token and resumes at the next token that could follow it
+        while (!AFTER_SIMPLE_STMT.test(setIndex(la()))) pos++;
+    }
+    return stmt;
+}
+
+Stmt* DescentParser::parseExprStmt() {
+    std::vector<Expr*> tests;
+    std::vector<Symbol> names;
+    parseTestlist(tests, &names);
+    if (!isAugassign(la()) && la() != Python3Lexer::ASSIGN && la() != Python3Lexer::NEWLINE) {
+        // Python3Parser predicts which expr_stmt alternative follows here.
+        // Failing that it keeps the testlist, as at the end of input that
+        // has no final newline, and resumes where a statement could follow.
+        report(tokens[pos], "no viable alternative at input " + display(tokens[pos]));
+        while (!AFTER_SIMPLE_STMT.test(setIndex(la()))) pos++;
+        auto stmt = program.make<ExprStmt>();
+        stmt->value = tests[0];
+        return stmt;
+    }
+
+    if (isAugassign(la())) {
+        BinaryOp op = binaryOp(consume().type);
+        std::vector<Expr*> values;
+        parseTestlist(values);
+        // Only a single plain name can be augmented; anything else is a no-op
+        if (names.size() != 1 || names[0] == NO_SYMBOL) return nullptr;
+
+        auto stmt = program.make<AugAssign>();
+        stmt->op = op;
+        stmt->target = Target{names[0], NO_SLOT};
+        stmt->value = values[0];
+        return stmt;
+    }
+
+    if (la() != Python3Lexer::ASSIGN) {
+        // Plain expression; like a testlist anywhere else it yields its first test
+        auto stmt = program.make<ExprStmt>();
+        stmt->value = tests[0];
+        return stmt;
+    }
+
+    std::vector<Span<Target>> targets;
+    while (la() == Python3Lexer::ASSIGN) {
+        consume();
+        std::vector<Target> lhs;
+        for (Symbol name : names) lhs.push_back(Target{name, NO_SLOT});
+        targets.push_back(copyToArena(program.arena, lhs));
+        tests.clear();
+        names.clear();
+        parseTestlist(tests, &names);
+    }
+    auto stmt = program.make<Assign>();
+    stmt->targets = copyToArena(program.arena, targets);
+    stmt->values = copyToArena(program.arena, tests);
+    return stmt;
+}
+
+Stmt* DescentParser::parseReturn() {
+    consume();
+    auto stmt = program.make<Return>();
+    if (FIRST_TEST.test(setIndex(la()))) {
+        std::vector<Expr*> tests;
+        parseTestlist(tests);
+        stmt->value = tests[0];
+    }
+    return stmt;
+}
+
+Stmt* DescentParser::parseIf() {
+    std::vector<IfBranch> branches;
+    do {
+        consume();// 'if' or 'elif'
+        Expr* condition = parseTest();
+        expect(Python3Lexer::COLON, &FIRST_SUITE);
+        branches.push_back(IfBranch{condition, parseSuite()});
+    } while (la() == Python3Lexer::ELIF);
+
+    auto stmt = program.make<If>();
+    stmt->branches = copyToArena(program.arena, branches);
+    if (la() == Python3Lexer::ELSE) {
+        consume();
+        expect(Python3Lexer::COLON, &FIRST_SUITE);
+        stmt->orelse = parseSuite();
+    }
+    return stmt;
+}
+
+Stmt* DescentParser::parseWhile() {
+    consume();
+    auto stmt = program.make<While>();
+    stmt->condition = parseTest();
+    expect(Python3Lexer::COLON, &FIRST_SUITE);
+    stmt->body = parseSuite();
+    return stmt;
+}
+
+Stmt* DescentParser::parseFuncdef() {
+    consume();
+    std::string_view name = expect(Python3Lexer::NAME, &AFTER_FUNCTION_NAME).text;
+    expect(Python3Lexer::OPEN_PAREN, &FIRST_PARAMETERS);
+    expectStart(FIRST_PARAMETERS);
+
+    std::vector<Symbol> params;
+    std::vector<Expr*> defaults;
+    if (la() == Python3Lexer::NAME) {
+        while (true) {
+            params.push_back(
+                    program.symbols.intern(std::string(expect(Python3Lexer::NAME, &AFTER_PARAMETER_NAME).text)));
+            if (la() == Python3Lexer::ASSIGN) {
+                consume();
+                defaults.push_back(parseTest());
+            }
+            if (la() != Python3Lexer::COMMA) break;
+            consume();
+        }
+    }
+    expect(Python3Lexer::CLOSE_PAREN);
+    expect(Python3Lexer::COLON, &FIRST_SUITE);
+
+    auto stmt = program.make<FuncDef>();
+    stmt->name = program.symbols.intern(std::string(name));
+    stmt->params = copyToArena(program.arena, params);
+    stmt->defaults = copyToArena(program.arena, defaults);
+    if (lazyBodies && la() == Python3Lexer::NEWLINE && la(2) == Python3Lexer::INDENT) {
+        // Only the block is left of the statement, and skipped whole;
+        // bodies on the line of the def are parsed at once
+        stmt->lazyBody = pos;
+        skipStatement();
+    } else {
+        stmt->body = parseSuite();
+    }
+    stmt->localCount = params.size();
+    return stmt;
+}
+
+void DescentParser::parseTestlist(std::vector<Expr*>& tests, std::vector<Symbol>* names) {
+    while (true) {
+        tests.push_back(parseTest());
+        if (names) names->push_back(targetName(tests.back()));
+        if (la() != Python3Lexer::COMMA) return;
+        consume();
+        // A trailing comma ends the list
+        if (!FIRST_TEST.test(setIndex(la()))) return;
+    }
+}
+
+Expr* DescentParser::parseTest() {
+    Expr* first = parseAndTest();
+    if (la() != Python3Lexer::OR) return first;
+
+    std::vector<Expr*> operands{first};
+    while (la() == Python3Lexer::OR) {
+        consume();
+        operands.push_back(parseAndTest());
+    }
+    auto expr = program.make<BoolOp>();
+    expr->op = LogicOp::OR;
+    expr->operands = copyToArena(program.arena, operands);
+    return expr;
+}
+
+Expr* DescentParser::parseAndTest() {
+    Expr* first = parseNotTest();
+    if (la() != Python3Lexer::AND) return first;
+
+    std::vector<Expr*> operands{first};
+    while (la() == Python3Lexer::AND) {
+        consume();
+        operands.push_back(parseNotTest());
+    }
+    auto expr = program.make<BoolOp>();
+    expr->op = LogicOp::AND;
+    expr->operands = copyToArena(program.arena, operands);
+    return expr;
+}
+
+Expr* DescentParser::parseNotTest() {
+    expectStart(FIRST_TEST);
+    if (la() != Python3Lexer::NOT) return parseComparison();
+
+    consume();
+    auto expr = program.make<Unary>();
+    expr->op = UnaryOp::NOT;
+    expr->operand = parseNotTest();
+    return expr;
+}
+
+Expr* DescentParser::parseComparison() {
+    Expr* first = parseArithExpr();
+    if (!isCompareOp(la())) return first;
+
+    std::vector<Expr*> operands{first};
+    std::vector<CompareOp> ops;
+    while (isCompareOp(la())) {
+        ops.push_back(compareOp(consume().type));
+        expectStart(FIRST_FACTOR);
+        operands.push_back(parseArithExpr());
+    }
+    auto expr = program.make<Compare>();
+    expr->operands = copyToArena(program.arena, operands);
+    expr->ops = copyToArena(program.arena, ops);
+    return expr;
+}
+
+Expr* DescentParser::parseArithExpr() {
+    Expr* result = parseTerm();
+    while (la() == Python3Lexer::ADD || la() == Python3Lexer::MINUS) {
+        auto expr = program.make<Binary>();
+        expr->op = binaryOp(consume().type);
+        expectStart(FIRST_FACTOR);
+        expr->lhs = result;
+        expr->rhs = parseTerm();
+        result = expr;
+    }
+    return result;
+}
+
+Expr* DescentParser::parseTerm() {
+    Expr* result = parseFactor();
+    while (la() == Python3Lexer::STAR || la() == Python3Lexer::DIV || la() == Python3Lexer::IDIV ||
+           la() == Python3Lexer::MOD) {
+        auto expr = program.make<Binary>();
+        expr->op = binaryOp(consume().type);
+        expectStart(FIRST_FACTOR);
+        expr->lhs = result;
+        expr->rhs = parseFactor();
+        result = expr;
+    }
+    return result;
+}
+
+Expr* DescentParser::parseFactor() {
+    if (la() != Python3Lexer::ADD && la() != Python3Lexer::MINUS) return parseAtomExpr();
+
+    // Unary plus leaves its operand untouched, so only minus needs a node
+    size_t op = consume().type;
+    expectStart(FIRST_FACTOR);
+    Expr* operand = parseFactor();
+    bareName = nullptr;
+    if (op != Python3Lexer::MINUS) return operand;
+    auto expr = program.make<Unary>();
+    expr->op = UnaryOp::NEG;
+    expr->operand = operand;
+    return expr;
+}
+
+Expr* DescentParser::parseAtomExpr() {
+    if (la() == Python3Lexer::NAME && la(2) == Python3Lexer::OPEN_PAREN) {
+        std::string name(consume().text);
+        std::vector<Argument> args;
+        parseArguments(args);
+        auto expr = program.make<Call>();
+        expr->callee = program.symbols.intern(name);
+        expr->builtin = lookupBuiltin(name);
+        expr->args = copyToArena(program.arena, args);
+        return expr;
+    }
+
+    Expr* atom = parseAtom();
+    if (la() != Python3Lexer::OPEN_PAREN) return atom;
+
+    // Only plain names can be called; anything else evaluates to None
+    std::vector<Argument> ignored;
+    parseArguments(ignored);
+    return makeConstant(Value());
+}
+
+Expr* DescentParser::parseAtom() {
+    switch (la()) {
+        case Python3Lexer::NAME: {
+            auto expr = program.make<Name>();
+            expr->name = program.symbols.intern(std::string(consume().text));
+            expr->slot = NO_SLOT;
+            bareName = expr;
+            return expr;
+        }
+        case Python3Lexer::NUMBER: {
+            std::string num(consume().text);
+            if (num.find('.') != std::string::npos) {
+                return makeConstant(Value(std::stod(num)));
+            }
+            return makeConstant(Value(BigInt(num)));
+        }
+        case Python3Lexer::STRING: {
+            std::string result;
+            while (la() == Python3Lexer::STRING) {
+                result += decodeStringLiteral(std::string(consume().text));
+            }
+            return makeConstant(Value(result));
+        }
+        case Python3Lexer::NONE: consume(); return makeConstant(Value());
+        case Python3Lexer::TRUE: consume(); return makeConstant(Value(true));
+        case Python3Lexer::FALSE: consume(); return makeConstant(Value(false));
+        case Python3Lexer::OPEN_PAREN: {
+            consume();
+            Expr* expr = parseTest();
+            expect(Python3Lexer::CLOSE_PAREN);
+            bareName = nullptr;
+            return expr;
+        }
+        case Python3Lexer::FORMAT_QUOTATION: return parseFormatString();
+        default:
+            expectStart(FIRST_FACTOR);
+            return parseAtom();
+    }
+}
+
+void DescentParser::parseArguments(std::vector<Argument>& args) {
+    expect(Python3Lexer::OPEN_PAREN);
+    while (true) {
+        expectStart(ARGUMENT_OR_CLOSE);
+        if (la() == Python3Lexer::CLOSE_PAREN) break;
+        size_t start = pos;
+        Expr* value = parseTest();
+        if (la() == Python3Lexer::ASSIGN) {
+            // The keyword is the text of the test before '=', as getText() gives it
+            std::string keyword;
+            for (size_t i = start; i < pos; i++) keyword += tokens[i].text;
+            consume();
+            args.push_back(Argument{program.symbols.intern(keyword), parseTest()});
+        } else {
+            args.push_back(Argument{NO_SYMBOL, value});
+        }
+        if (la() != Python3Lexer::COMMA) break;
+        consume();
+    }
+    expect(Python3Lexer::CLOSE_PAREN);
+}
+
+Expr* DescentParser::parseFormatString() {
+    consume();
+    std::vector<FormatPart> parts;
+    for (bool first = true;; first = false) {
+        if (first) {
+            expectStart(FORMAT_PARTS);
+        } else if (!FORMAT_PARTS.test(setIndex(la()))) {
+            report(tokens[pos], "extraneous input " + display(tokens[pos]) + " expecting " + setNames(FORMAT_PARTS));
+            while (!FORMAT_PARTS.test(setIndex(la())) && la() != TOKEN_EOF) pos++;
+        }
+        if (la() == Python3Lexer::FORMAT_STRING_LITERAL) {
+            parts.push_back(FormatPart{program.addConstant(Value(std::string(consume().text))), {}});
+        } else if (la() == Python3Lexer::OPEN_BRACE) {
+            consume();
+            std::vector<Expr*> tests;
+            parseTestlist(tests);
+            expect(Python3Lexer::CLOSE_BRACE);
+            parts.push_back(FormatPart{NO_CONSTANT, copyToArena(program.arena, tests)});
+        } else {
+            break;
+        }
+    }
+    expect(Python3Lexer::QUOTATION);
+    auto expr = program.make<FormatString>();
+    expr->parts = copyToArena(program.arena, parts);
+    return expr;
+}
+
+Expr* DescentParser::makeConstant(const Value& value) {
+    auto expr = program.make<Constant>();
+    expr->index = program.addConstant(value);
+    return expr;
+}
+
+Symbol DescentParser::targetName(const Expr* test) {
+    // A target must be a NAME atom on its own, not wrapped in parentheses
+    // or a unary plus
+    return test == bareName ? static_cast<const Name*>(test)->name : NO_SYMBOL;
+}
@@ -0,0 +1,107 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_DESCENTPARSER_H
+#define PYTHON_INTERPRETER_DESCENTPARSER_H
+
+#include "Ast.h"
+#include "Tokenizer.h"
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Recursive-descent parser for the grammar in Python3Parser.g4. It reads
+// the Tokenizer's output and builds the compact AST directly, producing
+// the same program AstBuilder lowers from Python3Parser's tree without
+// allocating a parse tree on the way.
+//
+// The grammar is LL(1) apart from argument and expr_stmt, which look one
+// token past a test. Syntax errors are reported on stderr as ANTLR's
+// ConsoleErrorListener would, and recovered from like DefaultErrorStrategy
+// where that is local: single-token insertion and deletion, skipping stray
+// tokens between statements, and keeping a simple statement cut short by
+// one. Any other error abandons the statement it occurs in, and parsing
+// resumes at the next token that could follow a statement. As in ANTLR,
+// errors after the first go unreported until a token matches again.
+class DescentParser {
+public:
+    DescentParser(const std::vector<PyToken>& tokens, ast::Program& program) : tokens(tokens), program(program) {}
+    // Pulls tokens from the scanner as it goes
+    DescentParser(TokenScanner& scanner, ast::Program& program)
+        : tokens(scanner.tokens()), program(program), scanner(&scanner) {}
+
+    void parse();
+    // Parses the module-level statements in tokens [begin, end) as if the
+    // input ended at end, which must be where a statement starts
+    void parseRange(size_t begin, size_t end);
+    size_t syntaxErrors() const { return errors; }
+    // Counts syntax errors without reporting them
+    void silenceErrors() { quiet = true; }
+
+    // Makes parse() skip the indented body of every def, leaving its token
+    // index in FuncDef::lazyBody for parseBody(). The tokens must outlive
+    // the parser, so this does not work with a scanner.
+    void deferFunctionBodies() { lazyBodies = true; }
+    // Parses a body parse() skipped; defs inside it are deferred in turn
+    void parseBody(ast::FuncDef* def);
+
+    // For running a program as it is parsed: parses the next module-level
+    // statement into out, or returns false at the end of the input. Tokens
+    // before the statement are dropped from the scanner, if there is one.
+    bool parseNext(std::vector<ast::Stmt*>& out);
+    // Type of the token the next statement starts with, or NEWLINE
+    size_t peek() { return la(); }
+
+private:
+    // Token types indexed from 1, with EOF at 0
+    using TokenSet = std::bitset<128>;
+    struct SyntaxError {};// thrown to abandon the current statement
+
+    const std::vector<PyToken>& tokens;
+    ast::Program& program;
+    TokenScanner* scanner = nullptr;
+    size_t pos = 0;
+    size_t end = SIZE_MAX;// tokens from here on read as EOF
+    size_t discarded = 0;// tokens dropped from the front of tokens
+    size_t errors = 0;
+    bool lazyBodies = false;
+    bool quiet = false;
+    bool recovering = false;// an error was reported and no token matched since
+    const ast::Expr* bareName = nullptr;// the last NAME atom, while it stands alone
+    PyToken conjured{};// stands in for the token expect() found missing
+
+    size_t la(size_t k = 1);
+    const PyToken& consume();
+    const PyToken& expect(size_t type, const TokenSet* follow = nullptr);
+    void expectStart(const TokenSet& first);
+    void report(const PyToken& token, const std::string& message);
+    void skipStatement();
+
+    void parseStatements(std::vector<ast::Stmt*>& out, bool block);
+    void parseStatement(std::vector<ast::Stmt*>& out, bool block, bool first);
+    void parseStmt(std::vector<ast::Stmt*>& out, const TokenSet& expected, bool first);
+    ast::Span<ast::Stmt*> parseSuite();
+    ast::Stmt* parseSimpleStmt();
+    ast::Stmt* parseExprStmt();
+    ast::Stmt* parseReturn();
+    ast::Stmt* parseIf();
+    ast::Stmt* parseWhile();
+    ast::Stmt* parseFuncdef();
+
+    void parseTestlist(std::vector<ast::Expr*>& tests, std::vector<ast::Symbol>* names = nullptr);
+    ast::Expr* parseTest();
+    ast::Expr* parseAndTest();
+    ast::Expr* parseNotTest();
+    ast::Expr* parseComparison();
+    ast::Expr* parseArithExpr();
+    ast::Expr* parseTerm();
+    ast::Expr* parseFactor();
+    ast::Expr* parseAtomExpr();
+    ast::Expr* parseAtom();
+    void parseArguments(std::vector<ast::Argument>& args);
+    ast::Expr* parseFormatString();
+
+    ast::Expr* makeConstant(const Value& value);
+    ast::Symbol targetName(const ast::Expr* test);
+};
+
+#endif//PYTHON_INTERPRETER_DESCENTPARSER_H
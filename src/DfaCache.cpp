@@ -0,0 +1,399 @@
+#include "DfaCache.h"
+#include "Python3Parser.h"
+#include "Tokenizer.h"
+#include "antlr4-runtime.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+using namespace antlr4;
+
+namespace {
+
+constexpr char MAGIC[] = "PYDF";
+constexpr size_t MAGIC_SIZE = sizeof(MAGIC) - 1;
+
+// Context ids; saved contexts are numbered from FIRST_CONTEXT
+constexpr uint32_t NO_CONTEXT = UINT32_MAX;// the missing parent of an empty path
+constexpr uint32_t EMPTY_CONTEXT = 0;
+constexpr uint32_t FIRST_CONTEXT = 1;
+// Edge target standing for ATNSimulator::ERROR
+constexpr uint32_t ERROR_STATE = UINT32_MAX;
+
+// 64-bit FNV-1a
+uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= static_cast<const uint8_t*>(data)[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// The DFAs and the ATN they run on, reached through a parser of no input
+struct Grammar {
+    TokenizerSource source{""};
+    CommonTokenStream tokens{&source};
+    Python3Parser parser{&tokens};
+
+    const atn::ATN& atn() const { return parser.getATN(); }
+
+    std::vector<dfa::DFA>& dfas() { return parser.getInterpreter<atn::ParserATNSimulator>()->decisionToDFA; }
+
+    uint64_t fingerprint() const {
+        atn::SerializedATNView serialized = parser.getSerializedATN();
+        uint64_t hash = hashBytes(RuntimeMetaData::VERSION.data(), RuntimeMetaData::VERSION.size());
+        return hashBytes(serialized.data(), serialized.size_bytes(), hash);
+    }
+};
+
+class Writer {
+public:
+    std::string bytes;
+
+    void u8(uint8_t value) { bytes += static_cast<char>(value); }
+
+    void u32(uint32_t value) {
+        for (int i = 0; i < 4; i++) u8(static_cast<uint8_t>(value >> (8 * i)));
+    }
+
+    void u64(uint64_t value) {
+        for (int i = 0; i < 8; i++) u8(static_cast<uint8_t>(value >> (8 * i)));
+    }
+
+    void text(const std::string& value) {
+        u32(value.size());
+        bytes += value;
+    }
+};
+
+class Reader {
+public:
+    Reader(const std::string& bytes, size_t pos, size_t end) : bytes(bytes), pos(pos), end(end) {}
+
+    uint8_t u8() {
+        if (pos >= end) throw std::runtime_error("truncated dfa cache");
+        return static_cast<uint8_t>(bytes[pos++]);
+    }
+
+    uint32_t u32() {
+        uint32_t value = 0;
+        for (int i = 0; i < 4; i++) value |= static_cast<uint32_t>(u8()) << (8 * i);
+        return value;
+    }
+
+    uint64_t u64() {
+        uint64_t value = 0;
+        for (int i = 0; i < 8; i++) value |= static_cast<uint64_t>(u8()) << (8 * i);
+        return value;
+    }
+
+    std::string text() {
+        uint32_t size = u32();
+        if (size > end - pos) throw std::runtime_error("truncated dfa cache");
+        pos += size;
+        return bytes.substr(pos - size, size);
+    }
+
+    // A count of items that take at least one byte each
+    uint32_t count() {
+        uint32_t count = u32();
+        if (count > end - pos) throw std::runtime_error("truncated dfa cache");
+        return count;
+    }
+
+    bool atEnd() const { return pos == end; }
+
+private:
+    const std::string& bytes;
+    size_t pos;
+    size_t end;
+};
+
+// Encodes the states of every DFA. Prediction contexts are shared between
+// configurations and form a graph, so they are written first, parents
+// before children, and configurations refer to them by id.
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(Writer& out) : out(out) {}
+
+    // False if some state uses a feature this grammar does not have
+    // (predicates, lexer actions, precedence DFAs) and the file would not
+    // restore it
+    bool write(std::vector<dfa::DFA>& dfas) {
+        Writer contextBytes;
+        Writer stateBytes;
+        uint32_t nonEmpty = 0;
+        for (dfa::DFA& dfa : dfas) {
+            if (dfa.states.empty()) continue;
+            if (dfa.isPrecedenceDfa()) return false;
+            nonEmpty++;
+            if (!writeDfa(dfa, stateBytes, contextBytes)) return false;
+        }
+        out.u32(contextCount);
+        out.bytes += contextBytes.bytes;
+        out.u32(nonEmpty);
+        out.bytes += stateBytes.bytes;
+        return true;
+    }
+
+private:
+    Writer& out;
+    std::unordered_map<const atn::PredictionContext*, uint32_t> contextIds;
+    uint32_t contextCount = 0;
+
+    uint32_t context(const Ref<const atn::PredictionContext>& context, Writer& bytes) {
+        if (!context) return NO_CONTEXT;
+        if (context == atn::PredictionContext::EMPTY) return EMPTY_CONTEXT;
+        auto it = contextIds.find(context.get());
+        if (it != contextIds.end()) return it->second;
+
+        std::vector<uint32_t> parents;
+        for (size_t i = 0; i < context->size(); i++) parents.push_back(this->context(context->getParent(i), bytes));
+        bytes.u8(static_cast<uint8_t>(context->getContextType()));
+        bytes.u32(context->size());
+        for (size_t i = 0; i < context->size(); i++) {
+            bytes.u32(parents[i]);
+            bytes.u64(context->getReturnState(i));
+        }
+        uint32_t id = FIRST_CONTEXT + contextCount++;
+        contextIds.emplace(context.get(), id);
+        return id;
+    }
+
+    bool writeDfa(dfa::DFA& dfa, Writer& bytes, Writer& contextBytes) {
+        // By state number, the order they were added in
+        std::vector<dfa::DFAState*> states(dfa.states.begin(), dfa.states.end());
+        std::sort(states.begin(), states.end(),
+                  [](const dfa::DFAState* a, const dfa::DFAState* b) { return a->stateNumber < b->stateNumber; });
+        std::unordered_map<const dfa::DFAState*, uint32_t> index;
+        for (size_t i = 0; i < states.size(); i++) index.emplace(states[i], i);
+
+        bytes.u32(dfa.decision);
+        bytes.u32(states.size());
+        for (const dfa::DFAState* state : states) {
+            if (!state->predicates.empty() || state->lexerActionExecutor) return false;
+            bytes.u8(state->isAcceptState);
+            bytes.u8(state->requiresFullContext);
+            bytes.u64(state->prediction);
+
+            const atn::ATNConfigSet& configs = *state->configs;
+            bytes.u8(configs.fullCtx);
+            bytes.u64(configs.uniqueAlt);
+            bytes.u8(configs.hasSemanticContext);
+            bytes.u8(configs.dipsIntoOuterContext);
+            bytes.u32(configs.conflictingAlts.count());
+            for (size_t alt = configs.conflictingAlts.nextSetBit(0); alt < configs.conflictingAlts.size();
+                 alt = configs.conflictingAlts.nextSetBit(alt + 1)) {
+                bytes.u32(alt);
+            }
+            bytes.u32(configs.configs.size());
+            for (const Ref<atn::ATNConfig>& config : configs.configs) {
+                if (config->semanticContext != atn::SemanticContext::Empty::Instance) return false;
+                bytes.u32(config->state->stateNumber);
+                bytes.u64(config->alt);
+                bytes.u32(context(config->context, contextBytes));
+                bytes.u64(config->reachesIntoOuterContext);
+            }
+
+            // Sorted, since the order of a hash map depends on its history
+            std::vector<std::pair<size_t, dfa::DFAState*>> edges(state->edges.begin(), state->edges.end());
+            std::sort(edges.begin(), edges.end());
+            bytes.u32(edges.size());
+            for (const auto& [symbol, target] : edges) {
+                bytes.u64(symbol);
+                bytes.u32(target == atn::ATNSimulator::ERROR.get() ? ERROR_STATE : index.at(target));
+            }
+        }
+        bytes.u32(dfa.s0 ? index.at(dfa.s0) : ERROR_STATE);
+        return true;
+    }
+};
+
+// Rebuilds the states of a snapshot. Nothing touches the DFAs until the
+// whole file has been read, so a bad file leaves them as they were.
+class SnapshotReader {
+public:
+    SnapshotReader(Reader& in, const atn::ATN& atn) : in(in), atn(atn) {}
+
+    struct Dfa {
+        size_t decision;
+        std::vector<std::unique_ptr<dfa::DFAState>> states;
+        uint32_t s0;
+    };
+
+    std::vector<Dfa> read() {
+        readContexts();
+        std::vector<Dfa> dfas(in.count());
+        for (Dfa& dfa : dfas) readDfa(dfa);
+        return dfas;
+    }
+
+private:
+    Reader& in;
+    const atn::ATN& atn;
+    std::vector<Ref<const atn::PredictionContext>> contexts;// by id
+
+    const Ref<const atn::PredictionContext>& context(uint32_t id) {
+        static const Ref<const atn::PredictionContext> none;
+        if (id == NO_CONTEXT) return none;
+        if (id >= contexts.size()) throw std::runtime_error("bad context in dfa cache");
+        return contexts[id];
+    }
+
+    void readContexts() {
+        uint32_t count = in.count();
+        contexts.reserve(FIRST_CONTEXT + count);
+        contexts.push_back(atn::PredictionContext::EMPTY);
+        for (uint32_t i = 0; i < count; i++) {
+            auto type = static_cast<atn::PredictionContextType>(in.u8());
+            uint32_t size = in.count();
+            std::vector<Ref<const atn::PredictionContext>> parents;
+            std::vector<size_t> returnStates;
+            for (uint32_t j = 0; j < size; j++) {
+                parents.push_back(context(in.u32()));
+                returnStates.push_back(in.u64());
+            }
+            if (type == atn::PredictionContextType::SINGLETON && size == 1) {
+                contexts.push_back(atn::SingletonPredictionContext::create(parents[0], returnStates[0]));
+            } else if (type == atn::PredictionContextType::ARRAY && size > 0) {
+                contexts.push_back(std::make_shared<atn::ArrayPredictionContext>(parents, returnStates));
+            } else {
+                throw std::runtime_error("bad context in dfa cache");
+            }
+        }
+    }
+
+    void readDfa(Dfa& dfa) {
+        dfa.decision = in.u32();
+        if (dfa.decision >= atn.getNumberOfDecisions()) throw std::runtime_error("bad decision in dfa cache");
+        uint32_t count = in.count();
+        std::vector<std::vector<std::pair<size_t, uint32_t>>> edges(count);
+        for (uint32_t i = 0; i < count; i++) {
+            bool accept = in.u8() != 0;
+            bool fullContext = in.u8() != 0;
+            size_t prediction = in.u64();
+
+            auto configs = std::make_unique<atn::ATNConfigSet>(in.u8() != 0);
+            size_t uniqueAlt = in.u64();
+            bool hasSemanticContext = in.u8() != 0;
+            bool dipsIntoOuterContext = in.u8() != 0;
+            antlrcpp::BitSet conflictingAlts;
+            for (uint32_t alts = in.count(); alts > 0; alts--) {
+                uint32_t alt = in.u32();
+                if (alt >= conflictingAlts.size()) throw std::runtime_error("bad alternative in dfa cache");
+                conflictingAlts.set(alt);
+            }
+            for (uint32_t configCount = in.count(); configCount > 0; configCount--) {
+                uint32_t stateNumber = in.u32();
+                if (stateNumber >= atn.states.size()) throw std::runtime_error("bad ATN state in dfa cache");
+                size_t alt = in.u64();
+                auto config = std::make_shared<atn::ATNConfig>(atn.states[stateNumber], alt, context(in.u32()),
+                                                               atn::SemanticContext::Empty::Instance);
+                config->reachesIntoOuterContext = in.u64();
+                configs->add(config);
+            }
+            // As ParserATNSimulator::addDFAState leaves them
+            configs->uniqueAlt = uniqueAlt;
+            configs->conflictingAlts = conflictingAlts;
+            configs->hasSemanticContext = hasSemanticContext;
+            configs->dipsIntoOuterContext = dipsIntoOuterContext;
+            configs->setReadonly(true);
+
+            auto state = std::make_unique<dfa::DFAState>(std::move(configs));
+            state->isAcceptState = accept;
+            state->requiresFullContext = fullContext;
+            state->prediction = prediction;
+            state->stateNumber = static_cast<int>(i);
+            dfa.states.push_back(std::move(state));
+
+            for (uint32_t edgeCount = in.count(); edgeCount > 0; edgeCount--) {
+                size_t symbol = in.u64();
+                edges[i].emplace_back(symbol, in.u32());
+            }
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            for (const auto& [symbol, target] : edges[i]) {
+                if (target != ERROR_STATE && target >= count) throw std::runtime_error("bad edge in dfa cache");
+                dfa.states[i]->edges[symbol] =
+                        target == ERROR_STATE ? atn::ATNSimulator::ERROR.get() : dfa.states[target].get();
+            }
+        }
+        dfa.s0 = in.u32();
+        if (dfa.s0 != ERROR_STATE && dfa.s0 >= count) throw std::runtime_error("bad start state in dfa cache");
+    }
+};
+
+}// namespace
+
+DfaCache::DfaCache(std::string path) : path(std::move(path)) {}
+
+// Layout: magic, version, grammar fingerprint, the prediction contexts,
+// the DFAs, then the hash of everything before it
+size_t DfaCache::load() {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return 0;
+    // In one read; this runs before the first statement
+    std::string bytes(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    if (!file.read(bytes.data(), bytes.size())) return 0;
+    if (bytes.size() < MAGIC_SIZE + 8) return 0;
+    size_t checked = bytes.size() - 8;
+    Reader trailer(bytes, checked, bytes.size());
+    if (trailer.u64() != hashBytes(bytes.data(), checked)) return 0;
+
+    Grammar grammar;
+    std::vector<dfa::DFA>& dfas = grammar.dfas();
+    for (const dfa::DFA& dfa : dfas) {
+        if (!dfa.states.empty()) return 0;
+    }
+    std::vector<SnapshotReader::Dfa> snapshot;
+    try {
+        Reader reader(bytes, 0, checked);
+        for (size_t i = 0; i < MAGIC_SIZE; i++) {
+            if (reader.u8() != static_cast<uint8_t>(MAGIC[i])) return 0;
+        }
+        if (reader.text() != CACHE_VERSION || reader.u64() != grammar.fingerprint()) return 0;
+        snapshot = SnapshotReader(reader, grammar.atn()).read();
+        if (!reader.atEnd()) return 0;
+    } catch (const std::runtime_error&) {
+        return 0;
+    }
+
+    for (SnapshotReader::Dfa& saved : snapshot) {
+        dfa::DFA& dfa = dfas[saved.decision];
+        if (!dfa.states.empty()) continue;// a decision saved twice
+        for (std::unique_ptr<dfa::DFAState>& state : saved.states) dfa.states.insert(state.get());
+        if (saved.s0 != ERROR_STATE) dfa.s0 = saved.states[saved.s0].get();
+        loaded += saved.states.size();
+        // Owned by the DFA from here on
+        for (std::unique_ptr<dfa::DFAState>& state : saved.states) state.release();
+    }
+    return loaded;
+}
+
+void DfaCache::store() const {
+    Grammar grammar;
+    std::vector<dfa::DFA>& dfas = grammar.dfas();
+    size_t states = 0;
+    for (const dfa::DFA& dfa : dfas) states += dfa.states.size();
+    if (states <= loaded) return;
+
+    Writer writer;
+    writer.bytes.append(MAGIC, MAGIC_SIZE);
+    writer.text(CACHE_VERSION);
+    writer.u64(grammar.fingerprint());
+    if (!SnapshotWriter(writer).write(dfas)) return;
+    writer.u64(hashBytes(writer.bytes.data(), writer.bytes.size()));
+
+    std::string temporary = path + ".tmp" + std::to_string(std::random_device()());
+    std::ofstream file(temporary, std::ios::binary);
+    file.write(writer.bytes.data(), writer.bytes.size());
+    file.close();
+    if (!file || std::rename(temporary.c_str(), path.c_str()) != 0) std::remove(temporary.c_str());
+}
@@ -0,0 +1,41 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_DFACACHE_H
+#define PYTHON_INTERPRETER_DFACACHE_H
+
+#include <cstddef>
+#include <string>
+
+// File that keeps the prediction DFAs Python3Parser builds as it parses
+// from one run to the next. Every process starts with empty DFAs and pays
+// for full ATN simulation at each decision until they fill up; loading a
+// snapshot taken after a training corpus, such as testcases/, makes the
+// first parse run on warm DFAs instead. Restoring a state costs about as
+// much as predicting its way there once, so this pays off on scripts that
+// reach many decisions rather than on the smallest ones.
+//
+// The DFAs belong to Python3Parser's static data, so they are shared by
+// every parser in the process. A snapshot records each DFA state with its
+// ATN configurations and their prediction contexts, and carries the ANTLR
+// runtime version and a hash of the serialized ATN; a file written for
+// another grammar or runtime, or that does not check out, is ignored.
+class DfaCache {
+public:
+    // Identifies the layout of the file. Bump it whenever that changes.
+    static constexpr const char* CACHE_VERSION = "pyinterp-dfa-1";
+
+    explicit DfaCache(std::string path);
+
+    // Adds the states saved in the file to the DFAs, which must still be
+    // empty, and returns how many there were; 0 if nothing was loaded
+    size_t load();
+
+    // Best effort, like ProgramCache::store: writes the DFAs if parsing has
+    // added states since load()
+    void store() const;
+
+private:
+    std::string path;
+    size_t loaded = 0;
+};
+
+#endif//PYTHON_INTERPRETER_DFACACHE_H
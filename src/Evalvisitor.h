@@ -3,8 +3,12 @@
 #define PYTHON_INTERPRETER_EVALVISITOR_H
 
 #include "Python3ParserBaseVisitor.h"
+#include "Builtins.h"
+#include "NodeTable.h"
+#include "Value.h"
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <any>
 #include <memory>
@@ -13,83 +17,6 @@
 #include <iomanip>
 #include <cmath>
 
-// Big integer class for arbitrary precision arithmetic
-class BigInt {
-private:
-    std::string value;
-    bool negative;
-    
-    void removeLeadingZeros();
-    static bool absGreater(const std::string& a, const std::string& b);
-    static std::string absAdd(const std::string& a, const std::string& b);
-    static std::string absSub(const std::string& a, const std::string& b);
-    static std::string absMul(const std::string& a, const std::string& b);
-    static std::pair<std::string, std::string> absDiv(const std::string& a, const std::string& b);
-    
-public:
-    BigInt();
-    BigInt(const std::string& s);
-    BigInt(long long n);
-    BigInt(int n);
-    
-    std::string toString() const;
-    double toDouble() const;
-    bool toBool() const;
-    
-    BigInt operator+(const BigInt& other) const;
-    BigInt operator-(const BigInt& other) const;
-    BigInt operator*(const BigInt& other) const;
-    BigInt operator/(const BigInt& other) const;
-    BigInt operator%(const BigInt& other) const;
-    BigInt operator-() const;
-    
-    bool operator<(const BigInt& other) const;
-    bool operator>(const BigInt& other) const;
-    bool operator<=(const BigInt& other) const;
-    bool operator>=(const BigInt& other) const;
-    bool operator==(const BigInt& other) const;
-    bool operator!=(const BigInt& other) const;
-};
-
-// Value type for interpreter
-enum class ValueType { NONE, BOOL, INT, FLOAT, STRING };
-
-class Value {
-public:
-    ValueType type;
-    bool boolVal;
-    BigInt intVal;
-    double floatVal;
-    std::string stringVal;
-    
-    Value();
-    Value(bool b);
-    Value(const BigInt& i);
-    Value(double f);
-    Value(const std::string& s);
-    
-    std::string toString() const;
-    bool toBool() const;
-    Value toInt() const;
-    Value toFloat() const;
-    Value toStr() const;
-    
-    Value operator+(const Value& other) const;
-    Value operator-(const Value& other) const;
-    Value operator*(const Value& other) const;
-    Value operator/(const Value& other) const;
-    Value operator%(const Value& other) const;
-    Value floordiv(const Value& other) const;
-    Value operator-() const;
-    
-    bool operator<(const Value& other) const;
-    bool operator>(const Value& other) const;
-    bool operator<=(const Value& other) const;
-    bool operator>=(const Value& other) const;
-    bool operator==(const Value& other) const;
-    bool operator!=(const Value& other) const;
-};
-
 // Exception classes
 class BreakException {};
 class ContinueException {};
@@ -106,10 +33,22 @@ struct FunctionDef {
     Python3Parser::SuiteContext* suite;
 };
 
+// Cached callee of a call site. User functions are re-resolved whenever
+// a `def` has run since the entry was filled in (tracked by epoch).
+struct CallTarget {
+    bool resolved = false;
+    Builtin builtin = Builtin::NONE;
+    FunctionDef* func = nullptr;
+    size_t epoch = 0;
+};
+
 class EvalVisitor : public Python3ParserBaseVisitor {
 private:
     std::vector<std::map<std::string, Value>> scopes;
     std::map<std::string, FunctionDef> functions;
+    size_t functionsEpoch = 0;
+    std::unordered_map<Python3Parser::Atom_exprContext*, CallTarget> callTargets;
+    NodeTable nodes;
     
     void pushScope();
     void popScope();
@@ -117,7 +56,10 @@ private:
     Value getVariable(const std::string& name);
     bool hasVariable(const std::string& name);
     
-    std::string parseString(const std::string& s);
+    const CallTarget& resolveCall(Python3Parser::Atom_exprContext* ctx);
+    Value callBuiltin(Builtin builtin, Python3Parser::TrailerContext* trailer);
+    Value callFunction(FunctionDef& func, Python3Parser::TrailerContext* trailer);
+    
     Value evaluateFormatString(Python3Parser::Format_stringContext* ctx);
     
 public:
@@ -0,0 +1,282 @@
+#include "Frontend.h"
+#include "AstBuilder.h"
+#include "ConstantFolder.h"
+#include "DescentParser.h"
+#include "LoopHoister.h"
+#include "ParallelParser.h"
+#include "ProgramCache.h"
+#include "Python3Lexer.h"
+#include "Python3Parser.h"
+#include "Resolver.h"
+#include "Tokenizer.h"
+#include "TypeInference.h"
+#include "antlr4-runtime.h"
+#include <chrono>
+#include <iterator>
+#include <thread>
+
+using namespace antlr4;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+Python3Parser::File_inputContext* parseFile(Python3Parser& parser, bool& fullLL) {
+    auto simulator = parser.getInterpreter<atn::ParserATNSimulator>();
+    simulator->setPredictionMode(atn::PredictionMode::SLL);
+    parser.setErrorHandler(std::make_shared<BailErrorStrategy>());
+    parser.removeErrorListeners();
+    try {
+        fullLL = false;
+        return parser.file_input();
+    } catch (const ParseCancellationException&) {
+    }
+
+    fullLL = true;
+    parser.reset();// also rewinds the token stream
+    parser.addErrorListener(&ConsoleErrorListener::INSTANCE);
+    parser.setErrorHandler(std::make_shared<DefaultErrorStrategy>());
+    simulator->setPredictionMode(atn::PredictionMode::LL);
+    return parser.file_input();
+}
+
+std::string readAll(std::istream& in) {
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+// Parses source a statement at a time and drops each, which reports its
+// syntax errors in as little memory as streaming it takes
+void reportSyntaxErrors(std::string_view source) {
+    ast::Program program;
+    TokenScanner scanner(source);
+    DescentParser parser(scanner, program);
+    std::vector<ast::Stmt*> parsed;
+    while (parser.parseNext(parsed)) {
+        parsed.clear();
+        program.arena = ast::Arena();
+        program.constants.clear();
+    }
+}
+
+// Tokens straight from the Tokenizer into the DescentParser, which builds
+// the AST itself
+void parseDescent(const std::string& source, ast::Program& program, ParseStats* stats, unsigned threads) {
+    Clock::time_point start = Clock::now();
+    std::vector<PyToken> tokens = tokenize(source);
+    stats->lexSeconds = secondsSince(start);
+
+    start = Clock::now();
+    stats->parseChunks = parseParallel(tokens, program, threads);
+    stats->parseThreads = threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : threads;
+    if (stats->parseChunks == 0) {
+        DescentParser parser(tokens, program);
+        parser.parse();
+        stats->syntaxErrors = parser.syntaxErrors();
+    }
+    stats->parseSeconds = secondsSince(start);
+}
+
+std::unique_ptr<ast::Program> parseSource(const std::string& source, ParseStats* stats, ParserKind parserKind,
+                                          unsigned parseThreads) {
+    auto program = std::make_unique<ast::Program>();
+    stats->parser = parserKind;
+    if (parserKind == ParserKind::RECURSIVE_DESCENT) {
+        parseDescent(source, *program, stats, parseThreads);
+    } else {
+        Clock::time_point start = Clock::now();
+        TokenizerSource tokenSource(source);
+        CommonTokenStream tokens(&tokenSource);
+        tokens.fill();
+        stats->lexSeconds = secondsSince(start);
+
+        start = Clock::now();
+        Python3Parser parser(&tokens);
+        Python3Parser::File_inputContext* tree = parseFile(parser, stats->fullLL);
+        stats->parseSeconds = secondsSince(start);
+        stats->syntaxErrors = parser.getNumberOfSyntaxErrors();
+
+        start = Clock::now();
+        AstBuilder(*program).build(tree);
+        stats->lowerSeconds = secondsSince(start);
+    }
+    Clock::time_point start = Clock::now();
+    resolveScopes(*program);
+    foldConstants(*program);
+    hoistLoopInvariants(*program);
+    inferTypes(*program);
+    stats->lowerSeconds += secondsSince(start);
+    return program;
+}
+
+// Whether a statement defines a function, at any depth of module-level
+// control flow
+bool definesFunction(const ast::Stmt* stmt) {
+    auto anyDefines = [](ast::Span<ast::Stmt*> body) {
+        for (const ast::Stmt* inner : body) {
+            if (definesFunction(inner)) return true;
+        }
+        return false;
+    };
+    switch (stmt->kind) {
+        case ast::StmtKind::FUNCDEF: return true;
+        case ast::StmtKind::IF: {
+            auto ifStmt = static_cast<const ast::If*>(stmt);
+            for (const ast::IfBranch& branch : ifStmt->branches) {
+                if (anyDefines(branch.body)) return true;
+            }
+            return anyDefines(ifStmt->orelse);
+        }
+        case ast::StmtKind::WHILE: return anyDefines(static_cast<const ast::While*>(stmt)->body);
+        default: return false;
+    }
+}
+
+}// namespace
+
+std::unique_ptr<ast::Program> parseProgram(std::istream& in, ParseStats* stats, ParserKind parser,
+                                           unsigned parseThreads) {
+    ParseStats unused;
+    return parseSource(readAll(in), stats ? stats : &unused, parser, parseThreads);
+}
+
+std::unique_ptr<ast::Program> loadProgram(std::istream& in, const std::string& cacheDirectory, ParseStats* stats,
+                                          ParserKind parser, unsigned parseThreads) {
+    ParseStats unused;
+    if (!stats) stats = &unused;
+    std::string source = readAll(in);
+    ProgramCache cache(cacheDirectory);
+
+    Clock::time_point start = Clock::now();
+    std::unique_ptr<ast::Program> program = cache.load(source);
+    if (program) {
+        stats->cached = true;
+        stats->lowerSeconds = secondsSince(start);
+        return program;
+    }
+    program = parseSource(source, stats, parser, parseThreads);
+    if (stats->syntaxErrors == 0) cache.store(source, *program);
+    return program;
+}
+
+struct LazyProgram::State {
+    std::string source;
+    std::vector<PyToken> tokens;// kept for the bodies still to parse
+    ast::Program program;
+    DescentParser parser{tokens, program};
+};
+
+LazyProgram::LazyProgram(std::istream& in, ParseStats* stats) : state(std::make_unique<State>()) {
+    ParseStats unused;
+    if (!stats) stats = &unused;
+    State& s = *state;
+    s.source = readAll(in);
+    stats->parser = ParserKind::RECURSIVE_DESCENT;
+
+    Clock::time_point start = Clock::now();
+    s.tokens = tokenize(s.source);
+    stats->lexSeconds = secondsSince(start);
+
+    start = Clock::now();
+    s.parser.deferFunctionBodies();
+    s.parser.parse();
+    stats->parseSeconds = secondsSince(start);
+    stats->syntaxErrors = s.parser.syntaxErrors();
+
+    start = Clock::now();
+    resolveScopes(s.program);
+    foldConstants(s.program);
+    stats->lowerSeconds = secondsSince(start);
+}
+
+LazyProgram::~LazyProgram() = default;
+
+const ast::Program& LazyProgram::program() const {
+    return state->program;
+}
+
+void LazyProgram::parseBody(const ast::FuncDef* def) {
+    // Nodes are handed out const for running, but the program is ours
+    auto lazy = const_cast<ast::FuncDef*>(def);
+    state->parser.parseBody(lazy);
+    resolveFunction(lazy);
+    foldFunction(state->program, lazy);
+}
+
+struct StatementStream::State {
+    explicit State(std::istream& in) : source(readAll(in)), scanner(source), parser(scanner, program) {
+        // Errors are reported before anything runs, as when parsing first
+        reportSyntaxErrors(source);
+        parser.silenceErrors();
+    }
+
+    std::string source;
+    ast::Program program;
+    TokenScanner scanner;
+    DescentParser parser;
+    ast::Arena scratch;// holds the last statement while it may be released
+    std::vector<ast::Arena> kept;// scratch arenas of statements that define functions
+    uint32_t keptConstants = 0;
+    uint32_t firstConstant = 0;// of the last statement
+    size_t nextInBody = 0;// folding can splice one parsed statement into several
+    bool releaseLast = false;
+};
+
+StatementStream::StatementStream(std::istream& in) : state(std::make_unique<State>(in)) {}
+
+StatementStream::~StatementStream() = default;
+
+const ast::Program& StatementStream::program() const {
+    return state->program;
+}
+
+const ast::Stmt* StatementStream::next() {
+    State& s = *state;
+    ast::Program& program = s.program;
+    if (s.nextInBody < program.body.size) return program.body[s.nextInBody++];
+    for (;;) {
+        if (s.releaseLast) {
+            s.scratch = ast::Arena();
+            program.constants.resize(s.keptConstants);
+        }
+        s.firstConstant = program.constants.size();
+
+        // A def is kept anyway, so it goes straight into the program's arena
+        bool def = s.parser.peek() == Python3Lexer::DEF;
+        if (!def) std::swap(program.arena, s.scratch);
+        std::vector<ast::Stmt*> parsed;
+        bool more = s.parser.parseNext(parsed);
+        if (more) {
+            program.body = copyToArena(program.arena, parsed);
+            resolveScopes(program);
+            foldConstants(program);
+        }
+        if (!def) std::swap(program.arena, s.scratch);
+        if (!more) return nullptr;
+
+        // Statements a syntax error or folding removed leave nothing to run
+        bool keep = false;
+        for (const ast::Stmt* stmt : program.body) keep = keep || definesFunction(stmt);
+        if (keep && !def) {
+            s.kept.push_back(std::move(s.scratch));
+            s.scratch = ast::Arena();
+        }
+        s.releaseLast = !keep;
+        if (keep) s.keptConstants = program.constants.size();
+        if (!program.body.empty()) {
+            s.nextInBody = 1;
+            return program.body[0];
+        }
+    }
+}
+
+uint32_t StatementStream::firstConstant() const {
+    return state->firstConstant;
+}
+
+size_t StatementStream::syntaxErrors() const {
+    return state->parser.syntaxErrors();
+}
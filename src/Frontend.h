@@ -0,0 +1,101 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_FRONTEND_H
+#define PYTHON_INTERPRETER_FRONTEND_H
+
+#include "Ast.h"
+#include <istream>
+#include <memory>
+#include <string>
+
+// Which parser turns the tokens into the AST: Python3Parser followed by
+// AstBuilder, or the DescentParser that builds the AST as it goes
+enum class ParserKind { ANTLR, RECURSIVE_DESCENT };
+
+// Where the front end spent its time
+struct ParseStats {
+    ParserKind parser = ParserKind::ANTLR;
+    double lexSeconds = 0;
+    double parseSeconds = 0;// both prediction stages, if it took two; the AST too for recursive descent
+    double lowerSeconds = 0;// building the AST and the passes over it
+    bool fullLL = false;// SLL prediction failed, so the input was parsed again in LL mode
+    size_t syntaxErrors = 0;// reported by the LL parse or the DescentParser; lexing cannot fail
+    size_t parseChunks = 0;// parsed concurrently by recursive descent; 0 if it ran on one thread
+    unsigned parseThreads = 1;
+    bool cached = false;// loaded from the program cache without parsing
+};
+
+// Parses a whole program and lowers it to the compact AST with scopes
+// resolved. Tokens come from the hand-written Tokenizer rather than the
+// generated lexer. The token stream and parse tree are released before
+// this returns, so only the AST stays resident during execution.
+//
+// The parser first runs with SLL prediction and bails out at the first
+// error. SLL is much cheaper than full LL and gives the same tree whenever
+// it succeeds; inputs where it fails, syntax errors included, are parsed
+// again from the start with full LL and the usual error reporting.
+//
+// With ParserKind::RECURSIVE_DESCENT the DescentParser replaces both
+// Python3Parser and AstBuilder. It builds the same program and reports
+// syntax errors in the same words, though not every cascade ANTLR reports
+// after the first error. It parses large inputs on up to parseThreads
+// threads, 0 for one per core; see parseParallel.
+std::unique_ptr<ast::Program> parseProgram(std::istream& in, ParseStats* stats = nullptr,
+                                           ParserKind parser = ParserKind::ANTLR, unsigned parseThreads = 1);
+
+// Like parseProgram, but first looks the source up in the ProgramCache
+// under cacheDirectory and only parses it on a miss. Programs that parsed
+// without syntax errors are then stored for the next run.
+std::unique_ptr<ast::Program> loadProgram(std::istream& in, const std::string& cacheDirectory,
+                                          ParseStats* stats = nullptr, ParserKind parser = ParserKind::ANTLR,
+                                          unsigned parseThreads = 1);
+
+// Parses a program with the DescentParser but skips the indented body of
+// every def, which parseBody() parses when the function is first called,
+// so that defs a run never calls cost little more than their tokens. Each
+// body gets its scopes resolved and constants folded as it is parsed; loop
+// hoisting and type inference, which need every body, do not run. Syntax
+// errors in a body are only reported once it is parsed.
+class LazyProgram {
+public:
+    explicit LazyProgram(std::istream& in, ParseStats* stats = nullptr);
+    ~LazyProgram();
+
+    const ast::Program& program() const;
+    // Parses the body of def, which must have FuncDef::lazyBody set. This
+    // may add constants and symbols to the program.
+    void parseBody(const ast::FuncDef* def);
+
+private:
+    struct State;
+    std::unique_ptr<State> state;
+};
+
+// Parses a program one module-level statement at a time, so that each can
+// run as soon as it is parsed instead of after the whole program. Tokens
+// are scanned as the DescentParser needs them. Every statement gets its
+// scopes resolved and constants folded; the passes that need the whole
+// program, loop hoisting and type inference, do not run. Syntax errors are
+// still reported before the first statement runs, by a pass that parses
+// and drops one statement after another.
+//
+// A statement and the constants only it uses are released when the next
+// one is parsed, unless it defines a function, which may still be called.
+class StatementStream {
+public:
+    explicit StatementStream(std::istream& in);
+    ~StatementStream();
+
+    const ast::Program& program() const;
+    // The next statement, or nullptr at the end of the input
+    const ast::Stmt* next();
+    // Index of the first constant the last statement added; earlier
+    // indices of released statements are reused
+    uint32_t firstConstant() const;
+    size_t syntaxErrors() const;
+
+private:
+    struct State;
+    std::unique_ptr<State> state;
+};
+
+#endif//PYTHON_INTERPRETER_FRONTEND_H
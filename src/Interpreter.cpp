@@ -0,0 +1,612 @@
+#include "Interpreter.h"
+#include "Builtins.h"
+#include "Frontend.h"
+#include "Operators.h"
+#include <cmath>
+
+using namespace ast;
+
+namespace {
+
+// Ints beyond 2^53 compare through inexact doubles, like the Values do
+constexpr int64_t EXACT_DOUBLE = int64_t(1) << 53;
+
+bool isExact(int64_t n) { return n >= -EXACT_DOUBLE && n <= EXACT_DOUBLE; }
+
+bool isNumber(StaticType type) { return type == StaticType::INT || type == StaticType::FLOAT; }
+
+// int64 arithmetic with Python semantics. Declines on overflow, on zero
+// divisors, which raise, and on INT64_MIN, which BigInt can not negate.
+bool intArith(BinaryOp op, int64_t lhs, int64_t rhs, int64_t& out) {
+    switch (op) {
+        case BinaryOp::ADD:
+            if (__builtin_add_overflow(lhs, rhs, &out)) return false;
+            break;
+        case BinaryOp::SUB:
+            if (__builtin_sub_overflow(lhs, rhs, &out)) return false;
+            break;
+        case BinaryOp::MUL:
+            if (__builtin_mul_overflow(lhs, rhs, &out)) return false;
+            break;
+        case BinaryOp::FLOORDIV:
+        case BinaryOp::MOD: {
+            if (rhs == 0 || (lhs == INT64_MIN && rhs == -1)) return false;
+            int64_t quotient = lhs / rhs;
+            int64_t remainder = lhs % rhs;
+            if (remainder != 0 && (remainder < 0) != (rhs < 0)) {
+                quotient--;
+                remainder += rhs;
+            }
+            out = op == BinaryOp::FLOORDIV ? quotient : remainder;
+            break;
+        }
+        default:
+            return false;
+    }
+    return out != INT64_MIN;
+}
+
+bool floatArith(BinaryOp op, double lhs, double rhs, double& out) {
+    switch (op) {
+        case BinaryOp::ADD: out = lhs + rhs; return true;
+        case BinaryOp::SUB: out = lhs - rhs; return true;
+        case BinaryOp::MUL: out = lhs * rhs; return true;
+        case BinaryOp::DIV: out = lhs / rhs; return true;
+        case BinaryOp::FLOORDIV: out = std::floor(lhs / rhs); return true;
+        case BinaryOp::MOD: return false;
+    }
+    return false;
+}
+
+template <typename T>
+bool compareNumbers(CompareOp op, T lhs, T rhs) {
+    switch (op) {
+        case CompareOp::LT: return lhs < rhs;
+        case CompareOp::GT: return lhs > rhs;
+        case CompareOp::LE: return lhs <= rhs;
+        case CompareOp::GE: return lhs >= rhs;
+        case CompareOp::EQ: return lhs == rhs;
+        case CompareOp::NE: return lhs != rhs;
+    }
+    return false;
+}
+
+}// namespace
+
+Interpreter::Interpreter(const Program& program, MemoCache* memo, LazyProgram* lazy)
+    : program(program), memo(memo), lazy(lazy) {
+    loadConstants(0);
+}
+
+void Interpreter::run() {
+    growTables();
+    execBlock(program.body);
+}
+
+bool Interpreter::runStatement(const Stmt* stmt, uint32_t firstConstant) {
+    loadConstants(firstConstant);
+    growTables();
+    return exec(stmt) == Flow::NORMAL;
+}
+
+void Interpreter::loadConstants(uint32_t first) {
+    constantFits.resize(first);
+    constantInts.resize(first);
+    for (size_t i = first; i < program.constants.size(); i++) {
+        const Value& constant = program.constants[i];
+        long long n = 0;
+        constantFits.push_back(constant.type == ValueType::INT && constant.intVal.toLongLong(n));
+        constantInts.push_back(n);
+    }
+}
+
+void Interpreter::growTables() {
+    globals.resize(program.symbols.size());
+    globalBound.resize(program.symbols.size());
+    functions.resize(program.symbols.size());
+}
+
+// Parses a body left for its first call, and makes room for what it adds
+void Interpreter::parseBody(const FuncDef* def) {
+    uint32_t firstConstant = program.constants.size();
+    lazy->parseBody(def);
+    loadConstants(firstConstant);
+    growTables();
+}
+
+Interpreter::Flow Interpreter::execBlock(Span<Stmt*> body) {
+    for (const Stmt* stmt : body) {
+        Flow flow = exec(stmt);
+        if (flow != Flow::NORMAL) return flow;
+    }
+    return Flow::NORMAL;
+}
+
+Interpreter::Flow Interpreter::exec(const Stmt* stmt) {
+    switch (stmt->kind) {
+        case StmtKind::EXPR:
+            eval(static_cast<const ExprStmt*>(stmt)->value);
+            return Flow::NORMAL;
+        case StmtKind::ASSIGN:
+            assign(static_cast<const Assign*>(stmt));
+            return Flow::NORMAL;
+        case StmtKind::AUG_ASSIGN: {
+            auto aug = static_cast<const AugAssign*>(stmt);
+            if (augAssignUnboxed(aug)) return Flow::NORMAL;
+            Value oldVal = load(aug->target.name, aug->target.slot);
+            Value rhsVal = eval(aug->value);
+            store(aug->target, applyBinary(aug->op, oldVal, rhsVal));
+            return Flow::NORMAL;
+        }
+        case StmtKind::IF: {
+            auto ifStmt = static_cast<const If*>(stmt);
+            for (const IfBranch& branch : ifStmt->branches) {
+                if (test(branch.condition)) {
+                    return execBlock(branch.body);
+                }
+            }
+            return execBlock(ifStmt->orelse);
+        }
+        case StmtKind::WHILE: {
+            auto loop = static_cast<const While*>(stmt);
+            while (test(loop->condition)) {
+                Flow flow = execBlock(loop->body);
+                if (flow == Flow::BREAK) break;
+                if (flow == Flow::RETURN) return flow;
+            }
+            return Flow::NORMAL;
+        }
+        case StmtKind::FUNCDEF:
+            defineFunction(static_cast<const FuncDef*>(stmt));
+            return Flow::NORMAL;
+        case StmtKind::RETURN: {
+            auto ret = static_cast<const Return*>(stmt);
+            if (ret->selfCall && tailCall(static_cast<const Call*>(ret->value))) return Flow::RETURN;
+            Value value = ret->value ? eval(ret->value) : Value();
+            if (frame) frame->returnValue = value;
+            return Flow::RETURN;
+        }
+        case StmtKind::BREAK:
+            return Flow::BREAK;
+        case StmtKind::CONTINUE:
+            return Flow::CONTINUE;
+    }
+    return Flow::NORMAL;
+}
+
+void Interpreter::assign(const Assign* stmt) {
+    // Common case a = b needs no temporary list
+    if (stmt->targets.size == 1 && stmt->targets[0].size == 1 && stmt->values.size == 1) {
+        if (!assignUnboxed(stmt->targets[0][0], stmt->values[0])) store(stmt->targets[0][0], eval(stmt->values[0]));
+        return;
+    }
+
+    std::vector<Value> values;
+    values.reserve(stmt->values.size);
+    for (const Expr* value : stmt->values) {
+        values.push_back(eval(value));
+    }
+    for (const Span<Target>& targets : stmt->targets) {
+        if (targets.size == values.size()) {
+            for (size_t i = 0; i < targets.size; i++) store(targets[i], values[i]);
+        } else if (targets.size == 1) {
+            store(targets[0], values[0]);
+        }
+    }
+}
+
+void Interpreter::defineFunction(const FuncDef* def) {
+    auto function = std::make_shared<Function>();
+    function->def = def;
+    for (const Expr* value : def->defaults) {
+        function->defaults.push_back(eval(value));
+    }
+    functions[def->name] = std::move(function);
+}
+
+Value Interpreter::load(Symbol name, int32_t slot) {
+    if (slot != NO_SLOT && frame->bound[slot]) {
+        return frame->bound[slot] == UNBOXED ? box(slot) : frame->locals[slot];
+    }
+    return globalBound[name] ? globals[name] : Value();
+}
+
+void Interpreter::store(const Target& target, const Value& value) {
+    if (target.name == NO_SYMBOL) return;
+
+    // An unbound local only shadows a global that does not exist yet
+    if (target.slot != NO_SLOT && (frame->bound[target.slot] || !globalBound[target.name])) {
+        frame->locals[target.slot] = value;
+        frame->bound[target.slot] = true;
+        return;
+    }
+    globals[target.name] = value;
+    globalBound[target.name] = true;
+}
+
+Value Interpreter::eval(const Expr* expr) {
+    switch (expr->kind) {
+        case ExprKind::CONSTANT:
+            return program.constants[static_cast<const Constant*>(expr)->index];
+        case ExprKind::NAME: {
+            auto name = static_cast<const Name*>(expr);
+            return load(name->name, name->slot);
+        }
+        case ExprKind::UNARY: {
+            auto unary = static_cast<const Unary*>(expr);
+            int64_t n;
+            double d;
+            if (evalInt(expr, n)) return Value(BigInt(static_cast<long long>(n)));
+            if (evalFloat(expr, d)) return Value(d);
+            Value operand = eval(unary->operand);
+            switch (unary->op) {
+                case UnaryOp::NEG: return -operand;
+                case UnaryOp::NOT: return Value(!operand.toBool());
+                case UnaryOp::POS: return operand;
+            }
+            return operand;
+        }
+        case ExprKind::BINARY: {
+            auto binary = static_cast<const Binary*>(expr);
+            int64_t n;
+            double d;
+            if (evalInt(expr, n)) return Value(BigInt(static_cast<long long>(n)));
+            if (evalFloat(expr, d)) return Value(d);
+            Value lhs = eval(binary->lhs);
+            Value rhs = eval(binary->rhs);
+            return applyBinary(binary->op, lhs, rhs);
+        }
+        case ExprKind::COMPARE:
+            return Value(testCompare(static_cast<const Compare*>(expr)));
+        case ExprKind::BOOL_OP: {
+            // Yields the first operand that decides the result, like Python
+            auto boolOp = static_cast<const BoolOp*>(expr);
+            bool isOr = boolOp->op == LogicOp::OR;
+            Value result = eval(boolOp->operands[0]);
+            for (size_t i = 1; i < boolOp->operands.size; i++) {
+                if (result.toBool() == isOr) return result;
+                result = eval(boolOp->operands[i]);
+            }
+            return result;
+        }
+        case ExprKind::CALL:
+            return call(static_cast<const Call*>(expr));
+        case ExprKind::FORMAT:
+            return formatString(static_cast<const FormatString*>(expr));
+    }
+    return Value();
+}
+
+// Truth value of a condition, which needs no Value for comparisons of
+// typed numbers, bool locals and the logic operators over them
+bool Interpreter::test(const Expr* expr) {
+    switch (expr->kind) {
+        case ExprKind::NAME: {
+            auto name = static_cast<const Name*>(expr);
+            if (name->type == StaticType::BOOL && frame->bound[name->slot] == UNBOXED) {
+                return frame->unboxed[name->slot].intVal != 0;
+            }
+            break;
+        }
+        case ExprKind::UNARY: {
+            auto unary = static_cast<const Unary*>(expr);
+            if (unary->op == UnaryOp::NOT) return !test(unary->operand);
+            break;
+        }
+        case ExprKind::COMPARE:
+            return testCompare(static_cast<const Compare*>(expr));
+        case ExprKind::BOOL_OP: {
+            auto boolOp = static_cast<const BoolOp*>(expr);
+            bool isOr = boolOp->op == LogicOp::OR;
+            for (const Expr* operand : boolOp->operands) {
+                if (test(operand) == isOr) return isOr;
+            }
+            return !isOr;
+        }
+        default:
+            break;
+    }
+    return eval(expr).toBool();
+}
+
+bool Interpreter::testCompare(const Compare* expr) {
+    if (expr->ops.size == 1) {
+        const Expr* lhs = expr->operands[0];
+        const Expr* rhs = expr->operands[1];
+        if (lhs->type == StaticType::INT && rhs->type == StaticType::INT) {
+            int64_t a, b;
+            if (evalInt(lhs, a) && evalInt(rhs, b) && isExact(a) && isExact(b)) return compareNumbers(expr->ops[0], a, b);
+        } else if (isNumber(lhs->type) && isNumber(rhs->type)) {
+            double a, b;
+            if (evalNumber(lhs, a) && evalNumber(rhs, b)) return compareNumbers(expr->ops[0], a, b);
+        }
+    }
+    return compare(expr).boolVal;
+}
+
+Value Interpreter::compare(const Compare* expr) {
+    Value result = eval(expr->operands[0]);
+    for (size_t i = 0; i < expr->ops.size; i++) {
+        Value right = eval(expr->operands[i + 1]);
+        if (!applyCompare(expr->ops[i], result, right)) {
+            return Value(false);
+        }
+        result = std::move(right);
+    }
+    return Value(true);
+}
+
+Value Interpreter::formatString(const FormatString* expr) {
+    std::string result;
+    for (const FormatPart& part : expr->parts) {
+        if (part.literal != NO_CONSTANT) {
+            result += program.constants[part.literal].stringVal;
+            continue;
+        }
+        for (size_t i = 0; i < part.values.size; i++) {
+            if (i > 0) result += ", ";
+            result += eval(part.values[i]).toString();
+        }
+    }
+    return Value(result);
+}
+
+Value Interpreter::call(const Call* expr) {
+    if (expr->builtin != Builtin::NONE) {
+        std::vector<Value> args;
+        args.reserve(expr->args.size);
+        for (const Argument& arg : expr->args) {
+            args.push_back(eval(arg.value));
+        }
+        return invokeBuiltin(expr->builtin, args.data(), args.size());
+    }
+
+    // Calling a name that is not (yet) a function yields None
+    std::shared_ptr<const Function> function = functions[expr->callee];
+    if (!function) return Value();
+    return callFunction(*function, expr);
+}
+
+Value Interpreter::callFunction(const Function& function, const Call* expr) {
+    const FuncDef* def = function.def;
+    if (def->lazyBody != 0) parseBody(def);
+    Frame callee;
+    bindArguments(function, expr, callee);
+    if (!def->localTypes.empty()) {
+        callee.types = def->localTypes.data;
+        callee.unboxed.resize(def->localCount);
+    }
+    std::string key;
+    bool memoized = memo && memo->memoizes(def->name)
+                    && MemoCache::makeKey(def->name, callee.locals.data(), def->params.size, key);
+    if (memoized) {
+        if (const Value* result = memo->lookup(def->name, key)) return *result;
+    }
+
+    // A self tail call rebinds the frame and has the body run again, so
+    // tail recursion runs in constant C++ stack
+    Frame* caller = frame;
+    frame = &callee;
+    do {
+        callee.tailCall = false;
+        execBlock(def->body);
+    } while (callee.tailCall);
+    frame = caller;
+    if (memoized) memo->store(std::move(key), callee.returnValue);
+    return std::move(callee.returnValue);
+}
+
+// Replaces the current frame by a call of the same function with the
+// arguments of expr, if the name still refers to the running function
+bool Interpreter::tailCall(const Call* expr) {
+    if (functions[expr->callee].get() != frame->function) return false;
+    Frame next;
+    bindArguments(*frame->function, expr, next);
+    std::swap(frame->locals, next.locals);
+    std::swap(frame->bound, next.bound);
+    frame->tailCall = true;
+    return true;
+}
+
+void Interpreter::bindArguments(const Function& function, const Call* expr, Frame& callee) {
+    const FuncDef* def = function.def;
+    callee.function = &function;
+    callee.locals.resize(def->localCount);
+    callee.bound.resize(def->localCount);
+
+    // Arguments are evaluated in the caller's frame, left to right;
+    // positional ones fill parameters in order, keywords match by name
+    size_t position = 0;
+    for (const Argument& arg : expr->args) {
+        if (arg.keyword == NO_SYMBOL) {
+            if (position < def->params.size) {
+                callee.locals[position] = eval(arg.value);
+                callee.bound[position] = true;
+                position++;
+            }
+            continue;
+        }
+        Value value = eval(arg.value);
+        for (size_t i = 0; i < def->params.size; i++) {
+            if (def->params[i] == arg.keyword) {
+                callee.locals[i] = std::move(value);
+                callee.bound[i] = true;
+                break;
+            }
+        }
+    }
+
+    // Missing parameters take their default, or None
+    size_t firstDefault = def->params.size - def->defaults.size;
+    for (size_t i = 0; i < def->params.size; i++) {
+        if (callee.bound[i]) continue;
+        if (i >= firstDefault) callee.locals[i] = function.defaults[i - firstDefault];
+        callee.bound[i] = true;
+    }
+}
+
+// ============ Unboxed locals ============
+
+bool Interpreter::evalInt(const Expr* expr, int64_t& out) {
+    if (expr->type != StaticType::INT) return false;
+    switch (expr->kind) {
+        case ExprKind::CONSTANT: {
+            uint32_t index = static_cast<const Constant*>(expr)->index;
+            out = constantInts[index];
+            return constantFits[index];
+        }
+        case ExprKind::NAME:
+            return loadInt(static_cast<const Name*>(expr)->slot, out);
+        case ExprKind::UNARY: {
+            auto unary = static_cast<const Unary*>(expr);
+            if (!evalInt(unary->operand, out)) return false;
+            if (unary->op == UnaryOp::NEG) out = -out;
+            return true;
+        }
+        case ExprKind::BINARY: {
+            auto binary = static_cast<const Binary*>(expr);
+            int64_t lhs, rhs;
+            return evalInt(binary->lhs, lhs) && evalInt(binary->rhs, rhs) && intArith(binary->op, lhs, rhs, out);
+        }
+        default:
+            return false;
+    }
+}
+
+bool Interpreter::evalFloat(const Expr* expr, double& out) {
+    if (expr->type != StaticType::FLOAT) return false;
+    switch (expr->kind) {
+        case ExprKind::CONSTANT:
+            out = program.constants[static_cast<const Constant*>(expr)->index].floatVal;
+            return true;
+        case ExprKind::NAME:
+            return loadFloat(static_cast<const Name*>(expr)->slot, out);
+        case ExprKind::UNARY: {
+            auto unary = static_cast<const Unary*>(expr);
+            if (!evalFloat(unary->operand, out)) return false;
+            if (unary->op == UnaryOp::NEG) out = -out;
+            return true;
+        }
+        case ExprKind::BINARY: {
+            auto binary = static_cast<const Binary*>(expr);
+            double lhs, rhs;
+            return evalNumber(binary->lhs, lhs) && evalNumber(binary->rhs, rhs) && floatArith(binary->op, lhs, rhs, out);
+        }
+        default:
+            return false;
+    }
+}
+
+// An int or float operand of float arithmetic, as a double
+bool Interpreter::evalNumber(const Expr* expr, double& out) {
+    if (expr->type == StaticType::FLOAT) return evalFloat(expr, out);
+    int64_t n;
+    if (!evalInt(expr, n) || !isExact(n)) return false;
+    out = static_cast<double>(n);
+    return true;
+}
+
+// Reads a typed local, unboxing a value that was stored as a Value
+bool Interpreter::loadInt(int32_t slot, int64_t& out) {
+    char& state = frame->bound[slot];
+    if (state == UNBOXED) {
+        out = frame->unboxed[slot].intVal;
+        return true;
+    }
+    const Value& value = frame->locals[slot];
+    long long n;
+    if (state != BOXED || value.type != ValueType::INT || !value.intVal.toLongLong(n)) return false;
+    out = frame->unboxed[slot].intVal = n;
+    state = UNBOXED;
+    return true;
+}
+
+bool Interpreter::loadFloat(int32_t slot, double& out) {
+    char& state = frame->bound[slot];
+    if (state == UNBOXED) {
+        out = frame->unboxed[slot].floatVal;
+        return true;
+    }
+    const Value& value = frame->locals[slot];
+    if (state != BOXED || value.type != ValueType::FLOAT) return false;
+    out = frame->unboxed[slot].floatVal = value.floatVal;
+    state = UNBOXED;
+    return true;
+}
+
+// Typed locals are always certainly local, so no global is involved
+bool Interpreter::assignUnboxed(const Target& target, const Expr* value) {
+    if (target.name == NO_SYMBOL || target.slot == NO_SLOT || !frame->types) return false;
+    Unboxed& slot = frame->unboxed[target.slot];
+    switch (frame->types[target.slot]) {
+        case StaticType::INT: {
+            int64_t n;
+            if (!evalInt(value, n)) return false;
+            slot.intVal = n;
+            break;
+        }
+        case StaticType::FLOAT: {
+            double d;
+            if (!evalFloat(value, d)) return false;
+            slot.floatVal = d;
+            break;
+        }
+        case StaticType::BOOL: {
+            if (value->type != StaticType::BOOL) return false;
+            // Comparisons and not always give a bool; anything else is checked
+            // like loadInt checks, and stored boxed if it is not one, without
+            // evaluating it twice
+            if (value->kind == ExprKind::COMPARE ||
+                (value->kind == ExprKind::UNARY && static_cast<const Unary*>(value)->op == UnaryOp::NOT)) {
+                slot.intVal = test(value);
+                break;
+            }
+            Value result = eval(value);
+            if (result.type != ValueType::BOOL) {
+                store(target, result);
+                return true;
+            }
+            slot.intVal = result.boolVal;
+            break;
+        }
+        default:
+            return false;
+    }
+    frame->bound[target.slot] = UNBOXED;
+    return true;
+}
+
+bool Interpreter::augAssignUnboxed(const AugAssign* stmt) {
+    const Target& target = stmt->target;
+    if (target.name == NO_SYMBOL || target.slot == NO_SLOT || !frame->types) return false;
+    switch (frame->types[target.slot]) {
+        case StaticType::INT: {
+            int64_t lhs, rhs, result;
+            if (!loadInt(target.slot, lhs) || !evalInt(stmt->value, rhs) || !intArith(stmt->op, lhs, rhs, result)) {
+                return false;
+            }
+            frame->unboxed[target.slot].intVal = result;
+            return true;
+        }
+        case StaticType::FLOAT: {
+            double lhs, rhs, result;
+            if (!loadFloat(target.slot, lhs) || !evalNumber(stmt->value, rhs) || !floatArith(stmt->op, lhs, rhs, result)) {
+                return false;
+            }
+            frame->unboxed[target.slot].floatVal = result;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+Value Interpreter::box(int32_t slot) const {
+    const Unboxed& value = frame->unboxed[slot];
+    switch (frame->types[slot]) {
+        case StaticType::INT: return Value(BigInt(static_cast<long long>(value.intVal)));
+        case StaticType::FLOAT: return Value(value.floatVal);
+        case StaticType::BOOL: return Value(value.intVal != 0);
+        default: return Value();
+    }
+}
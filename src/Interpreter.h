@@ -0,0 +1,100 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_INTERPRETER_H
+#define PYTHON_INTERPRETER_INTERPRETER_H
+
+#include "Ast.h"
+#include "Memo.h"
+#include "Value.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class LazyProgram;
+
+// Tree-walking interpreter over the compact AST
+class Interpreter {
+public:
+    // memo: cache for the results of pure functions, or nullptr
+    // lazy: parses the function bodies program was loaded without, or nullptr
+    explicit Interpreter(const ast::Program& program, MemoCache* memo = nullptr, LazyProgram* lazy = nullptr);
+
+    void run();
+    // Runs one module-level statement of a program that is still being
+    // parsed, see StatementStream, and returns false if it ended the
+    // program. Constants from firstConstant on are new since the last call.
+    bool runStatement(const ast::Stmt* stmt, uint32_t firstConstant);
+
+private:
+    enum class Flow { NORMAL, BREAK, CONTINUE, RETURN };
+
+    // A def that has been executed, with its defaults evaluated at that time
+    struct Function {
+        const ast::FuncDef* def;
+        std::vector<Value> defaults;
+    };
+
+    // Storage of a local with a static int, float or bool type, which is
+    // kept here as long as its value fits, bools as 0 or 1
+    union Unboxed {
+        int64_t intVal;
+        double floatVal;
+    };
+
+    // States of Frame::bound besides unbound (0)
+    static constexpr char BOXED = 1;// in locals
+    static constexpr char UNBOXED = 2;// in unboxed
+
+    struct Frame {
+        const Function* function;
+        std::vector<Value> locals;
+        std::vector<char> bound;
+        std::vector<Unboxed> unboxed;// sized only when types is set
+        const ast::StaticType* types = nullptr;// of the locals, if any has one
+        Value returnValue;
+        bool tailCall = false;// the body returned to be run again, rebound
+    };
+
+    const ast::Program& program;
+    MemoCache* memo;
+    LazyProgram* lazy;
+    std::vector<Value> globals;
+    std::vector<char> globalBound;
+    std::vector<std::shared_ptr<const Function>> functions;// by symbol
+    Frame* frame = nullptr;// innermost call, nullptr at module level
+    std::vector<int64_t> constantInts;// by constant, valid where constantFits
+    std::vector<char> constantFits;
+
+    void loadConstants(uint32_t first);
+    void growTables();
+    void parseBody(const ast::FuncDef* def);
+    Flow execBlock(ast::Span<ast::Stmt*> body);
+    Flow exec(const ast::Stmt* stmt);
+    void assign(const ast::Assign* stmt);
+    void defineFunction(const ast::FuncDef* def);
+
+    Value eval(const ast::Expr* expr);
+    bool test(const ast::Expr* expr);
+    Value load(ast::Symbol name, int32_t slot);
+    void store(const ast::Target& target, const Value& value);
+    Value compare(const ast::Compare* expr);
+    Value formatString(const ast::FormatString* expr);
+    Value call(const ast::Call* expr);
+    Value callFunction(const Function& function, const ast::Call* expr);
+    void bindArguments(const Function& function, const ast::Call* expr, Frame& callee);
+    bool tailCall(const ast::Call* expr);
+
+    // Evaluation of statically typed expressions on machine numbers. They
+    // decline, with no side effects, whenever a value is not unboxed or a
+    // result needs more than an int64, and the caller falls back to Values.
+    bool evalInt(const ast::Expr* expr, int64_t& out);
+    bool evalFloat(const ast::Expr* expr, double& out);
+    bool evalNumber(const ast::Expr* expr, double& out);
+    bool loadInt(int32_t slot, int64_t& out);
+    bool loadFloat(int32_t slot, double& out);
+    bool testCompare(const ast::Compare* expr);
+    bool assignUnboxed(const ast::Target& target, const ast::Expr* value);
+    bool augAssignUnboxed(const ast::AugAssign* stmt);
+    Value box(int32_t slot) const;
+};
+
+#endif//PYTHON_INTERPRETER_INTERPRETER_H
@@ -0,0 +1,704 @@
+#include "Jit.h"
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define JIT_X86_64 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Static type of a register or global inside a compiled loop. UNDEF means
+// the loop has not written it on the way here, so the VM still holds it.
+enum class Type : uint8_t { UNDEF, INT, BOOL, CONFLICT };
+
+Type join(Type a, Type b) { return a == b ? a : Type::CONFLICT; }
+bool isNumber(Type type) { return type == Type::INT || type == Type::BOOL; }
+
+// Deoptimisations, or entries refused because values changed type or
+// outgrew int64, a loop may take before it is left to the interpreter
+constexpr uint32_t MAX_MISSES = 100;
+
+// Values are kept within 18 decimal digits on entry so the conversion
+// needs no overflow checks
+bool toInt64(const Value& value, int64_t& out) {
+    if (value.type == ValueType::BOOL) {
+        out = value.boolVal;
+        return true;
+    }
+    if (value.type != ValueType::INT) return false;
+    std::string digits = value.intVal.toString();
+    size_t i = digits[0] == '-';
+    if (digits.size() - i > 18) return false;
+    int64_t result = 0;
+    for (; i < digits.size(); i++) result = result * 10 + (digits[i] - '0');
+    out = digits[0] == '-' ? -result : result;
+    return true;
+}
+
+Value fromInt64(int64_t n, Type type) {
+    if (type == Type::BOOL) return Value(n != 0);
+    if (n == INT64_MIN) return Value(BigInt(std::string("-9223372036854775808")));
+    return Value(BigInt(static_cast<long long>(n)));
+}
+
+Type typeOf(const Value& value) {
+    if (value.type == ValueType::BOOL) return Type::BOOL;
+    int64_t unused;
+    return toInt64(value, unused) ? Type::INT : Type::UNDEF;
+}
+
+}// namespace
+
+// A register of the frame, or a global, mirrored into an int64 slot
+struct JitVar {
+    bool global;
+    uint32_t index;// register or symbol
+};
+
+// Where native code hands control back: the pc to resume at and the
+// variables to copy back into the VM, with their types at that point
+struct JitExit {
+    uint32_t resume;
+    std::vector<std::pair<uint32_t, Type>> writes;// (var, type)
+};
+
+struct JitLoop {
+    using Entry = uint32_t (*)(int64_t* slots, int64_t* snapshot);
+
+    Entry entry = nullptr;
+    void* memory = nullptr;
+    size_t size = 0;
+    std::vector<JitVar> vars;
+    std::vector<Type> entryTypes;// per var, UNDEF when the loop ignores it on entry
+    std::vector<JitExit> exits;// exits[0] is the deoptimisation exit
+    std::vector<int64_t> slots;
+    std::vector<int64_t> snapshot;
+    uint32_t misses = 0;
+};
+
+#ifdef JIT_X86_64
+
+namespace {
+
+enum Reg : uint8_t { RAX = 0, RCX = 1, RDX = 2, RSI = 6, RDI = 7, R8 = 8, R9 = 9, R10 = 10 };
+
+// Condition codes, as in the low nibble of jcc / setcc
+enum Cond : uint8_t { CC_O = 0x0, CC_E = 0x4, CC_NE = 0x5, CC_A = 0x7, CC_NS = 0x9,
+                      CC_L = 0xC, CC_GE = 0xD, CC_LE = 0xE, CC_G = 0xF };
+
+// Just the handful of x86-64 encodings the templates need. Memory operands
+// are always [rdi + disp32] (slots) or [rsi + disp32] (snapshot).
+class Assembler {
+public:
+    std::vector<uint8_t> code;
+
+    size_t here() const { return code.size(); }
+
+    void load(Reg dst, Reg base, int32_t disp) { memory(0x8B, dst, base, disp); }
+    void store(Reg base, int32_t disp, Reg src) { memory(0x89, src, base, disp); }
+    void add(Reg dst, Reg base, int32_t disp) { memory(0x03, dst, base, disp); }
+    void sub(Reg dst, Reg base, int32_t disp) { memory(0x2B, dst, base, disp); }
+    void imul(Reg dst, Reg base, int32_t disp) { memory(0xAF, dst, base, disp, true); }
+    void addReg(Reg dst, Reg src) { registers(0x03, dst, src); }
+    void xorReg(Reg dst, Reg src) { registers(0x33, dst, src); }
+    void cmpReg(Reg a, Reg b) { registers(0x3B, a, b); }
+    void testReg(Reg a, Reg b) { registers(0x85, a, b); }
+    void movReg(Reg dst, Reg src) { registers(0x8B, dst, src); }
+
+    void movImm(Reg dst, int64_t imm) {
+        rex(RAX, dst);
+        byte(0xB8 + (dst & 7));
+        for (int i = 0; i < 8; i++) byte(static_cast<uint8_t>(static_cast<uint64_t>(imm) >> (8 * i)));
+    }
+
+    void cmpImm8(Reg reg, int8_t imm) { group(0x83, 7, reg); byte(static_cast<uint8_t>(imm)); }
+    void cmpMemImm8(Reg base, int32_t disp, int8_t imm) {
+        memory(0x83, static_cast<Reg>(7), base, disp);
+        byte(static_cast<uint8_t>(imm));
+    }
+    void neg(Reg reg) { group(0xF7, 3, reg); }
+    void idiv(Reg reg) { group(0xF7, 7, reg); }
+    void dec(Reg reg) { group(0xFF, 1, reg); }
+    void cqo() { byte(0x48); byte(0x99); }
+
+    // rax = condition ? 1 : 0
+    void setFlag(Cond cond) {
+        byte(0x0F); byte(0x90 | cond); byte(0xC0);// setcc al
+        byte(0x0F); byte(0xB6); byte(0xC0);       // movzx eax, al
+    }
+
+    void returnExit(uint32_t id) {
+        byte(0xB8);// mov eax, imm32
+        dword(id);
+        byte(0xC3);
+    }
+
+    // Jumps with a rel32 to be bound later; return the position to patch
+    size_t jump() { byte(0xE9); dword(0); return here(); }
+    size_t jump(Cond cond) { byte(0x0F); byte(0x80 | cond); dword(0); return here(); }
+
+    void bind(size_t at, size_t target) {
+        int32_t rel = static_cast<int32_t>(target) - static_cast<int32_t>(at);
+        std::memcpy(&code[at - 4], &rel, 4);
+    }
+
+private:
+    void byte(uint8_t b) { code.push_back(b); }
+    void dword(uint32_t d) { for (int i = 0; i < 4; i++) byte(static_cast<uint8_t>(d >> (8 * i))); }
+    void rex(Reg reg, Reg rm) { byte(0x48 | ((reg >> 3) << 2) | (rm >> 3)); }
+
+    void memory(uint8_t opcode, Reg reg, Reg base, int32_t disp, bool twoByte = false) {
+        rex(reg, base);
+        if (twoByte) byte(0x0F);
+        byte(opcode);
+        byte(0x80 | ((reg & 7) << 3) | (base & 7));
+        dword(static_cast<uint32_t>(disp));
+    }
+
+    void registers(uint8_t opcode, Reg reg, Reg rm) {
+        rex(reg, rm);
+        byte(opcode);
+        byte(0xC0 | ((reg & 7) << 3) | (rm & 7));
+    }
+
+    void group(uint8_t opcode, uint8_t ext, Reg rm) {
+        rex(RAX, rm);
+        byte(opcode);
+        byte(0xC0 | (ext << 3) | (rm & 7));
+    }
+};
+
+bool isCompare(Opcode op) { return op >= Opcode::LT && op <= Opcode::NE; }
+
+Cond compareCond(Opcode op) {
+    switch (op) {
+        case Opcode::LT: return CC_L;
+        case Opcode::GT: return CC_G;
+        case Opcode::LE: return CC_LE;
+        case Opcode::GE: return CC_GE;
+        case Opcode::EQ: return CC_E;
+        default: return CC_NE;
+    }
+}
+
+// Translates one loop: type inference over its instructions followed by
+// template code generation
+class LoopCompiler {
+public:
+    LoopCompiler(const BytecodeProgram& program, const FunctionProto& proto, const LoopSite& site)
+        : program(program), proto(proto), site(site) {}
+
+    std::unique_ptr<JitLoop> compile(const Value* regs, const std::vector<Value>& globals,
+                                     const std::vector<char>& globalBound);
+
+private:
+    const BytecodeProgram& program;
+    const FunctionProto& proto;
+    const LoopSite& site;
+    std::unique_ptr<JitLoop> loop;
+    std::vector<uint32_t> registerVar;// register -> var, UINT32_MAX if unused
+    std::vector<uint32_t> globalVar;// symbol -> var
+    std::vector<char> written;// per var
+    std::vector<std::vector<Type>> states;// per pc of the loop, types on entry
+    std::vector<char> reached;
+    std::map<uint32_t, std::vector<Type>> exitStates;// by target pc
+    Assembler assembler;
+    std::vector<size_t> deoptJumps;
+
+    // Quickened instructions are compiled like their generic form
+    Instr instrAt(uint32_t pc) const {
+        Instr in = proto.code[pc];
+        in.op = genericOpcode(in.op);
+        return in;
+    }
+    bool inLoop(uint32_t pc) const { return pc >= site.header && pc < site.exit; }
+    // Locals and globals outlive the loop; temporaries are dead outside it
+    bool outlives(const JitVar& v) const { return v.global || v.index < proto.localCount; }
+    uint32_t var(bool global, uint32_t index);
+    bool collectVars();
+    bool inferTypes();
+    bool transfer(const Instr& instr, std::vector<Type>& types);
+    bool flow(uint32_t pc, const std::vector<Type>& types, std::vector<uint32_t>& work);
+    uint32_t addExit(uint32_t resume, const std::vector<Type>& types, int32_t extra);
+    void generate();
+    void emitInstr(uint32_t pc, const Instr& instr, const std::vector<Type>& types,
+                   std::vector<std::pair<size_t, uint32_t>>& branches);
+    void guardExact(Reg reg, Type type);
+    int32_t slot(uint32_t reg) const { return static_cast<int32_t>(8 * registerVar[reg]); }
+    int32_t globalSlot(uint32_t symbol) const { return static_cast<int32_t>(8 * globalVar[symbol]); }
+};
+
+uint32_t LoopCompiler::var(bool global, uint32_t index) {
+    std::vector<uint32_t>& table = global ? globalVar : registerVar;
+    if (table[index] == UINT32_MAX) {
+        table[index] = static_cast<uint32_t>(loop->vars.size());
+        loop->vars.push_back({global, index});
+    }
+    return table[index];
+}
+
+// Assigns a slot to every register and global the loop touches, rejecting
+// loops with instructions that have no template
+bool LoopCompiler::collectVars() {
+    registerVar.assign(proto.frameSize, UINT32_MAX);
+    globalVar.assign(program.symbols->size(), UINT32_MAX);
+    for (uint32_t pc = site.header; pc < site.exit; pc++) {
+        const Instr in = instrAt(pc);
+        switch (in.op) {
+            case Opcode::LOOP:
+            case Opcode::JUMP:
+                break;
+            case Opcode::LOADK: {
+                const Value& constant = program.constants[in.d];
+                if (typeOf(constant) == Type::UNDEF) return false;
+                var(false, in.a);
+                break;
+            }
+            case Opcode::GETGLOBAL:
+            case Opcode::SETGLOBAL:
+                var(false, in.a);
+                var(true, in.d);
+                break;
+            case Opcode::MOVE:
+            case Opcode::NEG:
+            case Opcode::NOT:
+                var(false, in.a);
+                var(false, in.b);
+                break;
+            case Opcode::ADD:
+            case Opcode::SUB:
+            case Opcode::MUL:
+            case Opcode::FLOORDIV:
+            case Opcode::MOD:
+            case Opcode::LT:
+            case Opcode::GT:
+            case Opcode::LE:
+            case Opcode::GE:
+            case Opcode::EQ:
+            case Opcode::NE:
+                var(false, in.a);
+                var(false, in.b);
+                var(false, in.c);
+                break;
+            case Opcode::JUMPIF:
+            case Opcode::JUMPIFNOT:
+            case Opcode::RETURN:
+                var(false, in.a);
+                break;
+            default:
+                return false;
+        }
+        if ((in.op == Opcode::JUMP || in.op == Opcode::JUMPIF || in.op == Opcode::JUMPIFNOT) &&
+            in.d < site.header) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Applies instr to types; false if its operands have types it has no
+// template for
+bool LoopCompiler::transfer(const Instr& in, std::vector<Type>& types) {
+    auto type = [&](uint32_t reg) { return types[registerVar[reg]]; };
+    Type result;
+    switch (in.op) {
+        case Opcode::LOADK:
+            result = typeOf(program.constants[in.d]);
+            break;
+        case Opcode::MOVE:
+            result = type(in.b);
+            break;
+        case Opcode::GETGLOBAL:
+            result = types[globalVar[in.d]];
+            break;
+        case Opcode::SETGLOBAL:
+            if (!isNumber(type(in.a))) return false;
+            types[globalVar[in.d]] = type(in.a);
+            written[globalVar[in.d]] = true;
+            return true;
+        case Opcode::ADD:
+        case Opcode::SUB:
+        case Opcode::MUL:
+            if (!isNumber(type(in.b)) || !isNumber(type(in.c))) return false;
+            result = Type::INT;
+            break;
+        case Opcode::FLOORDIV:
+        case Opcode::MOD:
+            // Anything but int // int leaves the integer domain
+            if (type(in.b) != Type::INT || type(in.c) != Type::INT) return false;
+            result = Type::INT;
+            break;
+        case Opcode::NEG:
+            if (type(in.b) != Type::INT) return false;
+            result = Type::INT;
+            break;
+        case Opcode::NOT:
+            if (!isNumber(type(in.b))) return false;
+            result = Type::BOOL;
+            break;
+        case Opcode::JUMPIF:
+        case Opcode::JUMPIFNOT:
+            return isNumber(type(in.a));
+        case Opcode::RETURN:
+            return type(in.a) != Type::CONFLICT;
+        case Opcode::LOOP:
+        case Opcode::JUMP:
+            return true;
+        default:
+            if (!isCompare(in.op) || !isNumber(type(in.b)) || !isNumber(type(in.c))) return false;
+            result = Type::BOOL;
+            break;
+    }
+    // A MOVE or GETGLOBAL may copy a value the loop has not touched yet
+    if (!isNumber(result)) return false;
+    types[registerVar[in.a]] = result;
+    written[registerVar[in.a]] = true;
+    return true;
+}
+
+bool LoopCompiler::flow(uint32_t pc, const std::vector<Type>& types, std::vector<uint32_t>& work) {
+    if (!inLoop(pc)) {
+        auto [it, inserted] = exitStates.emplace(pc, types);
+        if (!inserted) {
+            for (size_t i = 0; i < types.size(); i++) it->second[i] = join(it->second[i], types[i]);
+        }
+        return true;
+    }
+    std::vector<Type>& state = states[pc - site.header];
+    if (!reached[pc - site.header]) {
+        reached[pc - site.header] = true;
+        state = types;
+        work.push_back(pc);
+        return true;
+    }
+    bool changed = false;
+    for (size_t i = 0; i < state.size(); i++) {
+        Type joined = join(state[i], types[i]);
+        if (joined != state[i]) {
+            state[i] = joined;
+            changed = true;
+        }
+    }
+    if (changed) work.push_back(pc);
+    return true;
+}
+
+// Forward dataflow over the loop, seeded with the types seen on entry.
+// Temporaries may disagree at merge points since they are dead there, but
+// the variables handed back to the VM must have one type at every exit.
+bool LoopCompiler::inferTypes() {
+    size_t length = site.exit - site.header;
+    states.assign(length, {});
+    reached.assign(length, false);
+    written.assign(loop->vars.size(), false);
+    std::vector<uint32_t> work;
+    if (!flow(site.header, loop->entryTypes, work)) return false;
+    while (!work.empty()) {
+        uint32_t pc = work.back();
+        work.pop_back();
+        const Instr in = instrAt(pc);
+        std::vector<Type> types = states[pc - site.header];
+        if (!transfer(in, types)) return false;
+        bool ok = true;
+        switch (in.op) {
+            case Opcode::JUMP:
+                ok = flow(in.d, types, work);
+                break;
+            case Opcode::JUMPIF:
+            case Opcode::JUMPIFNOT:
+                ok = flow(in.d, types, work) && flow(pc + 1, types, work);
+                break;
+            case Opcode::RETURN:
+                break;
+            default:
+                ok = flow(pc + 1, types, work);
+                break;
+        }
+        if (!ok) return false;
+    }
+    // Leaving the loop hands the written variables back to the VM
+    for (const auto& [target, types] : exitStates) {
+        for (uint32_t i = 0; i < loop->vars.size(); i++) {
+            if (outlives(loop->vars[i]) && written[i] && types[i] == Type::CONFLICT) return false;
+        }
+    }
+    // A deoptimisation resumes at the header with the types of the header
+    for (uint32_t i = 0; i < loop->vars.size(); i++) {
+        if (outlives(loop->vars[i]) && states[0][i] == Type::CONFLICT) return false;
+    }
+    return true;
+}
+
+// Registers an exit copying back the written locals and globals, plus the
+// register extra when it is not negative
+uint32_t LoopCompiler::addExit(uint32_t resume, const std::vector<Type>& types, int32_t extra) {
+    JitExit exit{resume, {}};
+    for (uint32_t i = 0; i < loop->vars.size(); i++) {
+        const JitVar& v = loop->vars[i];
+        bool handedBack = outlives(v) || (!v.global && static_cast<int32_t>(v.index) == extra);
+        if (handedBack && written[i] && isNumber(types[i])) exit.writes.emplace_back(i, types[i]);
+    }
+    loop->exits.push_back(std::move(exit));
+    return static_cast<uint32_t>(loop->exits.size() - 1);
+}
+
+// Comparisons in the VM go through double; values beyond 2^53 have to take
+// that path to round the same way. r9 = 2^53 and r10 = 2^54 throughout.
+void LoopCompiler::guardExact(Reg reg, Type type) {
+    if (type == Type::BOOL) return;
+    assembler.movReg(R8, reg);
+    assembler.addReg(R8, R9);
+    assembler.cmpReg(R8, R10);
+    deoptJumps.push_back(assembler.jump(CC_A));
+}
+
+void LoopCompiler::emitInstr(uint32_t pc, const Instr& in, const std::vector<Type>& types,
+                             std::vector<std::pair<size_t, uint32_t>>& branches) {
+    Assembler& as = assembler;
+    auto branch = [&](size_t at, uint32_t target) { branches.emplace_back(at, target); };
+    switch (in.op) {
+        case Opcode::LOOP:
+            // Every iteration of the outermost loop starts from a snapshot
+            if (pc != site.header) break;
+            for (uint32_t i = 0; i < loop->vars.size(); i++) {
+                as.load(RAX, RDI, 8 * i);
+                as.store(RSI, 8 * i, RAX);
+            }
+            break;
+        case Opcode::LOADK: {
+            int64_t value = 0;
+            toInt64(program.constants[in.d], value);
+            as.movImm(RAX, value);
+            as.store(RDI, slot(in.a), RAX);
+            break;
+        }
+        case Opcode::MOVE:
+            as.load(RAX, RDI, slot(in.b));
+            as.store(RDI, slot(in.a), RAX);
+            break;
+        case Opcode::GETGLOBAL:
+            as.load(RAX, RDI, globalSlot(in.d));
+            as.store(RDI, slot(in.a), RAX);
+            break;
+        case Opcode::SETGLOBAL:
+            as.load(RAX, RDI, slot(in.a));
+            as.store(RDI, globalSlot(in.d), RAX);
+            break;
+        case Opcode::ADD:
+        case Opcode::SUB:
+        case Opcode::MUL:
+            as.load(RAX, RDI, slot(in.b));
+            if (in.op == Opcode::ADD) as.add(RAX, RDI, slot(in.c));
+            if (in.op == Opcode::SUB) as.sub(RAX, RDI, slot(in.c));
+            if (in.op == Opcode::MUL) as.imul(RAX, RDI, slot(in.c));
+            deoptJumps.push_back(as.jump(CC_O));
+            as.store(RDI, slot(in.a), RAX);
+            break;
+        case Opcode::FLOORDIV:
+        case Opcode::MOD: {
+            // idiv truncates; step towards negative infinity when the
+            // remainder and the divisor differ in sign
+            as.load(RCX, RDI, slot(in.c));
+            as.testReg(RCX, RCX);
+            deoptJumps.push_back(as.jump(CC_E));
+            as.cmpImm8(RCX, -1);
+            deoptJumps.push_back(as.jump(CC_E));
+            as.load(RAX, RDI, slot(in.b));
+            as.cqo();
+            as.idiv(RCX);
+            as.testReg(RDX, RDX);
+            size_t exact = as.jump(CC_E);
+            as.movReg(R8, RDX);
+            as.xorReg(R8, RCX);
+            size_t sameSign = as.jump(CC_NS);
+            if (in.op == Opcode::FLOORDIV) {
+                as.dec(RAX);
+            } else {
+                as.addReg(RDX, RCX);
+            }
+            as.bind(exact, as.here());
+            as.bind(sameSign, as.here());
+            as.store(RDI, slot(in.a), in.op == Opcode::FLOORDIV ? RAX : RDX);
+            break;
+        }
+        case Opcode::NEG:
+            as.load(RAX, RDI, slot(in.b));
+            as.neg(RAX);
+            deoptJumps.push_back(as.jump(CC_O));
+            as.store(RDI, slot(in.a), RAX);
+            break;
+        case Opcode::NOT:
+            as.load(RCX, RDI, slot(in.b));
+            as.testReg(RCX, RCX);
+            as.setFlag(CC_E);
+            as.store(RDI, slot(in.a), RAX);
+            break;
+        case Opcode::JUMP:
+            branch(as.jump(), in.d);
+            break;
+        case Opcode::JUMPIF:
+        case Opcode::JUMPIFNOT:
+            as.cmpMemImm8(RDI, slot(in.a), 0);
+            branch(as.jump(in.op == Opcode::JUMPIF ? CC_NE : CC_E), in.d);
+            break;
+        case Opcode::RETURN:
+            // The interpreter performs the return itself
+            as.returnExit(addExit(pc, types, in.a));
+            break;
+        default:
+            as.load(RAX, RDI, slot(in.b));
+            guardExact(RAX, types[registerVar[in.b]]);
+            as.load(RCX, RDI, slot(in.c));
+            guardExact(RCX, types[registerVar[in.c]]);
+            as.cmpReg(RAX, RCX);
+            as.setFlag(compareCond(in.op));
+            as.store(RDI, slot(in.a), RAX);
+            break;
+    }
+}
+
+void LoopCompiler::generate() {
+    Assembler& as = assembler;
+    as.movImm(R9, int64_t(1) << 53);
+    as.movImm(R10, int64_t(1) << 54);
+
+    // exits[0]: roll back to the snapshot and rerun the iteration in the VM
+    addExit(site.header + 1, states[0], -1);
+
+    std::vector<size_t> labels(site.exit - site.header, SIZE_MAX);
+    std::vector<std::pair<size_t, uint32_t>> branches;
+    for (uint32_t pc = site.header; pc < site.exit; pc++) {
+        labels[pc - site.header] = as.here();
+        if (!reached[pc - site.header]) continue;
+        emitInstr(pc, instrAt(pc), states[pc - site.header], branches);
+    }
+    // The range ends with the back edge, so control never falls off it
+
+    // Jumps out of the loop each get a stub returning their own exit
+    std::vector<std::pair<uint32_t, size_t>> stubs;// (target, position)
+    for (const auto& [at, target] : branches) {
+        if (inLoop(target)) {
+            as.bind(at, labels[target - site.header]);
+            continue;
+        }
+        size_t stub = SIZE_MAX;
+        for (const auto& [t, position] : stubs) {
+            if (t == target) stub = position;
+        }
+        if (stub == SIZE_MAX) {
+            stub = as.here();
+            stubs.emplace_back(target, stub);
+            as.returnExit(addExit(target, exitStates[target], -1));
+        }
+        as.bind(at, stub);
+    }
+
+    size_t deopt = as.here();
+    for (uint32_t i = 0; i < loop->vars.size(); i++) {
+        as.load(RAX, RSI, 8 * i);
+        as.store(RDI, 8 * i, RAX);
+    }
+    as.returnExit(0);
+    for (size_t at : deoptJumps) as.bind(at, deopt);
+}
+
+std::unique_ptr<JitLoop> LoopCompiler::compile(const Value* regs, const std::vector<Value>& globals,
+                                               const std::vector<char>& globalBound) {
+    loop = std::make_unique<JitLoop>();
+    if (!collectVars()) return nullptr;
+    for (const JitVar& v : loop->vars) {
+        const Value* value = v.global ? (globalBound[v.index] ? &globals[v.index] : nullptr) : &regs[v.index];
+        loop->entryTypes.push_back(outlives(v) && value ? typeOf(*value) : Type::UNDEF);
+    }
+    if (!inferTypes()) return nullptr;
+    generate();
+
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t size = (assembler.code.size() + page - 1) / page * page;
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return nullptr;
+    std::memcpy(memory, assembler.code.data(), assembler.code.size());
+    if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, size);
+        return nullptr;
+    }
+    loop->memory = memory;
+    loop->size = size;
+    loop->entry = reinterpret_cast<JitLoop::Entry>(memory);
+    loop->slots.assign(loop->vars.size(), 0);
+    loop->snapshot.assign(loop->vars.size(), 0);
+    return std::move(loop);
+}
+
+}// namespace
+
+#endif
+
+Jit::Jit(const BytecodeProgram& program, bool perfMap) : program(program), perfMap(perfMap) {}
+
+Jit::~Jit() {
+#ifdef JIT_X86_64
+    for (const auto& loop : loops) munmap(loop->memory, loop->size);
+#endif
+}
+
+JitLoop* Jit::compile(const FunctionProto& proto, const LoopSite& site, const Value* regs,
+                      const std::vector<Value>& globals, const std::vector<char>& globalBound) {
+#ifdef JIT_X86_64
+    std::unique_ptr<JitLoop> loop = LoopCompiler(program, proto, site).compile(regs, globals, globalBound);
+    if (!loop) return nullptr;
+    if (perfMap) writePerfMap(*loop, proto, site);
+    loops.push_back(std::move(loop));
+    return loops.back().get();
+#else
+    (void) proto, (void) site, (void) regs, (void) globals, (void) globalBound;
+    return nullptr;
+#endif
+}
+
+uint32_t Jit::run(JitLoop& loop, Value* regs, std::vector<Value>& globals, std::vector<char>& globalBound) {
+    if (loop.misses >= MAX_MISSES) return NOT_ENTERED;
+    for (size_t i = 0; i < loop.vars.size(); i++) {
+        if (loop.entryTypes[i] == Type::UNDEF) continue;
+        const JitVar& v = loop.vars[i];
+        const Value* value = v.global ? (globalBound[v.index] ? &globals[v.index] : nullptr) : &regs[v.index];
+        if (!value || typeOf(*value) != loop.entryTypes[i] || !toInt64(*value, loop.slots[i])) {
+            loop.misses++;
+            return NOT_ENTERED;
+        }
+    }
+
+    uint32_t id = loop.entry(loop.slots.data(), loop.snapshot.data());
+    if (id == 0) loop.misses++;
+
+    const JitExit& exit = loop.exits[id];
+    for (const auto& [i, type] : exit.writes) {
+        const JitVar& v = loop.vars[i];
+        if (v.global) {
+            globals[v.index] = fromInt64(loop.slots[i], type);
+            globalBound[v.index] = true;
+        } else {
+            regs[v.index] = fromInt64(loop.slots[i], type);
+        }
+    }
+    return exit.resume;
+}
+
+void Jit::writePerfMap(const JitLoop& loop, const FunctionProto& proto, const LoopSite& site) {
+#ifdef JIT_X86_64
+    std::string path = "/tmp/perf-" + std::to_string(getpid()) + ".map";
+    FILE* file = std::fopen(path.c_str(), "a");
+    if (!file) return;
+    const std::string& name = proto.name == ast::NO_SYMBOL ? std::string("<module>") : program.symbols->name(proto.name);
+    std::fprintf(file, "%lx %zx pyjit:%s:loop@%u\n", reinterpret_cast<unsigned long>(loop.memory), loop.size,
+                 name.c_str(), site.header);
+    std::fclose(file);
+#else
+    (void) loop, (void) proto, (void) site;
+#endif
+}
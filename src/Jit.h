@@ -0,0 +1,49 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_JIT_H
+#define PYTHON_INTERPRETER_JIT_H
+
+#include "Bytecode.h"
+#include "Value.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Baseline template JIT for hot while loops of the bytecode VM.
+//
+// A loop qualifies when, at the time it gets hot, every value it reads is an
+// int or a bool and its body only moves, compares and does integer
+// arithmetic on them. Each bytecode instruction is then translated to a
+// fixed x86-64 template operating on int64 slots, one per register or
+// global the loop touches. Overflow, zero divisors and comparisons outside
+// the range doubles represent exactly fail a guard: the slots are rolled
+// back to the snapshot taken at the loop header and the interpreter
+// resumes with that iteration.
+//
+// Only available on x86-64 Linux; elsewhere compile() always declines.
+class Jit {
+public:
+    static constexpr uint32_t NOT_ENTERED = UINT32_MAX;
+
+    // perfMap: append every compiled loop to /tmp/perf-<pid>.map
+    Jit(const BytecodeProgram& program, bool perfMap);
+    ~Jit();
+
+    // Compiles loop of proto for the types its values have now, or returns
+    // nullptr when the loop does not qualify
+    JitLoop* compile(const FunctionProto& proto, const LoopSite& loop, const Value* regs,
+                     const std::vector<Value>& globals, const std::vector<char>& globalBound);
+
+    // Runs a compiled loop on the frame's registers. Returns the pc the
+    // interpreter resumes at, or NOT_ENTERED when the current values do not
+    // match what the loop was compiled for.
+    uint32_t run(JitLoop& loop, Value* regs, std::vector<Value>& globals, std::vector<char>& globalBound);
+
+private:
+    const BytecodeProgram& program;
+    bool perfMap;
+    std::vector<std::unique_ptr<JitLoop>> loops;
+
+    void writePerfMap(const JitLoop& loop, const FunctionProto& proto, const LoopSite& site);
+};
+
+#endif//PYTHON_INTERPRETER_JIT_H
@@ -0,0 +1,339 @@
+#include "LoopHoister.h"
+#include "Memo.h"
+#include "Resolver.h"
+#include <string>
+#include <vector>
+
+using namespace ast;
+
+namespace {
+
+// When an expression runs, relative to the start of the loop being optimized
+enum class Reach {
+    ENTRY,     // the loop condition: whenever the loop is reached
+    FIRST,     // every iteration that starts, before any branching
+    MAYBE,     // only on some paths
+};
+
+// Calls f(operand, conditional) on each direct operand of expr in evaluation
+// order; conditional operands may be skipped by short-circuiting
+template <typename F>
+void forEachOperand(Expr* expr, F&& f) {
+    switch (expr->kind) {
+        case ExprKind::CONSTANT:
+        case ExprKind::NAME:
+            break;
+        case ExprKind::UNARY:
+            f(static_cast<Unary*>(expr)->operand, false);
+            break;
+        case ExprKind::BINARY:
+            f(static_cast<Binary*>(expr)->lhs, false);
+            f(static_cast<Binary*>(expr)->rhs, false);
+            break;
+        case ExprKind::COMPARE: {
+            Span<Expr*> operands = static_cast<Compare*>(expr)->operands;
+            for (size_t i = 0; i < operands.size; i++) f(operands[i], i > 1);
+            break;
+        }
+        case ExprKind::BOOL_OP: {
+            Span<Expr*> operands = static_cast<BoolOp*>(expr)->operands;
+            for (size_t i = 0; i < operands.size; i++) f(operands[i], i > 0);
+            break;
+        }
+        case ExprKind::CALL:
+            for (Argument& arg : static_cast<Call*>(expr)->args) f(arg.value, false);
+            break;
+        case ExprKind::FORMAT:
+            for (FormatPart& part : static_cast<FormatString*>(expr)->parts) {
+                for (Expr*& value : part.values) f(value, false);
+            }
+            break;
+    }
+}
+
+class LoopHoister {
+public:
+    explicit LoopHoister(Program& program)
+        : program(program), pure(pureFunctions(program)), moduleAssigned(moduleAssignedNames(program)) {}
+
+    // Optimizes every loop in body, inner loops first, and returns body with
+    // the hoisted assignments in front of their loops
+    Span<Stmt*> hoistBlock(Span<Stmt*> body) {
+        std::vector<Stmt*> out;
+        for (Stmt* stmt : body) {
+            switch (stmt->kind) {
+                case StmtKind::IF: {
+                    auto ifStmt = static_cast<If*>(stmt);
+                    for (IfBranch& branch : ifStmt->branches) branch.body = hoistBlock(branch.body);
+                    ifStmt->orelse = hoistBlock(ifStmt->orelse);
+                    break;
+                }
+                case StmtKind::WHILE: {
+                    auto loop = static_cast<While*>(stmt);
+                    loop->body = hoistBlock(loop->body);
+                    hoistLoop(loop, out);
+                    break;
+                }
+                case StmtKind::FUNCDEF: {
+                    auto def = static_cast<FuncDef*>(stmt);
+                    FuncDef* outer = function;
+                    function = def;
+                    def->body = hoistBlock(def->body);
+                    function = outer;
+                    break;
+                }
+                default:
+                    break;
+            }
+            out.push_back(stmt);
+        }
+        if (out.size() == body.size) return body;
+        return copyToArena(program.arena, out);
+    }
+
+private:
+    Program& program;
+    std::vector<char> pure;
+    std::vector<char> moduleAssigned;
+    FuncDef* function = nullptr;// enclosing def, nullptr at module level
+    uint32_t temporaries = 0;
+
+    // State of the loop being optimized
+    std::vector<char> assigned;// by symbol, names the loop assigns
+    bool opaqueCalls = false;  // the loop calls user functions that may assign globals
+    bool guardable = false;    // the loop condition may be evaluated once more
+    bool effects = false;      // the first iteration may have done something observable
+    std::vector<Stmt*> hoisted;// run before the loop
+    std::vector<Stmt*> guarded;// run before the loop if its condition holds
+
+    bool opaque(const Call* call) const {
+        return call->builtin == Builtin::NONE && !pure[call->callee];
+    }
+
+    bool hasEffects(const Call* call) const {
+        return call->builtin == Builtin::PRINT || opaque(call);
+    }
+
+    // Parameters are always local; other slotted names can only fall back
+    // to a global if module code assigns that name
+    bool certainlyLocal(const Name* name) const {
+        if (name->slot == NO_SLOT) return false;
+        return static_cast<size_t>(name->slot) < function->params.size || name->name >= moduleAssigned.size()
+            || !moduleAssigned[name->name];
+    }
+
+    void hoistLoop(While* loop, std::vector<Stmt*>& out) {
+        assigned.assign(program.symbols.size(), false);
+        opaqueCalls = false;
+        scanExpr(loop->condition);
+        scanBlock(loop->body);
+
+        guardable = !hasEffectsIn(loop->condition);
+        effects = false;
+        hoisted.clear();
+        guarded.clear();
+        loop->condition = hoistExpr(loop->condition, Reach::ENTRY);
+        hoistStmts(loop->body, Reach::FIRST);
+
+        out.insert(out.end(), hoisted.begin(), hoisted.end());
+        if (guarded.empty()) return;
+        auto guard = program.make<If>();
+        guard->branches = copyToArena(program.arena, std::vector<IfBranch>{{loop->condition, copyToArena(program.arena, guarded)}});
+        out.push_back(guard);
+    }
+
+    // Collects the names the loop assigns and whether it calls opaque functions.
+    // Nested function bodies do not run as part of the loop and are skipped.
+    void scanBlock(Span<Stmt*> body) {
+        for (Stmt* stmt : body) {
+            switch (stmt->kind) {
+                case StmtKind::EXPR:
+                    scanExpr(static_cast<ExprStmt*>(stmt)->value);
+                    break;
+                case StmtKind::ASSIGN: {
+                    auto assign = static_cast<Assign*>(stmt);
+                    for (const Span<Target>& targets : assign->targets) {
+                        for (const Target& target : targets) scanTarget(target);
+                    }
+                    for (Expr* value : assign->values) scanExpr(value);
+                    break;
+                }
+                case StmtKind::AUG_ASSIGN: {
+                    auto assign = static_cast<AugAssign*>(stmt);
+                    scanTarget(assign->target);
+                    scanExpr(assign->value);
+                    break;
+                }
+                case StmtKind::IF: {
+                    auto ifStmt = static_cast<If*>(stmt);
+                    for (const IfBranch& branch : ifStmt->branches) {
+                        scanExpr(branch.condition);
+                        scanBlock(branch.body);
+                    }
+                    scanBlock(ifStmt->orelse);
+                    break;
+                }
+                case StmtKind::WHILE: {
+                    auto loop = static_cast<While*>(stmt);
+                    scanExpr(loop->condition);
+                    scanBlock(loop->body);
+                    break;
+                }
+                case StmtKind::FUNCDEF:
+                    for (Expr* value : static_cast<FuncDef*>(stmt)->defaults) scanExpr(value);
+                    break;
+                case StmtKind::RETURN: {
+                    auto ret = static_cast<Return*>(stmt);
+                    if (ret->value) scanExpr(ret->value);
+                    break;
+                }
+                case StmtKind::BREAK:
+                case StmtKind::CONTINUE:
+                    break;
+            }
+        }
+    }
+
+    void scanTarget(const Target& target) {
+        if (target.name != NO_SYMBOL) assigned[target.name] = true;
+    }
+
+    void scanExpr(Expr* expr) {
+        if (expr->kind == ExprKind::CALL && opaque(static_cast<Call*>(expr))) opaqueCalls = true;
+        forEachOperand(expr, [this](Expr* operand, bool) { scanExpr(operand); });
+    }
+
+    bool hasEffectsIn(Expr* expr) const {
+        if (expr->kind == ExprKind::CALL && hasEffects(static_cast<Call*>(expr))) return true;
+        bool result = false;
+        forEachOperand(expr, [&](Expr* operand, bool) { result = result || hasEffectsIn(operand); });
+        return result;
+    }
+
+    // Whether expr has the same value on every iteration
+    bool invariant(Expr* expr) const {
+        if (expr->kind == ExprKind::NAME) {
+            auto name = static_cast<const Name*>(expr);
+            if (name->name >= assigned.size()) return true;// a temporary hoisted out of this loop
+            return !assigned[name->name] && (!opaqueCalls || certainlyLocal(name));
+        }
+        if (expr->kind == ExprKind::CALL && hasEffects(static_cast<Call*>(expr))) return false;
+        bool result = true;
+        forEachOperand(expr, [&](Expr* operand, bool) { result = result && invariant(operand); });
+        return result;
+    }
+
+    // Integer // and % throw on a zero divisor; user functions may fail or
+    // run forever
+    bool mayFail(Expr* expr) const {
+        if (expr->kind == ExprKind::CALL && static_cast<Call*>(expr)->builtin == Builtin::NONE) return true;
+        if (expr->kind == ExprKind::BINARY) {
+            auto binary = static_cast<const Binary*>(expr);
+            bool division = binary->op == BinaryOp::FLOORDIV || binary->op == BinaryOp::MOD;
+            if (division && !nonzeroConstant(binary->rhs)) return true;
+        }
+        bool result = false;
+        forEachOperand(expr, [&](Expr* operand, bool) { result = result || mayFail(operand); });
+        return result;
+    }
+
+    bool nonzeroConstant(const Expr* expr) const {
+        if (expr->kind != ExprKind::CONSTANT) return false;
+        const Value& value = program.constants[static_cast<const Constant*>(expr)->index];
+        return value.type != ValueType::INT || value.toBool();
+    }
+
+    void hoistStmts(Span<Stmt*> body, Reach reach) {
+        for (Stmt* stmt : body) {
+            switch (stmt->kind) {
+                case StmtKind::EXPR: {
+                    auto exprStmt = static_cast<ExprStmt*>(stmt);
+                    exprStmt->value = hoistExpr(exprStmt->value, reach);
+                    break;
+                }
+                case StmtKind::ASSIGN:
+                    for (Expr*& value : static_cast<Assign*>(stmt)->values) value = hoistExpr(value, reach);
+                    break;
+                case StmtKind::AUG_ASSIGN: {
+                    auto assign = static_cast<AugAssign*>(stmt);
+                    assign->value = hoistExpr(assign->value, reach);
+                    break;
+                }
+                case StmtKind::IF: {
+                    auto ifStmt = static_cast<If*>(stmt);
+                    for (IfBranch& branch : ifStmt->branches) {
+                        branch.condition = hoistExpr(branch.condition, reach);
+                        reach = Reach::MAYBE;
+                        hoistStmts(branch.body, reach);
+                    }
+                    hoistStmts(ifStmt->orelse, reach);
+                    break;
+                }
+                case StmtKind::WHILE: {
+                    auto loop = static_cast<While*>(stmt);
+                    loop->condition = hoistExpr(loop->condition, reach);
+                    reach = Reach::MAYBE;
+                    hoistStmts(loop->body, reach);
+                    break;
+                }
+                case StmtKind::FUNCDEF:
+                    for (Expr*& value : static_cast<FuncDef*>(stmt)->defaults) value = hoistExpr(value, reach);
+                    break;
+                case StmtKind::RETURN: {
+                    auto ret = static_cast<Return*>(stmt);
+                    if (!ret->value) break;
+                    if (!ret->selfCall) {
+                        ret->value = hoistExpr(ret->value, reach);
+                        break;
+                    }
+                    // Keep the call itself so that it still runs as a tail call
+                    forEachOperand(ret->value, [&](Expr*& operand, bool) { operand = hoistExpr(operand, reach); });
+                    break;
+                }
+                case StmtKind::BREAK:
+                case StmtKind::CONTINUE:
+                    reach = Reach::MAYBE;
+                    break;
+            }
+        }
+    }
+
+    // Replaces the largest invariant subexpressions of expr by temporaries.
+    // Those that may fail are only moved when the first iteration runs them
+    // before anything observable.
+    Expr* hoistExpr(Expr* expr, Reach reach) {
+        if (expr->kind != ExprKind::CONSTANT && expr->kind != ExprKind::NAME && invariant(expr)) {
+            if (!mayFail(expr)) return hoist(expr, hoisted);
+            if (!effects && reach == Reach::ENTRY) return hoist(expr, hoisted);
+            if (!effects && reach == Reach::FIRST && guardable) return hoist(expr, guarded);
+        }
+        forEachOperand(expr, [&](Expr*& operand, bool conditional) {
+            operand = hoistExpr(operand, conditional ? Reach::MAYBE : reach);
+        });
+        if (expr->kind == ExprKind::CALL && hasEffects(static_cast<Call*>(expr))) effects = true;
+        return expr;
+    }
+
+    // Appends temporary = value to into and returns a read of the temporary
+    Expr* hoist(Expr* value, std::vector<Stmt*>& into) {
+        Target target;
+        target.name = program.symbols.intern("$loop" + std::to_string(temporaries++));
+        target.slot = function ? static_cast<int32_t>(function->localCount++) : NO_SLOT;
+
+        auto assign = program.make<Assign>();
+        assign->targets = copyToArena(program.arena, std::vector<Span<Target>>{copyToArena(program.arena, std::vector<Target>{target})});
+        assign->values = copyToArena(program.arena, std::vector<Expr*>{value});
+        into.push_back(assign);
+
+        auto name = program.make<Name>();
+        name->name = target.name;
+        name->slot = target.slot;
+        return name;
+    }
+};
+
+}// namespace
+
+void hoistLoopInvariants(Program& program) {
+    program.body = LoopHoister(program).hoistBlock(program.body);
+}
@@ -0,0 +1,26 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_LOOPHOISTER_H
+#define PYTHON_INTERPRETER_LOOPHOISTER_H
+
+#include "Ast.h"
+
+// Moves the expressions a while loop recomputes with the same result on
+// every iteration out of the loop: they are evaluated once into a fresh
+// temporary just before it, and the loop reads the temporary instead.
+//
+// An expression qualifies when it only reads names the loop never assigns
+// and only calls builtins other than print or pure user functions (see
+// pureFunctions). When the loop also calls impure user functions, which may
+// assign globals, only the names that are certainly local count as
+// unchanged. Expressions that can fail or never finish - // and % by a
+// divisor that may be zero, calls of user functions - are only hoisted
+// from code the first iteration runs before anything observable, behind
+// an if that tests the loop condition once more, so they still run only
+// when the loop would have run them first.
+//
+// Runs after resolveScopes and foldConstants. Temporaries take new local
+// slots inside functions and new globals at module level; their names are
+// not identifiers, so they never clash with the program's own.
+void hoistLoopInvariants(ast::Program& program);
+
+#endif//PYTHON_INTERPRETER_LOOPHOISTER_H
@@ -0,0 +1,266 @@
+#include "Memo.h"
+#include "Resolver.h"
+#include <iomanip>
+
+using namespace ast;
+
+namespace {
+
+// Checks one def for side effects and reads of state other than its
+// arguments, collecting the user functions it calls
+class PurityChecker {
+public:
+    PurityChecker(const FuncDef* def, const std::vector<char>& moduleAssigned)
+        : def(def), moduleAssigned(moduleAssigned) {}
+
+    bool check(std::vector<Symbol>& callees) {
+        calls = &callees;
+        return checkBlock(def->body);
+    }
+
+private:
+    const FuncDef* def;
+    const std::vector<char>& moduleAssigned;
+    std::vector<Symbol>* calls = nullptr;
+
+    // Parameters are always local; other slotted names can only fall back
+    // to a global if module code assigns that name
+    bool isLocal(Symbol name, int32_t slot) const {
+        if (slot == NO_SLOT) return false;
+        return static_cast<size_t>(slot) < def->params.size || !moduleAssigned[name];
+    }
+
+    bool checkTarget(const Target& target) const {
+        return target.name == NO_SYMBOL || isLocal(target.name, target.slot);
+    }
+
+    bool checkBlock(Span<Stmt*> body) {
+        for (const Stmt* stmt : body) {
+            if (!checkStmt(stmt)) return false;
+        }
+        return true;
+    }
+
+    bool checkStmt(const Stmt* stmt) {
+        switch (stmt->kind) {
+            case StmtKind::EXPR:
+                return checkExpr(static_cast<const ExprStmt*>(stmt)->value);
+            case StmtKind::ASSIGN: {
+                auto assign = static_cast<const Assign*>(stmt);
+                for (const Span<Target>& targets : assign->targets) {
+                    for (const Target& target : targets) {
+                        if (!checkTarget(target)) return false;
+                    }
+                }
+                for (const Expr* value : assign->values) {
+                    if (!checkExpr(value)) return false;
+                }
+                return true;
+            }
+            case StmtKind::AUG_ASSIGN: {
+                auto assign = static_cast<const AugAssign*>(stmt);
+                return checkTarget(assign->target) && checkExpr(assign->value);
+            }
+            case StmtKind::IF: {
+                auto ifStmt = static_cast<const If*>(stmt);
+                for (const IfBranch& branch : ifStmt->branches) {
+                    if (!checkExpr(branch.condition) || !checkBlock(branch.body)) return false;
+                }
+                return checkBlock(ifStmt->orelse);
+            }
+            case StmtKind::WHILE: {
+                auto loop = static_cast<const While*>(stmt);
+                return checkExpr(loop->condition) && checkBlock(loop->body);
+            }
+            case StmtKind::FUNCDEF:
+                return false;
+            case StmtKind::RETURN: {
+                auto ret = static_cast<const Return*>(stmt);
+                return !ret->value || checkExpr(ret->value);
+            }
+            case StmtKind::BREAK:
+            case StmtKind::CONTINUE:
+                return true;
+        }
+        return false;
+    }
+
+    bool checkExpr(const Expr* expr) {
+        switch (expr->kind) {
+            case ExprKind::CONSTANT:
+                return true;
+            case ExprKind::NAME: {
+                auto name = static_cast<const Name*>(expr);
+                return isLocal(name->name, name->slot);
+            }
+            case ExprKind::UNARY:
+                return checkExpr(static_cast<const Unary*>(expr)->operand);
+            case ExprKind::BINARY: {
+                auto binary = static_cast<const Binary*>(expr);
+                return checkExpr(binary->lhs) && checkExpr(binary->rhs);
+            }
+            case ExprKind::COMPARE:
+                for (const Expr* operand : static_cast<const Compare*>(expr)->operands) {
+                    if (!checkExpr(operand)) return false;
+                }
+                return true;
+            case ExprKind::BOOL_OP:
+                for (const Expr* operand : static_cast<const BoolOp*>(expr)->operands) {
+                    if (!checkExpr(operand)) return false;
+                }
+                return true;
+            case ExprKind::CALL: {
+                auto call = static_cast<const Call*>(expr);
+                if (call->builtin == Builtin::PRINT) return false;
+                if (call->builtin == Builtin::NONE) calls->push_back(call->callee);
+                for (const Argument& arg : call->args) {
+                    if (!checkExpr(arg.value)) return false;
+                }
+                return true;
+            }
+            case ExprKind::FORMAT:
+                for (const FormatPart& part : static_cast<const FormatString*>(expr)->parts) {
+                    for (const Expr* value : part.values) {
+                        if (!checkExpr(value)) return false;
+                    }
+                }
+                return true;
+        }
+        return false;
+    }
+};
+
+// Appends the key of one value; false for values without an exact text
+bool appendKey(const Value& value, std::string& key) {
+    switch (value.type) {
+        case ValueType::NONE:
+            key += 'N';
+            return true;
+        case ValueType::BOOL:
+            key += value.boolVal ? 'T' : 'F';
+            return true;
+        case ValueType::INT:
+            key += 'i';
+            key += value.intVal.toString();
+            key += ';';
+            return true;
+        case ValueType::STRING:
+            key += 's';
+            key += std::to_string(value.stringVal.size());
+            key += ':';
+            key += value.stringVal;
+            return true;
+        case ValueType::FLOAT:
+            return false;
+    }
+    return false;
+}
+
+size_t sizeOf(const Value& value) {
+    size_t bytes = sizeof(Value) + value.stringVal.capacity();
+    if (value.type == ValueType::INT) bytes += value.intVal.toString().size();
+    return bytes;
+}
+
+}// namespace
+
+std::vector<char> pureFunctions(const Program& program) {
+    size_t symbolCount = program.symbols.size();
+    std::vector<uint32_t> defs = definitionCounts(program);
+    std::vector<char> moduleAssigned = moduleAssignedNames(program);
+
+    // Names that are never defined always call to None, which is pure too
+    std::vector<char> pure(symbolCount, true);
+    std::vector<std::vector<Symbol>> callees(symbolCount);
+    std::vector<char> candidate(symbolCount, false);
+    std::vector<size_t> position(symbolCount, 0);// of the def among the module's statements
+    for (size_t i = 0; i < program.body.size; i++) {
+        const Stmt* stmt = program.body[i];
+        if (stmt->kind != StmtKind::FUNCDEF) continue;
+        auto def = static_cast<const FuncDef*>(stmt);
+        candidate[def->name] = defs[def->name] == 1 && PurityChecker(def, moduleAssigned).check(callees[def->name]);
+        position[def->name] = i;
+    }
+    for (size_t symbol = 0; symbol < symbolCount; symbol++) {
+        if (defs[symbol] > 0 && !candidate[symbol]) pure[symbol] = false;
+    }
+    // A callee defined further down may not exist yet when the caller runs,
+    // and the None such a call gives would be cached for good
+    for (size_t symbol = 0; symbol < symbolCount; symbol++) {
+        if (!candidate[symbol]) continue;
+        for (Symbol callee : callees[symbol]) {
+            if (defs[callee] > 0 && position[callee] > position[symbol]) pure[symbol] = false;
+        }
+    }
+
+    // A function calling an impure one is impure as well
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (size_t symbol = 0; symbol < symbolCount; symbol++) {
+            if (!pure[symbol]) continue;
+            for (Symbol callee : callees[symbol]) {
+                if (pure[callee]) continue;
+                pure[symbol] = false;
+                changed = true;
+                break;
+            }
+        }
+    }
+    // Only defined functions are worth caching
+    for (size_t symbol = 0; symbol < symbolCount; symbol++) pure[symbol] = pure[symbol] && candidate[symbol];
+    return pure;
+}
+
+MemoCache::MemoCache(std::vector<char> pure, size_t capacity)
+    : pure(std::move(pure)), capacity(capacity), stats(this->pure.size()) {}
+
+bool MemoCache::makeKey(Symbol function, const Value* params, size_t count, std::string& key) {
+    key = std::to_string(function);
+    key += '(';
+    for (size_t i = 0; i < count; i++) {
+        if (!appendKey(params[i], key)) return false;
+    }
+    return true;
+}
+
+const Value* MemoCache::lookup(Symbol function, const std::string& key) {
+    auto it = index.find(key);
+    if (it == index.end()) {
+        stats[function].misses++;
+        return nullptr;
+    }
+    stats[function].hits++;
+    entries.splice(entries.begin(), entries, it->second);
+    return &it->second->result;
+}
+
+void MemoCache::store(std::string key, const Value& result) {
+    size_t bytes = 2 * key.size() + sizeOf(result) + sizeof(Entry) + 64;// list and hash nodes
+    if (bytes > capacity || index.count(key)) return;
+    while (used + bytes > capacity) {
+        used -= entries.back().bytes;
+        index.erase(entries.back().key);
+        entries.pop_back();
+        evictions++;
+    }
+    entries.push_front(Entry{std::move(key), result, bytes});
+    index.emplace(entries.front().key, entries.begin());
+    used += bytes;
+}
+
+void MemoCache::report(std::ostream& out, const SymbolTable& symbols) const {
+    size_t hits = 0;
+    size_t misses = 0;
+    out << std::fixed << std::setprecision(1);
+    for (size_t symbol = 0; symbol < stats.size(); symbol++) {
+        const Stats& s = stats[symbol];
+        if (s.hits + s.misses == 0) continue;
+        out << "memo " << symbols.name(symbol) << ": " << s.hits << " hits, " << s.misses << " misses, "
+            << 100.0 * s.hits / (s.hits + s.misses) << "% hit rate\n";
+        hits += s.hits;
+        misses += s.misses;
+    }
+    double rate = hits + misses ? 100.0 * hits / (hits + misses) : 0.0;
+    out << "memo total: " << hits << " hits, " << misses << " misses, " << rate << "% hit rate, "
+        << entries.size() << " entries, " << used / 1024 << " KiB, " << evictions << " evictions\n";
+}
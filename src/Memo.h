@@ -0,0 +1,62 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_MEMO_H
+#define PYTHON_INTERPRETER_MEMO_H
+
+#include "Ast.h"
+#include "Value.h"
+#include <list>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Flags, by symbol, the user functions whose result depends only on their
+// arguments. Such a function has exactly one def, at the top level of the
+// module, so its name always means the same code. Its body reads and
+// writes only names that are certainly local, never prints or defines
+// functions, and only calls builtins or other pure functions defined
+// before it.
+std::vector<char> pureFunctions(const ast::Program& program);
+
+// Results of calls of pure functions, keyed on the function and its
+// argument values, evicting the least recently used entries beyond a
+// memory budget
+class MemoCache {
+public:
+    MemoCache(std::vector<char> pure, size_t capacity);
+
+    bool memoizes(ast::Symbol function) const { return pure[function]; }
+
+    // Builds the key of a call from the values of all parameters. Floats
+    // print inexactly, so calls with one get no key and are not cached.
+    static bool makeKey(ast::Symbol function, const Value* params, size_t count, std::string& key);
+
+    // The cached result for key, or nullptr; either way counted for function
+    const Value* lookup(ast::Symbol function, const std::string& key);
+    void store(std::string key, const Value& result);
+
+    // Hit rates of every function that was looked up
+    void report(std::ostream& out, const ast::SymbolTable& symbols) const;
+
+private:
+    struct Entry {
+        std::string key;
+        Value result;
+        size_t bytes;
+    };
+
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+    };
+
+    std::vector<char> pure;
+    size_t capacity;
+    size_t used = 0;
+    size_t evictions = 0;
+    std::list<Entry> entries;// most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    std::vector<Stats> stats;// by symbol
+};
+
+#endif//PYTHON_INTERPRETER_MEMO_H
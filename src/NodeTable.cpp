@@ -0,0 +1,279 @@
+#include "NodeTable.h"
+#include "Python3ParserBaseVisitor.h"
+
+namespace {
+
+using antlr4::tree::ParseTree;
+using antlr4::tree::TerminalNode;
+
+Op tokenOp(size_t tokenType) {
+    switch (tokenType) {
+        case Python3Parser::ADD:
+        case Python3Parser::ADD_ASSIGN: return Op::ADD;
+        case Python3Parser::MINUS:
+        case Python3Parser::SUB_ASSIGN: return Op::SUB;
+        case Python3Parser::STAR:
+        case Python3Parser::MULT_ASSIGN: return Op::MUL;
+        case Python3Parser::DIV:
+        case Python3Parser::DIV_ASSIGN: return Op::DIV;
+        case Python3Parser::IDIV:
+        case Python3Parser::IDIV_ASSIGN: return Op::FLOORDIV;
+        case Python3Parser::MOD:
+        case Python3Parser::MOD_ASSIGN: return Op::MOD;
+        case Python3Parser::LESS_THAN: return Op::LT;
+        case Python3Parser::GREATER_THAN: return Op::GT;
+        case Python3Parser::LT_EQ: return Op::LE;
+        case Python3Parser::GT_EQ: return Op::GE;
+        case Python3Parser::EQUALS: return Op::EQ;
+        case Python3Parser::NOT_EQ_1:
+        case Python3Parser::NOT_EQ_2: return Op::NE;
+        default: return Op::NONE;
+    }
+}
+
+// Operator of a comp_op / addorsub_op / muldivmod_op / augassign context,
+// all of which wrap a single operator token
+Op ruleOp(antlr4::ParserRuleContext* ctx) {
+    auto terminal = static_cast<TerminalNode*>(ctx->children[0]);
+    return tokenOp(terminal->getSymbol()->getType());
+}
+
+}// namespace
+
+class NodeTableBuilder : public Python3ParserBaseVisitor {
+public:
+    explicit NodeTableBuilder(NodeTable& table) : table(table) {}
+
+    std::any visitFile_input(Python3Parser::File_inputContext *ctx) override {
+        add(ctx, ctx->stmt());
+        return visitChildren(ctx);
+    }
+
+    std::any visitSuite(Python3Parser::SuiteContext *ctx) override {
+        if (ctx->simple_stmt()) {
+            add(ctx, std::vector<ParseTree*>{ctx->simple_stmt()});
+        } else {
+            add(ctx, ctx->stmt());
+        }
+        return visitChildren(ctx);
+    }
+
+    std::any visitExpr_stmt(Python3Parser::Expr_stmtContext *ctx) override {
+        std::vector<Op> ops;
+        if (ctx->augassign()) ops.push_back(ruleOp(ctx->augassign()));
+        auto testlists = ctx->testlist();
+        add(ctx, testlists, ops);
+        visitChildren(ctx);
+
+        // Every testlist but the value on the right is assigned to
+        for (size_t i = 0; i + 1 < testlists.size(); i++) {
+            addTargets(testlists[i]);
+        }
+        return nullptr;
+    }
+
+    std::any visitIf_stmt(Python3Parser::If_stmtContext *ctx) override {
+        auto tests = ctx->test();
+        auto suites = ctx->suite();
+        std::vector<ParseTree*> kids;
+        for (size_t i = 0; i < suites.size(); i++) {
+            if (i < tests.size()) kids.push_back(tests[i]);
+            kids.push_back(suites[i]);
+        }
+        add(ctx, kids);
+        return visitChildren(ctx);
+    }
+
+    std::any visitOr_test(Python3Parser::Or_testContext *ctx) override {
+        add(ctx, ctx->and_test());
+        return visitChildren(ctx);
+    }
+
+    std::any visitAnd_test(Python3Parser::And_testContext *ctx) override {
+        add(ctx, ctx->not_test());
+        return visitChildren(ctx);
+    }
+
+    std::any visitComparison(Python3Parser::ComparisonContext *ctx) override {
+        std::vector<Op> ops;
+        for (auto op : ctx->comp_op()) ops.push_back(ruleOp(op));
+        add(ctx, ctx->arith_expr(), ops);
+        return visitChildren(ctx);
+    }
+
+    std::any visitArith_expr(Python3Parser::Arith_exprContext *ctx) override {
+        std::vector<Op> ops;
+        for (auto op : ctx->addorsub_op()) ops.push_back(ruleOp(op));
+        add(ctx, ctx->term(), ops);
+        return visitChildren(ctx);
+    }
+
+    std::any visitTerm(Python3Parser::TermContext *ctx) override {
+        std::vector<Op> ops;
+        for (auto op : ctx->muldivmod_op()) ops.push_back(ruleOp(op));
+        add(ctx, ctx->factor(), ops);
+        return visitChildren(ctx);
+    }
+
+    std::any visitFactor(Python3Parser::FactorContext *ctx) override {
+        if (ctx->factor()) {
+            auto sign = static_cast<TerminalNode*>(ctx->children[0]);
+            Op op = sign->getSymbol()->getType() == Python3Parser::MINUS ? Op::NEG : Op::POS;
+            add(ctx, std::vector<ParseTree*>{ctx->factor()}, {op});
+        } else {
+            add(ctx, std::vector<ParseTree*>{ctx->atom_expr()});
+        }
+        return visitChildren(ctx);
+    }
+
+    std::any visitTrailer(Python3Parser::TrailerContext *ctx) override {
+        if (ctx->arglist()) {
+            add(ctx, ctx->arglist()->argument());
+        } else {
+            add(ctx, std::vector<ParseTree*>{});
+        }
+        return visitChildren(ctx);
+    }
+
+    std::any visitArgument(Python3Parser::ArgumentContext *ctx) override {
+        auto tests = ctx->test();
+        uint32_t id = add(ctx, tests);
+        if (tests.size() == 2) {
+            setText(id, tests[0]->getText());
+        }
+        return visitChildren(ctx);
+    }
+
+    std::any visitTestlist(Python3Parser::TestlistContext *ctx) override {
+        add(ctx, ctx->test());
+        return visitChildren(ctx);
+    }
+
+    std::any visitAtom(Python3Parser::AtomContext *ctx) override {
+        AtomKind kind;
+        std::vector<ParseTree*> strings;
+        std::string text;
+        if (ctx->NAME()) {
+            kind = AtomKind::NAME;
+            text = ctx->NAME()->getText();
+        } else if (ctx->NUMBER()) {
+            kind = AtomKind::NUMBER;
+            text = ctx->NUMBER()->getText();
+        } else if (!ctx->STRING().empty()) {
+            kind = AtomKind::STRING;
+            for (auto str : ctx->STRING()) {
+                addLiteral(str);
+                strings.push_back(str);
+            }
+        } else if (ctx->NONE()) {
+            kind = AtomKind::NONE;
+        } else if (ctx->TRUE()) {
+            kind = AtomKind::TRUE;
+        } else if (ctx->FALSE()) {
+            kind = AtomKind::FALSE;
+        } else if (ctx->test()) {
+            kind = AtomKind::PAREN;
+        } else {
+            kind = AtomKind::FORMAT;
+        }
+        uint32_t id = add(ctx, strings);
+        table.entries[id].kind = static_cast<uint8_t>(kind);
+        if (kind == AtomKind::NAME || kind == AtomKind::NUMBER) {
+            setText(id, text);
+        }
+        return visitChildren(ctx);
+    }
+
+    std::any visitFormat_string(Python3Parser::Format_stringContext *ctx) override {
+        std::vector<ParseTree*> parts;
+        for (auto child : ctx->children) {
+            if (auto terminal = dynamic_cast<TerminalNode*>(child)) {
+                std::string text = terminal->getText();
+                if (text == "f\"" || text == "f'" || text == "\"" || text == "'" ||
+                    text == "{" || text == "}") {
+                    continue;
+                }
+                addLiteral(terminal);
+            }
+            parts.push_back(child);
+        }
+        add(ctx, parts);
+        return visitChildren(ctx);
+    }
+
+private:
+    NodeTable& table;
+
+    template <typename T>
+    uint32_t add(ParseTree* node, const std::vector<T*>& kids, const std::vector<Op>& ops = {}) {
+        NodeEntry entry;
+        entry.firstChild = table.children.size();
+        entry.childCount = kids.size();
+        entry.firstOp = table.ops.size();
+        entry.opCount = ops.size();
+        table.children.insert(table.children.end(), kids.begin(), kids.end());
+        table.ops.insert(table.ops.end(), ops.begin(), ops.end());
+
+        uint32_t id = table.entries.size();
+        table.entries.push_back(entry);
+        table.index[node] = id;
+        return id;
+    }
+
+    // Lowers the tests of an assignment target once, so that execution
+    // stores by name without walking test -> or_test -> ... -> atom
+    void addTargets(Python3Parser::TestlistContext* testlist) {
+        NodeEntry& entry = table.entries[table.index.at(testlist)];
+        entry.firstTarget = table.targets.size();
+        for (auto test : testlist->test()) {
+            uint32_t name = UINT32_MAX;
+            if (auto atom = targetAtom(test)) {
+                name = table.entries[table.index.at(atom)].text;
+            }
+            table.targets.push_back(name);
+        }
+    }
+
+    // The NAME atom a test reduces to through single-child rules, if any
+    static Python3Parser::AtomContext* targetAtom(Python3Parser::TestContext* test) {
+        auto orTest = test->or_test();
+        if (orTest->and_test().size() != 1 || orTest->and_test(0)->not_test().size() != 1) {
+            return nullptr;
+        }
+        auto comparison = orTest->and_test(0)->not_test(0)->comparison();
+        if (!comparison || comparison->arith_expr().size() != 1) {
+            return nullptr;
+        }
+        auto arith = comparison->arith_expr(0);
+        if (arith->term().size() != 1 || arith->term(0)->factor().size() != 1) {
+            return nullptr;
+        }
+        auto atomExpr = arith->term(0)->factor(0)->atom_expr();
+        if (!atomExpr || !atomExpr->atom()->NAME()) {
+            return nullptr;
+        }
+        return atomExpr->atom();
+    }
+
+    void addLiteral(TerminalNode* token) {
+        uint32_t id = add(token, std::vector<ParseTree*>{});
+        setText(id, token->getText());
+    }
+
+    void setText(uint32_t id, const std::string& text) {
+        table.entries[id].text = table.texts.size();
+        table.texts.push_back(text);
+    }
+};
+
+void NodeTable::build(antlr4::tree::ParseTree* root) {
+    index.clear();
+    entries.clear();
+    children.clear();
+    ops.clear();
+    texts.clear();
+    targets.clear();
+
+    NodeTableBuilder builder(*this);
+    root->accept(&builder);
+}
@@ -0,0 +1,91 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_NODETABLE_H
+#define PYTHON_INTERPRETER_NODETABLE_H
+
+#include "Python3Parser.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Operator codes decoded once from operator tokens
+enum class Op : uint8_t {
+    NONE,
+    ADD, SUB, MUL, DIV, FLOORDIV, MOD,
+    LT, GT, LE, GE, EQ, NE,
+    NEG, POS
+};
+
+// What an atom holds, decoded once instead of comparing its text
+enum class AtomKind : uint8_t { NAME, NUMBER, STRING, NONE, TRUE, FALSE, PAREN, FORMAT };
+
+// Flattened view of one parse-tree node: ranges into NodeTable's flat
+// child and operator arrays, plus an optional text and a per-rule kind.
+struct NodeEntry {
+    uint32_t firstChild = 0;
+    uint32_t childCount = 0;
+    uint32_t firstOp = 0;
+    uint32_t opCount = 0;
+    uint32_t text = UINT32_MAX;
+    uint32_t firstTarget = 0;
+    uint8_t kind = 0;
+};
+
+// Side table built once after parsing. The ANTLR accessors allocate a new
+// std::vector per call and operator text has to be re-read with getText();
+// the evaluator reads children and operators from here instead.
+//
+// Layout per rule:
+//   file_input, suite      children = stmts (or the single simple_stmt)
+//   expr_stmt              children = testlists, ops = augassign operator
+//   if_stmt                children = test, suite, test, suite, ... [else suite]
+//   or_test, and_test      children = operands
+//   comparison             children = arith_exprs, ops = comparison operators
+//   arith_expr, term       children = operands, ops = binary operators
+//   factor                 children = operand, ops = unary operator (if any)
+//   trailer                children = arguments
+//   argument, testlist     children = tests; a testlist assigned to by an
+//                          expr_stmt also has one target per test
+//   atom                   kind = AtomKind, children = STRING tokens, text = NAME
+//   format_string          children = literal tokens and testlists in order
+//   literal token          text = token text
+class NodeTable {
+public:
+    void build(antlr4::tree::ParseTree* root);
+
+    const NodeEntry& at(antlr4::tree::ParseTree* node) const {
+        return entries[index.at(node)];
+    }
+
+    template <typename T>
+    T* child(const NodeEntry& entry, size_t i) const {
+        return static_cast<T*>(children[entry.firstChild + i]);
+    }
+
+    Op op(const NodeEntry& entry, size_t i) const {
+        return ops[entry.firstOp + i];
+    }
+
+    const std::string& text(const NodeEntry& entry) const {
+        return texts[entry.text];
+    }
+
+    // Variable assigned by test i of an assignment target testlist, or
+    // nullptr when that test is not a plain name
+    const std::string* target(const NodeEntry& entry, size_t i) const {
+        uint32_t name = targets[entry.firstTarget + i];
+        return name == UINT32_MAX ? nullptr : &texts[name];
+    }
+
+private:
+    friend class NodeTableBuilder;
+
+    std::unordered_map<antlr4::tree::ParseTree*, uint32_t> index;
+    std::vector<NodeEntry> entries;
+    std::vector<antlr4::tree::ParseTree*> children;
+    std::vector<Op> ops;
+    std::vector<std::string> texts;
+    std::vector<uint32_t> targets;
+};
+
+#endif//PYTHON_INTERPRETER_NODETABLE_H
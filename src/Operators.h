@@ -0,0 +1,34 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_OPERATORS_H
+#define PYTHON_INTERPRETER_OPERATORS_H
+
+#include "Ast.h"
+#include "Value.h"
+
+// Operator semantics shared by the execution engines that run the AST
+
+inline Value applyBinary(ast::BinaryOp op, const Value& lhs, const Value& rhs) {
+    switch (op) {
+        case ast::BinaryOp::ADD: return lhs + rhs;
+        case ast::BinaryOp::SUB: return lhs - rhs;
+        case ast::BinaryOp::MUL: return lhs * rhs;
+        case ast::BinaryOp::DIV: return lhs / rhs;
+        case ast::BinaryOp::FLOORDIV: return lhs.floordiv(rhs);
+        case ast::BinaryOp::MOD: return lhs % rhs;
+    }
+    return Value();
+}
+
+inline bool applyCompare(ast::CompareOp op, const Value& lhs, const Value& rhs) {
+    switch (op) {
+        case ast::CompareOp::LT: return lhs < rhs;
+        case ast::CompareOp::GT: return lhs > rhs;
+        case ast::CompareOp::LE: return lhs <= rhs;
+        case ast::CompareOp::GE: return lhs >= rhs;
+        case ast::CompareOp::EQ: return lhs == rhs;
+        case ast::CompareOp::NE: return lhs != rhs;
+    }
+    return false;
+}
+
+#endif//PYTHON_INTERPRETER_OPERATORS_H
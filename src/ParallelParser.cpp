@@ -0,0 +1,226 @@
+#include "ParallelParser.h"
+#include "DescentParser.h"
+#include "Python3Lexer.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <utility>
+
+using namespace ast;
+
+namespace {
+
+// Fewer tokens than this per chunk are not worth a thread
+constexpr size_t MIN_CHUNK_TOKENS = 16 * 1024;
+// Chunks per thread, so that threads that finish early can take more
+constexpr size_t CHUNKS_PER_THREAD = 4;
+
+struct Chunk {
+    Program program;
+    size_t syntaxErrors = 0;
+};
+
+// Whether a module-level statement starts at tokens[i]. A token at column 0
+// after a NEWLINE, or after the DEDENTs closing a block, starts one unless
+// it continues the if before it.
+bool startsStatement(const std::vector<PyToken>& tokens, size_t i) {
+    const PyToken& token = tokens[i];
+    size_t before = tokens[i - 1].type;
+    if (token.column != 0 || (before != Python3Lexer::NEWLINE && before != Python3Lexer::DEDENT)) return false;
+    switch (token.type) {
+        case Python3Lexer::ELIF:
+        case Python3Lexer::ELSE:
+        case Python3Lexer::NEWLINE:
+        case Python3Lexer::DEDENT:
+        case antlr4::Token::EOF:
+            return false;
+        default:
+            return true;
+    }
+}
+
+// Cuts tokens into chunks of at least chunkTokens tokens, the last one
+// ending after EOF
+std::vector<std::pair<size_t, size_t>> split(const std::vector<PyToken>& tokens, size_t chunkTokens) {
+    std::vector<std::pair<size_t, size_t>> ranges;
+    size_t begin = 0;
+    for (size_t i = chunkTokens; i < tokens.size(); i++) {
+        if (i - begin < chunkTokens || !startsStatement(tokens, i)) continue;
+        ranges.emplace_back(begin, i);
+        begin = i;
+    }
+    ranges.emplace_back(begin, tokens.size());
+    return ranges;
+}
+
+// Moves the symbols and constants of a chunk's nodes to where they are in
+// the whole program
+class Renumberer {
+public:
+    Renumberer(const std::vector<Symbol>& symbols, uint32_t firstConstant)
+        : symbols(symbols), firstConstant(firstConstant) {}
+
+    void block(Span<Stmt*> body) {
+        for (Stmt* stmt : body) statement(stmt);
+    }
+
+private:
+    const std::vector<Symbol>& symbols;// by the chunk's symbol
+    uint32_t firstConstant;
+
+    void symbol(Symbol& name) {
+        if (name != NO_SYMBOL) name = symbols[name];
+    }
+
+    void constant(uint32_t& index) {
+        if (index != NO_CONSTANT) index += firstConstant;
+    }
+
+    void statement(Stmt* stmt) {
+        switch (stmt->kind) {
+            case StmtKind::EXPR:
+                expr(static_cast<ExprStmt*>(stmt)->value);
+                break;
+            case StmtKind::ASSIGN: {
+                auto assign = static_cast<Assign*>(stmt);
+                for (Span<Target> targets : assign->targets) {
+                    for (Target& target : targets) symbol(target.name);
+                }
+                exprs(assign->values);
+                break;
+            }
+            case StmtKind::AUG_ASSIGN: {
+                auto assign = static_cast<AugAssign*>(stmt);
+                symbol(assign->target.name);
+                expr(assign->value);
+                break;
+            }
+            case StmtKind::IF: {
+                auto ifStmt = static_cast<If*>(stmt);
+                for (IfBranch& branch : ifStmt->branches) {
+                    expr(branch.condition);
+                    block(branch.body);
+                }
+                block(ifStmt->orelse);
+                break;
+            }
+            case StmtKind::WHILE: {
+                auto loop = static_cast<While*>(stmt);
+                expr(loop->condition);
+                block(loop->body);
+                break;
+            }
+            case StmtKind::FUNCDEF: {
+                auto def = static_cast<FuncDef*>(stmt);
+                symbol(def->name);
+                for (Symbol& param : def->params) symbol(param);
+                exprs(def->defaults);
+                block(def->body);
+                break;
+            }
+            case StmtKind::RETURN: {
+                auto ret = static_cast<Return*>(stmt);
+                if (ret->value) expr(ret->value);
+                break;
+            }
+            case StmtKind::BREAK:
+            case StmtKind::CONTINUE:
+                break;
+        }
+    }
+
+    void exprs(Span<Expr*> list) {
+        for (Expr* value : list) expr(value);
+    }
+
+    void expr(Expr* e) {
+        switch (e->kind) {
+            case ExprKind::CONSTANT:
+                constant(static_cast<Constant*>(e)->index);
+                break;
+            case ExprKind::NAME:
+                symbol(static_cast<Name*>(e)->name);
+                break;
+            case ExprKind::UNARY:
+                expr(static_cast<Unary*>(e)->operand);
+                break;
+            case ExprKind::BINARY: {
+                auto binary = static_cast<Binary*>(e);
+                expr(binary->lhs);
+                expr(binary->rhs);
+                break;
+            }
+            case ExprKind::COMPARE:
+                exprs(static_cast<Compare*>(e)->operands);
+                break;
+            case ExprKind::BOOL_OP:
+                exprs(static_cast<BoolOp*>(e)->operands);
+                break;
+            case ExprKind::CALL: {
+                auto call = static_cast<Call*>(e);
+                symbol(call->callee);
+                for (Argument& arg : call->args) {
+                    symbol(arg.keyword);
+                    expr(arg.value);
+                }
+                break;
+            }
+            case ExprKind::FORMAT:
+                for (FormatPart& part : static_cast<FormatString*>(e)->parts) {
+                    constant(part.literal);
+                    exprs(part.values);
+                }
+                break;
+        }
+    }
+};
+
+}// namespace
+
+size_t parseParallel(const std::vector<PyToken>& tokens, Program& program, unsigned threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    if (threads == 1) return 0;
+    size_t chunkTokens = std::max(MIN_CHUNK_TOKENS, tokens.size() / (threads * CHUNKS_PER_THREAD));
+    std::vector<std::pair<size_t, size_t>> ranges = split(tokens, chunkTokens);
+    if (ranges.size() < 2) return 0;
+
+    std::vector<Chunk> chunks(ranges.size());
+    std::atomic<size_t> next{0};
+    auto work = [&] {
+        for (size_t i; (i = next++) < chunks.size();) {
+            Chunk& chunk = chunks[i];
+            DescentParser parser(tokens, chunk.program);
+            parser.silenceErrors();
+            parser.parseRange(ranges[i].first, ranges[i].second);
+            chunk.syntaxErrors = parser.syntaxErrors();
+        }
+    };
+    std::vector<std::thread> pool;
+    for (size_t i = 1; i < std::min<size_t>(threads, chunks.size()); i++) pool.emplace_back(work);
+    work();
+    for (std::thread& thread : pool) thread.join();
+
+    for (const Chunk& chunk : chunks) {
+        if (chunk.syntaxErrors != 0) return 0;
+    }
+
+    // Interning each chunk's symbols in its own order, chunk after chunk,
+    // numbers them by first use as a single parse would
+    std::vector<Stmt*> body;
+    std::vector<Symbol> symbols;
+    size_t constants = program.constants.size();
+    for (const Chunk& chunk : chunks) constants += chunk.program.constants.size();
+    program.constants.reserve(constants);
+    for (Chunk& chunk : chunks) {
+        symbols.resize(chunk.program.symbols.size());
+        for (Symbol symbol = 0; symbol < symbols.size(); symbol++) {
+            symbols[symbol] = program.symbols.intern(chunk.program.symbols.name(symbol));
+        }
+        Renumberer(symbols, program.constants.size()).block(chunk.program.body);
+        for (Value& constant : chunk.program.constants) program.constants.push_back(std::move(constant));
+        body.insert(body.end(), chunk.program.body.begin(), chunk.program.body.end());
+        program.arena.absorb(std::move(chunk.program.arena));
+    }
+    program.body = copyToArena(program.arena, body);
+    return chunks.size();
+}
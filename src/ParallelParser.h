@@ -0,0 +1,22 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_PARALLELPARSER_H
+#define PYTHON_INTERPRETER_PARALLELPARSER_H
+
+#include "Ast.h"
+#include "Tokenizer.h"
+#include <vector>
+
+// Parses tokens into program like DescentParser::parse(), but on several
+// threads. Module-level statements are independent units, so the tokens
+// are cut before statements at column 0 into a few chunks per thread, and
+// each chunk is parsed into a Program of its own. The chunks' symbols and
+// constants are then renumbered into program in source order, which gives
+// the same numbering a single parser would.
+//
+// Returns the number of chunks, or 0 with program untouched if the input
+// is too small to be worth splitting or a chunk has a syntax error. The
+// caller then parses sequentially, which also reports the errors in order.
+// threads is the most threads to use, 0 for one per core.
+size_t parseParallel(const std::vector<PyToken>& tokens, ast::Program& program, unsigned threads);
+
+#endif//PYTHON_INTERPRETER_PARALLELPARSER_H
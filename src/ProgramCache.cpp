@@ -0,0 +1,537 @@
+#include "ProgramCache.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+
+using namespace ast;
+
+// Builds that do not hash the sources get a version of their own
+#ifndef PYINTERP_PROGRAM_CACHE_VERSION
+#define PYINTERP_PROGRAM_CACHE_VERSION __DATE__ " " __TIME__
+#endif
+
+const char* const ProgramCache::CACHE_VERSION = "pyinterp-ast-" PYINTERP_PROGRAM_CACHE_VERSION;
+
+namespace {
+
+constexpr char MAGIC[] = "PYAC";
+constexpr size_t MAGIC_SIZE = sizeof(MAGIC) - 1;
+
+// 64-bit FNV-1a
+uint64_t hashBytes(const char* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+uint64_t sourceHash(const std::string& source) {
+    uint64_t hash = hashBytes(ProgramCache::CACHE_VERSION, std::strlen(ProgramCache::CACHE_VERSION));
+    return hashBytes(source.data(), source.size(), hash);
+}
+
+// Little-endian encoding of a program; spans are a count followed by the
+// items, nodes their kind followed by their fields
+class Writer {
+public:
+    std::string bytes;
+
+    void u8(uint8_t value) { bytes += static_cast<char>(value); }
+
+    void u32(uint32_t value) {
+        for (int i = 0; i < 4; i++) u8(static_cast<uint8_t>(value >> (8 * i)));
+    }
+
+    void u64(uint64_t value) {
+        for (int i = 0; i < 8; i++) u8(static_cast<uint8_t>(value >> (8 * i)));
+    }
+
+    void text(const std::string& value) {
+        u32(value.size());
+        bytes += value;
+    }
+
+    void program(const Program& program) {
+        u32(program.symbols.size());
+        for (size_t i = 0; i < program.symbols.size(); i++) text(program.symbols.name(i));
+        u32(program.constants.size());
+        for (const Value& constant : program.constants) value(constant);
+        block(program.body);
+    }
+
+private:
+    void value(const Value& value) {
+        u8(static_cast<uint8_t>(value.type));
+        switch (value.type) {
+            case ValueType::NONE:
+                break;
+            case ValueType::BOOL:
+                u8(value.boolVal);
+                break;
+            case ValueType::INT:
+                text(value.intVal.toString());
+                break;
+            case ValueType::FLOAT: {
+                uint64_t bits;
+                std::memcpy(&bits, &value.floatVal, sizeof(bits));
+                u64(bits);
+                break;
+            }
+            case ValueType::STRING:
+                text(value.stringVal);
+                break;
+        }
+    }
+
+    void target(const Target& target) {
+        u32(target.name);
+        u32(static_cast<uint32_t>(target.slot));
+    }
+
+    void exprs(Span<Expr*> items) {
+        u32(items.size);
+        for (const Expr* item : items) expr(item);
+    }
+
+    void expr(const Expr* expr) {
+        u8(static_cast<uint8_t>(expr->kind));
+        u8(static_cast<uint8_t>(expr->type));
+        switch (expr->kind) {
+            case ExprKind::CONSTANT:
+                u32(static_cast<const Constant*>(expr)->index);
+                break;
+            case ExprKind::NAME: {
+                auto name = static_cast<const Name*>(expr);
+                u32(name->name);
+                u32(static_cast<uint32_t>(name->slot));
+                break;
+            }
+            case ExprKind::UNARY: {
+                auto unary = static_cast<const Unary*>(expr);
+                u8(static_cast<uint8_t>(unary->op));
+                this->expr(unary->operand);
+                break;
+            }
+            case ExprKind::BINARY: {
+                auto binary = static_cast<const Binary*>(expr);
+                u8(static_cast<uint8_t>(binary->op));
+                this->expr(binary->lhs);
+                this->expr(binary->rhs);
+                break;
+            }
+            case ExprKind::COMPARE: {
+                auto compare = static_cast<const Compare*>(expr);
+                exprs(compare->operands);
+                u32(compare->ops.size);
+                for (CompareOp op : compare->ops) u8(static_cast<uint8_t>(op));
+                break;
+            }
+            case ExprKind::BOOL_OP: {
+                auto boolOp = static_cast<const BoolOp*>(expr);
+                u8(static_cast<uint8_t>(boolOp->op));
+                exprs(boolOp->operands);
+                break;
+            }
+            case ExprKind::CALL: {
+                auto call = static_cast<const Call*>(expr);
+                u32(call->callee);
+                u8(static_cast<uint8_t>(call->builtin));
+                u32(call->args.size);
+                for (const Argument& arg : call->args) {
+                    u32(arg.keyword);
+                    this->expr(arg.value);
+                }
+                break;
+            }
+            case ExprKind::FORMAT: {
+                auto format = static_cast<const FormatString*>(expr);
+                u32(format->parts.size);
+                for (const FormatPart& part : format->parts) {
+                    u32(part.literal);
+                    exprs(part.values);
+                }
+                break;
+            }
+        }
+    }
+
+    void block(Span<Stmt*> body) {
+        u32(body.size);
+        for (const Stmt* item : body) stmt(item);
+    }
+
+    void stmt(const Stmt* stmt) {
+        u8(static_cast<uint8_t>(stmt->kind));
+        switch (stmt->kind) {
+            case StmtKind::EXPR:
+                expr(static_cast<const ExprStmt*>(stmt)->value);
+                break;
+            case StmtKind::ASSIGN: {
+                auto assign = static_cast<const Assign*>(stmt);
+                u32(assign->targets.size);
+                for (const Span<Target>& targets : assign->targets) {
+                    u32(targets.size);
+                    for (const Target& item : targets) target(item);
+                }
+                exprs(assign->values);
+                break;
+            }
+            case StmtKind::AUG_ASSIGN: {
+                auto assign = static_cast<const AugAssign*>(stmt);
+                u8(static_cast<uint8_t>(assign->op));
+                target(assign->target);
+                expr(assign->value);
+                break;
+            }
+            case StmtKind::IF: {
+                auto ifStmt = static_cast<const If*>(stmt);
+                u32(ifStmt->branches.size);
+                for (const IfBranch& branch : ifStmt->branches) {
+                    expr(branch.condition);
+                    block(branch.body);
+                }
+                block(ifStmt->orelse);
+                break;
+            }
+            case StmtKind::WHILE: {
+                auto loop = static_cast<const While*>(stmt);
+                expr(loop->condition);
+                block(loop->body);
+                break;
+            }
+            case StmtKind::FUNCDEF: {
+                auto def = static_cast<const FuncDef*>(stmt);
+                u32(def->name);
+                u32(def->params.size);
+                for (Symbol param : def->params) u32(param);
+                exprs(def->defaults);
+                block(def->body);
+                u32(def->localCount);
+                u32(def->localTypes.size);
+                for (StaticType type : def->localTypes) u8(static_cast<uint8_t>(type));
+                break;
+            }
+            case StmtKind::RETURN: {
+                auto ret = static_cast<const Return*>(stmt);
+                u8(ret->value != nullptr);
+                if (ret->value) expr(ret->value);
+                u8(ret->selfCall);
+                break;
+            }
+            case StmtKind::BREAK:
+            case StmtKind::CONTINUE:
+                break;
+        }
+    }
+};
+
+// Decodes what Writer encoded, throwing std::runtime_error on input that
+// ends early
+class Reader {
+public:
+    Reader(const std::string& bytes, size_t begin, size_t end) : bytes(bytes), pos(begin), end(end) {}
+
+    bool atEnd() const { return pos == end; }
+
+    uint8_t u8() {
+        if (pos >= end) throw std::runtime_error("truncated cache entry");
+        return static_cast<uint8_t>(bytes[pos++]);
+    }
+
+    uint32_t u32() {
+        uint32_t value = 0;
+        for (int i = 0; i < 4; i++) value |= static_cast<uint32_t>(u8()) << (8 * i);
+        return value;
+    }
+
+    uint64_t u64() {
+        uint64_t value = 0;
+        for (int i = 0; i < 8; i++) value |= static_cast<uint64_t>(u8()) << (8 * i);
+        return value;
+    }
+
+    // Every item takes at least a byte, which bounds what a count may
+    // make us allocate
+    uint32_t count() {
+        uint32_t value = u32();
+        if (value > end - pos) throw std::runtime_error("truncated cache entry");
+        return value;
+    }
+
+    std::string text() {
+        uint32_t size = count();
+        std::string value = bytes.substr(pos, size);
+        pos += size;
+        return value;
+    }
+
+    void program(Program& program) {
+        this->target = &program;
+        for (uint32_t i = 0, n = count(); i < n; i++) program.symbols.intern(text());
+        for (uint32_t i = 0, n = count(); i < n; i++) program.constants.push_back(value());
+        program.body = block();
+    }
+
+private:
+    const std::string& bytes;
+    size_t pos;
+    size_t end;
+    Program* target = nullptr;
+
+    template <typename T>
+    Span<T> span(std::vector<T>& items) {
+        return copyToArena(target->arena, items);
+    }
+
+    Value value() {
+        switch (static_cast<ValueType>(u8())) {
+            case ValueType::NONE:
+                return Value();
+            case ValueType::BOOL:
+                return Value(u8() != 0);
+            case ValueType::INT:
+                return Value(BigInt(text()));
+            case ValueType::FLOAT: {
+                uint64_t bits = u64();
+                double value;
+                std::memcpy(&value, &bits, sizeof(value));
+                return Value(value);
+            }
+            case ValueType::STRING:
+                return Value(text());
+        }
+        throw std::runtime_error("bad value in cache entry");
+    }
+
+    Target targetOf() {
+        Target target;
+        target.name = u32();
+        target.slot = static_cast<int32_t>(u32());
+        return target;
+    }
+
+    Span<Expr*> exprs() {
+        std::vector<Expr*> items(count());
+        for (Expr*& item : items) item = expr();
+        return span(items);
+    }
+
+    Expr* expr() {
+        auto kind = static_cast<ExprKind>(u8());
+        auto type = static_cast<StaticType>(u8());
+        Expr* result = nullptr;
+        switch (kind) {
+            case ExprKind::CONSTANT: {
+                auto constant = target->make<Constant>();
+                constant->index = u32();
+                result = constant;
+                break;
+            }
+            case ExprKind::NAME: {
+                auto name = target->make<Name>();
+                name->name = u32();
+                name->slot = static_cast<int32_t>(u32());
+                result = name;
+                break;
+            }
+            case ExprKind::UNARY: {
+                auto unary = target->make<Unary>();
+                unary->op = static_cast<UnaryOp>(u8());
+                unary->operand = expr();
+                result = unary;
+                break;
+            }
+            case ExprKind::BINARY: {
+                auto binary = target->make<Binary>();
+                binary->op = static_cast<BinaryOp>(u8());
+                binary->lhs = expr();
+                binary->rhs = expr();
+                result = binary;
+                break;
+            }
+            case ExprKind::COMPARE: {
+                auto compare = target->make<Compare>();
+                compare->operands = exprs();
+                std::vector<CompareOp> ops(count());
+                for (CompareOp& op : ops) op = static_cast<CompareOp>(u8());
+                compare->ops = span(ops);
+                result = compare;
+                break;
+            }
+            case ExprKind::BOOL_OP: {
+                auto boolOp = target->make<BoolOp>();
+                boolOp->op = static_cast<LogicOp>(u8());
+                boolOp->operands = exprs();
+                result = boolOp;
+                break;
+            }
+            case ExprKind::CALL: {
+                auto call = target->make<Call>();
+                call->callee = u32();
+                call->builtin = static_cast<Builtin>(u8());
+                std::vector<Argument> args(count());
+                for (Argument& arg : args) {
+                    arg.keyword = u32();
+                    arg.value = expr();
+                }
+                call->args = span(args);
+                result = call;
+                break;
+            }
+            case ExprKind::FORMAT: {
+                auto format = target->make<FormatString>();
+                std::vector<FormatPart> parts(count());
+                for (FormatPart& part : parts) {
+                    part.literal = u32();
+                    part.values = exprs();
+                }
+                format->parts = span(parts);
+                result = format;
+                break;
+            }
+            default:
+                throw std::runtime_error("bad expression in cache entry");
+        }
+        result->type = type;
+        return result;
+    }
+
+    Span<Stmt*> block() {
+        std::vector<Stmt*> items(count());
+        for (Stmt*& item : items) item = stmt();
+        return span(items);
+    }
+
+    Stmt* stmt() {
+        switch (static_cast<StmtKind>(u8())) {
+            case StmtKind::EXPR: {
+                auto stmt = target->make<ExprStmt>();
+                stmt->value = expr();
+                return stmt;
+            }
+            case StmtKind::ASSIGN: {
+                auto assign = target->make<Assign>();
+                std::vector<Span<Target>> targets(count());
+                for (Span<Target>& list : targets) {
+                    std::vector<Target> items(count());
+                    for (Target& item : items) item = targetOf();
+                    list = span(items);
+                }
+                assign->targets = span(targets);
+                assign->values = exprs();
+                return assign;
+            }
+            case StmtKind::AUG_ASSIGN: {
+                auto assign = target->make<AugAssign>();
+                assign->op = static_cast<BinaryOp>(u8());
+                assign->target = targetOf();
+                assign->value = expr();
+                return assign;
+            }
+            case StmtKind::IF: {
+                auto ifStmt = target->make<If>();
+                std::vector<IfBranch> branches(count());
+                for (IfBranch& branch : branches) {
+                    branch.condition = expr();
+                    branch.body = block();
+                }
+                ifStmt->branches = span(branches);
+                ifStmt->orelse = block();
+                return ifStmt;
+            }
+            case StmtKind::WHILE: {
+                auto loop = target->make<While>();
+                loop->condition = expr();
+                loop->body = block();
+                return loop;
+            }
+            case StmtKind::FUNCDEF: {
+                auto def = target->make<FuncDef>();
+                def->name = u32();
+                std::vector<Symbol> params(count());
+                for (Symbol& param : params) param = u32();
+                def->params = span(params);
+                def->defaults = exprs();
+                def->body = block();
+                def->localCount = u32();
+                std::vector<StaticType> types(count());
+                for (StaticType& type : types) type = static_cast<StaticType>(u8());
+                def->localTypes = span(types);
+                return def;
+            }
+            case StmtKind::RETURN: {
+                auto ret = target->make<Return>();
+                ret->value = u8() ? expr() : nullptr;
+                ret->selfCall = u8() != 0;
+                return ret;
+            }
+            case StmtKind::BREAK:
+                return target->make<Break>();
+            case StmtKind::CONTINUE:
+                return target->make<Continue>();
+        }
+        throw std::runtime_error("bad statement in cache entry");
+    }
+};
+
+}// namespace
+
+ProgramCache::ProgramCache(std::string directory) : directory(std::move(directory)) {}
+
+std::string ProgramCache::pathOf(uint64_t hash) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.ast", static_cast<unsigned long long>(hash));
+    return directory + "/" + name;
+}
+
+// Layout: magic, version, source hash and length, the encoded program,
+// then the hash of everything before it
+std::unique_ptr<Program> ProgramCache::load(const std::string& source) const {
+    uint64_t hash = sourceHash(source);
+    std::ifstream file(pathOf(hash), std::ios::binary);
+    if (!file) return nullptr;
+    std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (bytes.size() < MAGIC_SIZE + 8) return nullptr;
+    size_t checked = bytes.size() - 8;
+    Reader trailer(bytes, checked, bytes.size());
+    if (trailer.u64() != hashBytes(bytes.data(), checked)) return nullptr;
+
+    try {
+        Reader reader(bytes, 0, checked);
+        for (size_t i = 0; i < MAGIC_SIZE; i++) {
+            if (reader.u8() != static_cast<uint8_t>(MAGIC[i])) return nullptr;
+        }
+        if (reader.text() != CACHE_VERSION || reader.u64() != hash || reader.u64() != source.size()) return nullptr;
+        auto program = std::make_unique<Program>();
+        reader.program(*program);
+        if (!reader.atEnd()) return nullptr;
+        return program;
+    } catch (const std::runtime_error&) {
+        return nullptr;
+    }
+}
+
+void ProgramCache::store(const std::string& source, const Program& program) const {
+    uint64_t hash = sourceHash(source);
+    Writer writer;
+    writer.bytes.append(MAGIC, MAGIC_SIZE);
+    writer.text(CACHE_VERSION);
+    writer.u64(hash);
+    writer.u64(source.size());
+    writer.program(program);
+    writer.u64(hashBytes(writer.bytes.data(), writer.bytes.size()));
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    std::string path = pathOf(hash);
+    std::string temporary = path + ".tmp" + std::to_string(std::random_device()());
+    std::ofstream file(temporary, std::ios::binary);
+    file.write(writer.bytes.data(), writer.bytes.size());
+    file.close();
+    if (!file || std::rename(temporary.c_str(), path.c_str()) != 0) std::remove(temporary.c_str());
+}
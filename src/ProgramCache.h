@@ -0,0 +1,36 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_PROGRAMCACHE_H
+#define PYTHON_INTERPRETER_PROGRAMCACHE_H
+
+#include "Ast.h"
+#include <memory>
+#include <string>
+
+// Directory of programs the front end has already parsed and analysed,
+// serialized together with their symbols and constant pool. Entries are
+// named after a hash of the source text and CACHE_VERSION, and carry the
+// full hash, the source length and a checksum of their contents; an entry
+// that does not match in every respect is ignored.
+class ProgramCache {
+public:
+    // Identifies the layout of the AST and the passes that produced it.
+    // The build derives it from a hash of their sources, so that entries
+    // stop matching as soon as any of them changes.
+    static const char* const CACHE_VERSION;
+
+    explicit ProgramCache(std::string directory);
+
+    // The program cached for source, or nullptr
+    std::unique_ptr<ast::Program> load(const std::string& source) const;
+
+    // Best effort: the entry is written to a temporary file and renamed
+    // into place, and any failure just leaves the cache without it
+    void store(const std::string& source, const ast::Program& program) const;
+
+private:
+    std::string directory;
+
+    std::string pathOf(uint64_t hash) const;
+};
+
+#endif//PYTHON_INTERPRETER_PROGRAMCACHE_H
@@ -0,0 +1,235 @@
+#include "Resolver.h"
+#include <unordered_map>
+
+using namespace ast;
+
+namespace {
+
+class ScopeResolver {
+public:
+    void resolveModule(Span<Stmt*> body) {
+        resolveBlock(body);
+    }
+
+    void resolveFunction(FuncDef* def) {
+        function = def->name;
+        for (Symbol param : def->params) {
+            slots.emplace(param, slots.size());
+        }
+        collectBlock(def->body);
+        def->localCount = slots.size();
+        resolveBlock(def->body);
+    }
+
+private:
+    std::unordered_map<Symbol, int32_t> slots;
+    Symbol function = NO_SYMBOL;// being resolved, NO_SYMBOL at module level
+
+    int32_t slotOf(Symbol name) const {
+        auto it = slots.find(name);
+        return it == slots.end() ? NO_SLOT : it->second;
+    }
+
+    void collectTarget(const Target& target) {
+        if (target.name != NO_SYMBOL) {
+            slots.emplace(target.name, slots.size());
+        }
+    }
+
+    // Gives every name assigned in the block a slot. Nested function bodies
+    // are separate scopes and are skipped.
+    void collectBlock(Span<Stmt*> body) {
+        for (Stmt* stmt : body) {
+            switch (stmt->kind) {
+                case StmtKind::ASSIGN:
+                    for (auto& targets : static_cast<Assign*>(stmt)->targets) {
+                        for (auto& target : targets) collectTarget(target);
+                    }
+                    break;
+                case StmtKind::AUG_ASSIGN:
+                    collectTarget(static_cast<AugAssign*>(stmt)->target);
+                    break;
+                case StmtKind::IF: {
+                    auto ifStmt = static_cast<If*>(stmt);
+                    for (auto& branch : ifStmt->branches) collectBlock(branch.body);
+                    collectBlock(ifStmt->orelse);
+                    break;
+                }
+                case StmtKind::WHILE:
+                    collectBlock(static_cast<While*>(stmt)->body);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    void resolveBlock(Span<Stmt*> body) {
+        for (Stmt* stmt : body) resolveStmt(stmt);
+    }
+
+    void resolveStmt(Stmt* stmt) {
+        switch (stmt->kind) {
+            case StmtKind::EXPR:
+                resolveExpr(static_cast<ExprStmt*>(stmt)->value);
+                break;
+            case StmtKind::ASSIGN: {
+                auto assign = static_cast<Assign*>(stmt);
+                for (Expr* value : assign->values) resolveExpr(value);
+                for (auto& targets : assign->targets) {
+                    for (auto& target : targets) target.slot = slotOf(target.name);
+                }
+                break;
+            }
+            case StmtKind::AUG_ASSIGN: {
+                auto assign = static_cast<AugAssign*>(stmt);
+                resolveExpr(assign->value);
+                assign->target.slot = slotOf(assign->target.name);
+                break;
+            }
+            case StmtKind::IF: {
+                auto ifStmt = static_cast<If*>(stmt);
+                for (auto& branch : ifStmt->branches) {
+                    resolveExpr(branch.condition);
+                    resolveBlock(branch.body);
+                }
+                resolveBlock(ifStmt->orelse);
+                break;
+            }
+            case StmtKind::WHILE: {
+                auto whileStmt = static_cast<While*>(stmt);
+                resolveExpr(whileStmt->condition);
+                resolveBlock(whileStmt->body);
+                break;
+            }
+            case StmtKind::FUNCDEF: {
+                // Defaults are evaluated by the enclosing scope at def time
+                auto def = static_cast<FuncDef*>(stmt);
+                for (Expr* value : def->defaults) resolveExpr(value);
+                ScopeResolver().resolveFunction(def);
+                break;
+            }
+            case StmtKind::RETURN: {
+                auto ret = static_cast<Return*>(stmt);
+                if (!ret->value) break;
+                resolveExpr(ret->value);
+                if (ret->value->kind == ExprKind::CALL && function != NO_SYMBOL) {
+                    auto call = static_cast<const Call*>(ret->value);
+                    ret->selfCall = call->builtin == Builtin::NONE && call->callee == function;
+                }
+                break;
+            }
+            case StmtKind::BREAK:
+            case StmtKind::CONTINUE:
+                break;
+        }
+    }
+
+    void resolveExpr(Expr* expr) {
+        switch (expr->kind) {
+            case ExprKind::CONSTANT:
+                break;
+            case ExprKind::NAME: {
+                auto name = static_cast<Name*>(expr);
+                name->slot = slotOf(name->name);
+                break;
+            }
+            case ExprKind::UNARY:
+                resolveExpr(static_cast<Unary*>(expr)->operand);
+                break;
+            case ExprKind::BINARY:
+                resolveExpr(static_cast<Binary*>(expr)->lhs);
+                resolveExpr(static_cast<Binary*>(expr)->rhs);
+                break;
+            case ExprKind::COMPARE:
+                for (Expr* operand : static_cast<Compare*>(expr)->operands) resolveExpr(operand);
+                break;
+            case ExprKind::BOOL_OP:
+                for (Expr* operand : static_cast<BoolOp*>(expr)->operands) resolveExpr(operand);
+                break;
+            case ExprKind::CALL:
+                for (auto& arg : static_cast<Call*>(expr)->args) resolveExpr(arg.value);
+                break;
+            case ExprKind::FORMAT:
+                for (auto& part : static_cast<FormatString*>(expr)->parts) {
+                    for (Expr* value : part.values) resolveExpr(value);
+                }
+                break;
+        }
+    }
+};
+
+void collectAssigned(Span<Stmt*> body, std::vector<char>& assigned) {
+    for (const Stmt* stmt : body) {
+        switch (stmt->kind) {
+            case StmtKind::ASSIGN:
+                for (const Span<Target>& targets : static_cast<const Assign*>(stmt)->targets) {
+                    for (const Target& target : targets) {
+                        if (target.name != NO_SYMBOL) assigned[target.name] = true;
+                    }
+                }
+                break;
+            case StmtKind::AUG_ASSIGN:
+                assigned[static_cast<const AugAssign*>(stmt)->target.name] = true;
+                break;
+            case StmtKind::IF: {
+                auto ifStmt = static_cast<const If*>(stmt);
+                for (const IfBranch& branch : ifStmt->branches) collectAssigned(branch.body, assigned);
+                collectAssigned(ifStmt->orelse, assigned);
+                break;
+            }
+            case StmtKind::WHILE:
+                collectAssigned(static_cast<const While*>(stmt)->body, assigned);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// Counts the defs of every name, nested ones included
+void countDefs(Span<Stmt*> body, std::vector<uint32_t>& defs) {
+    for (const Stmt* stmt : body) {
+        switch (stmt->kind) {
+            case StmtKind::IF: {
+                auto ifStmt = static_cast<const If*>(stmt);
+                for (const IfBranch& branch : ifStmt->branches) countDefs(branch.body, defs);
+                countDefs(ifStmt->orelse, defs);
+                break;
+            }
+            case StmtKind::WHILE:
+                countDefs(static_cast<const While*>(stmt)->body, defs);
+                break;
+            case StmtKind::FUNCDEF: {
+                auto def = static_cast<const FuncDef*>(stmt);
+                defs[def->name]++;
+                countDefs(def->body, defs);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+}// namespace
+
+void resolveScopes(Program& program) {
+    ScopeResolver().resolveModule(program.body);
+}
+
+void resolveFunction(FuncDef* def) {
+    ScopeResolver().resolveFunction(def);
+}
+
+std::vector<char> moduleAssignedNames(const Program& program) {
+    std::vector<char> assigned(program.symbols.size(), false);
+    collectAssigned(program.body, assigned);
+    return assigned;
+}
+
+std::vector<uint32_t> definitionCounts(const Program& program) {
+    std::vector<uint32_t> defs(program.symbols.size(), 0);
+    countDefs(program.body, defs);
+    return defs;
+}
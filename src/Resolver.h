@@ -0,0 +1,32 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_RESOLVER_H
+#define PYTHON_INTERPRETER_RESOLVER_H
+
+#include "Ast.h"
+#include <vector>
+
+// Assigns local slots to the names used inside each function.
+//
+// Only function calls create scopes. Inside a function, parameters and every
+// name the body assigns to get a slot; all other names refer to globals.
+// Whether an assignment to a slotted name really creates a local is decided
+// at run time: it updates an existing global of the same name instead,
+// unless the name is a parameter or the local is already bound.
+//
+// Also marks the returns that call their own function by name, which the
+// engines may run as tail calls.
+void resolveScopes(ast::Program& program);
+
+// Resolves the body of one def again, after it was parsed late
+void resolveFunction(ast::FuncDef* def);
+
+// Flags, by symbol, the names assigned by module-level code. Only these can
+// ever be bound as globals, so a local of any other name never falls back
+// to a global and can be kept in a plain slot.
+std::vector<char> moduleAssignedNames(const ast::Program& program);
+
+// Counts, by symbol, the defs of every name, nested ones included. A name
+// with a single def at module level always calls the same code once bound.
+std::vector<uint32_t> definitionCounts(const ast::Program& program);
+
+#endif//PYTHON_INTERPRETER_RESOLVER_H
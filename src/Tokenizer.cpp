@@ -0,0 +1,771 @@
+#include "Tokenizer.h"
+#include "Python3Lexer.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace {
+
+constexpr size_t TOKEN_EOF = antlr4::Token::EOF;
+
+enum CharClass : uint8_t {
+    OTHER,
+    LETTER,// ASCII letters and the underscore
+    DIGIT,
+    SPACE,   // space and tab
+    LINE_END,// \r, \n and \f
+    QUOTE,
+    HASH,
+    BACKSLASH,
+    DOT,
+    NON_ASCII,// any byte of a multi-byte UTF-8 sequence
+};
+
+constexpr std::array<uint8_t, 256> makeCharClasses() {
+    std::array<uint8_t, 256> classes{};
+    for (int c = 'a'; c <= 'z'; c++) classes[c] = LETTER;
+    for (int c = 'A'; c <= 'Z'; c++) classes[c] = LETTER;
+    for (int c = '0'; c <= '9'; c++) classes[c] = DIGIT;
+    for (int c = 0x80; c < 0x100; c++) classes[c] = NON_ASCII;
+    classes['_'] = LETTER;
+    classes[' '] = SPACE;
+    classes['\t'] = SPACE;
+    classes['\r'] = LINE_END;
+    classes['\n'] = LINE_END;
+    classes['\f'] = LINE_END;
+    classes['\''] = QUOTE;
+    classes['"'] = QUOTE;
+    classes['#'] = HASH;
+    classes['\\'] = BACKSLASH;
+    classes['.'] = DOT;
+    return classes;
+}
+
+constexpr std::array<uint8_t, 256> CHAR_CLASSES = makeCharClasses();
+
+struct Literal {
+    const char* text;
+    size_t type;
+};
+
+// Grouped by first character, longest first within a group, so the first
+// one that matches is the longest
+constexpr Literal OPERATORS[] = {
+    {"!=", Python3Lexer::NOT_EQ_2},
+    {"%=", Python3Lexer::MOD_ASSIGN},
+    {"%", Python3Lexer::MOD},
+    {"&=", Python3Lexer::AND_ASSIGN},
+    {"&", Python3Lexer::AND_OP},
+    {"(", Python3Lexer::OPEN_PAREN},
+    {")", Python3Lexer::CLOSE_PAREN},
+    {"**=", Python3Lexer::POWER_ASSIGN},
+    {"**", Python3Lexer::POWER},
+    {"*=", Python3Lexer::MULT_ASSIGN},
+    {"*", Python3Lexer::STAR},
+    {"+=", Python3Lexer::ADD_ASSIGN},
+    {"+", Python3Lexer::ADD},
+    {",", Python3Lexer::COMMA},
+    {"-=", Python3Lexer::SUB_ASSIGN},
+    {"->", Python3Lexer::ARROW},
+    {"-", Python3Lexer::MINUS},
+    {"...", Python3Lexer::ELLIPSIS},
+    {".", Python3Lexer::DOT},
+    {"//=", Python3Lexer::IDIV_ASSIGN},
+    {"//", Python3Lexer::IDIV},
+    {"/=", Python3Lexer::DIV_ASSIGN},
+    {"/", Python3Lexer::DIV},
+    {":", Python3Lexer::COLON},
+    {";", Python3Lexer::SEMI_COLON},
+    {"<<=", Python3Lexer::LEFT_SHIFT_ASSIGN},
+    {"<<", Python3Lexer::LEFT_SHIFT},
+    {"<=", Python3Lexer::LT_EQ},
+    {"<>", Python3Lexer::NOT_EQ_1},
+    {"<", Python3Lexer::LESS_THAN},
+    {"==", Python3Lexer::EQUALS},
+    {"=", Python3Lexer::ASSIGN},
+    {">>=", Python3Lexer::RIGHT_SHIFT_ASSIGN},
+    {">>", Python3Lexer::RIGHT_SHIFT},
+    {">=", Python3Lexer::GT_EQ},
+    {">", Python3Lexer::GREATER_THAN},
+    {"@=", Python3Lexer::AT_ASSIGN},
+    {"@", Python3Lexer::AT},
+    {"[", Python3Lexer::OPEN_BRACK},
+    {"]", Python3Lexer::CLOSE_BRACK},
+    {"^=", Python3Lexer::XOR_ASSIGN},
+    {"^", Python3Lexer::XOR},
+    {"{", Python3Lexer::OPEN_BRACE},
+    {"|=", Python3Lexer::OR_ASSIGN},
+    {"|", Python3Lexer::OR_OP},
+    {"}", Python3Lexer::CLOSE_BRACE},
+    {"~", Python3Lexer::NOT_OP},
+};
+
+constexpr size_t OPERATOR_COUNT = sizeof(OPERATORS) / sizeof(OPERATORS[0]);
+
+// Index of the first operator starting with each ASCII character, or
+// OPERATOR_COUNT
+constexpr std::array<uint8_t, 128> makeOperatorStarts() {
+    std::array<uint8_t, 128> starts{};
+    for (uint8_t& start : starts) start = OPERATOR_COUNT;
+    for (size_t i = OPERATOR_COUNT; i-- > 0;) starts[static_cast<uint8_t>(OPERATORS[i].text[0])] = i;
+    return starts;
+}
+
+constexpr std::array<uint8_t, 128> OPERATOR_STARTS = makeOperatorStarts();
+
+constexpr Literal KEYWORDS[] = {
+    {"def", Python3Lexer::DEF},
+    {"return", Python3Lexer::RETURN},
+    {"if", Python3Lexer::IF},
+    {"elif", Python3Lexer::ELIF},
+    {"else", Python3Lexer::ELSE},
+    {"while", Python3Lexer::WHILE},
+    {"for", Python3Lexer::FOR},
+    {"in", Python3Lexer::IN},
+    {"or", Python3Lexer::OR},
+    {"and", Python3Lexer::AND},
+    {"not", Python3Lexer::NOT},
+    {"None", Python3Lexer::NONE},
+    {"True", Python3Lexer::TRUE},
+    {"False", Python3Lexer::FALSE},
+    {"continue", Python3Lexer::CONTINUE},
+    {"break", Python3Lexer::BREAK},
+};
+
+struct CodeRange {
+    uint32_t first;
+    uint32_t last;
+};
+
+// Non-ASCII code points of ID_START and, beyond those, of ID_CONTINUE in
+// Python3Lexer.g4, merged and sorted
+const CodeRange ID_START_RANGES[] = {
+    {0x00AA, 0x00AA}, {0x00B5, 0x00B5}, {0x00BA, 0x00BA}, {0x00C0, 0x00D6}, {0x00D8, 0x00F6}, {0x00F8, 0x0241},
+    {0x0250, 0x02C1}, {0x02C6, 0x02D1}, {0x02E0, 0x02E4}, {0x02EE, 0x02EE}, {0x037A, 0x037A}, {0x0386, 0x0386},
+    {0x0388, 0x038A}, {0x038C, 0x038C}, {0x038E, 0x03A1}, {0x03A3, 0x03CE}, {0x03D0, 0x03F5}, {0x03F7, 0x0481},
+    {0x048A, 0x04CE}, {0x04D0, 0x04F9}, {0x0500, 0x050F}, {0x0531, 0x0556}, {0x0559, 0x0559}, {0x0561, 0x0587},
+    {0x05D0, 0x05EA}, {0x05F0, 0x05F2}, {0x0621, 0x063A}, {0x0640, 0x064A}, {0x066E, 0x066F}, {0x0671, 0x06D3},
+    {0x06D5, 0x06D5}, {0x06E5, 0x06E6}, {0x06EE, 0x06EF}, {0x06FA, 0x06FC}, {0x06FF, 0x06FF}, {0x0710, 0x0710},
+    {0x0712, 0x072F}, {0x074D, 0x076D}, {0x0780, 0x07A5}, {0x07B1, 0x07B1}, {0x0904, 0x0939}, {0x093D, 0x093D},
+    {0x0950, 0x0950}, {0x0958, 0x0961}, {0x097D, 0x097D}, {0x0985, 0x098C}, {0x098F, 0x0990}, {0x0993, 0x09A8},
+    {0x09AA, 0x09B0}, {0x09B2, 0x09B2}, {0x09B6, 0x09B9}, {0x09BD, 0x09BD}, {0x09CE, 0x09CE}, {0x09DC, 0x09DD},
+    {0x09DF, 0x09E1}, {0x09F0, 0x09F1}, {0x0A05, 0x0A0A}, {0x0A0F, 0x0A10}, {0x0A13, 0x0A28}, {0x0A2A, 0x0A30},
+    {0x0A32, 0x0A33}, {0x0A35, 0x0A36}, {0x0A38, 0x0A39}, {0x0A59, 0x0A5C}, {0x0A5E, 0x0A5E}, {0x0A72, 0x0A74},
+    {0x0A85, 0x0A8D}, {0x0A8F, 0x0A91}, {0x0A93, 0x0AA8}, {0x0AAA, 0x0AB0}, {0x0AB2, 0x0AB3}, {0x0AB5, 0x0AB9},
+    {0x0ABD, 0x0ABD}, {0x0AD0, 0x0AD0}, {0x0AE0, 0x0AE1}, {0x0B05, 0x0B0C}, {0x0B0F, 0x0B10}, {0x0B13, 0x0B28},
+    {0x0B2A, 0x0B30}, {0x0B32, 0x0B33}, {0x0B35, 0x0B39}, {0x0B3D, 0x0B3D}, {0x0B5C, 0x0B5D}, {0x0B5F, 0x0B61},
+    {0x0B71, 0x0B71}, {0x0B83, 0x0B83}, {0x0B85, 0x0B8A}, {0x0B8E, 0x0B90}, {0x0B92, 0x0B95}, {0x0B99, 0x0B9A},
+    {0x0B9C, 0x0B9C}, {0x0B9E, 0x0B9F}, {0x0BA3, 0x0BA4}, {0x0BA8, 0x0BAA}, {0x0BAE, 0x0BB9}, {0x0C05, 0x0C0C},
+    {0x0C0E, 0x0C10}, {0x0C12, 0x0C28}, {0x0C2A, 0x0C33}, {0x0C35, 0x0C39}, {0x0C60, 0x0C61}, {0x0C85, 0x0C8C},
+    {0x0C8E, 0x0C90}, {0x0C92, 0x0CA8}, {0x0CAA, 0x0CB3}, {0x0CB5, 0x0CB9}, {0x0CBD, 0x0CBD}, {0x0CDE, 0x0CDE},
+    {0x0CE0, 0x0CE1}, {0x0D05, 0x0D0C}, {0x0D0E, 0x0D10}, {0x0D12, 0x0D28}, {0x0D2A, 0x0D39}, {0x0D60, 0x0D61},
+    {0x0D85, 0x0D96}, {0x0D9A, 0x0DB1}, {0x0DB3, 0x0DBB}, {0x0DBD, 0x0DBD}, {0x0DC0, 0x0DC6}, {0x0E01, 0x0E30},
+    {0x0E32, 0x0E33}, {0x0E40, 0x0E46}, {0x0E81, 0x0E82}, {0x0E84, 0x0E84}, {0x0E87, 0x0E88}, {0x0E8A, 0x0E8A},
+    {0x0E8D, 0x0E8D}, {0x0E94, 0x0E97}, {0x0E99, 0x0E9F}, {0x0EA1, 0x0EA3}, {0x0EA5, 0x0EA5}, {0x0EA7, 0x0EA7},
+    {0x0EAA, 0x0EAB}, {0x0EAD, 0x0EB0}, {0x0EB2, 0x0EB3}, {0x0EBD, 0x0EBD}, {0x0EC0, 0x0EC4}, {0x0EC6, 0x0EC6},
+    {0x0EDC, 0x0EDD}, {0x0F00, 0x0F00}, {0x0F40, 0x0F47}, {0x0F49, 0x0F6A}, {0x0F88, 0x0F8B}, {0x1000, 0x1021},
+    {0x1023, 0x1027}, {0x1029, 0x102A}, {0x1050, 0x1055}, {0x10A0, 0x10C5}, {0x10D0, 0x10FA}, {0x10FC, 0x10FC},
+    {0x1100, 0x1159}, {0x115F, 0x11A2}, {0x11A8, 0x11F9}, {0x1200, 0x1248}, {0x124A, 0x124D}, {0x1250, 0x1256},
+    {0x1258, 0x1258}, {0x125A, 0x125D}, {0x1260, 0x1288}, {0x128A, 0x128D}, {0x1290, 0x12B0}, {0x12B2, 0x12B5},
+    {0x12B8, 0x12BE}, {0x12C0, 0x12C0}, {0x12C2, 0x12C5}, {0x12C8, 0x12D6}, {0x12D8, 0x1310}, {0x1312, 0x1315},
+    {0x1318, 0x135A}, {0x1380, 0x138F}, {0x13A0, 0x13F4}, {0x1401, 0x166C}, {0x166F, 0x1676}, {0x1681, 0x169A},
+    {0x16A0, 0x16EA}, {0x16EE, 0x16F0}, {0x1700, 0x170C}, {0x170E, 0x1711}, {0x1720, 0x1731}, {0x1740, 0x1751},
+    {0x1760, 0x176C}, {0x176E, 0x1770}, {0x1780, 0x17B3}, {0x17D7, 0x17D7}, {0x17DC, 0x17DC}, {0x1820, 0x1877},
+    {0x1880, 0x18A8}, {0x1900, 0x191C}, {0x1950, 0x196D}, {0x1970, 0x1974}, {0x1980, 0x19A9}, {0x19C1, 0x19C7},
+    {0x1A00, 0x1A16}, {0x1D00, 0x1DBF}, {0x1E00, 0x1E9B}, {0x1EA0, 0x1EF9}, {0x1F00, 0x1F15}, {0x1F18, 0x1F1D},
+    {0x1F20, 0x1F45}, {0x1F48, 0x1F4D}, {0x1F50, 0x1F57}, {0x1F59, 0x1F59}, {0x1F5B, 0x1F5B}, {0x1F5D, 0x1F5D},
+    {0x1F5F, 0x1F7D}, {0x1F80, 0x1FB4}, {0x1FB6, 0x1FBC}, {0x1FBE, 0x1FBE}, {0x1FC2, 0x1FC4}, {0x1FC6, 0x1FCC},
+    {0x1FD0, 0x1FD3}, {0x1FD6, 0x1FDB}, {0x1FE0, 0x1FEC}, {0x1FF2, 0x1FF4}, {0x1FF6, 0x1FFC}, {0x2071, 0x2071},
+    {0x207F, 0x207F}, {0x2090, 0x2094}, {0x2102, 0x2102}, {0x2107, 0x2107}, {0x210A, 0x2113}, {0x2115, 0x2115},
+    {0x2118, 0x211D}, {0x2124, 0x2124}, {0x2126, 0x2126}, {0x2128, 0x2128}, {0x212A, 0x2131}, {0x2133, 0x2139},
+    {0x213C, 0x213F}, {0x2145, 0x2149}, {0x2160, 0x2183}, {0x2C00, 0x2C2E}, {0x2C30, 0x2C5E}, {0x2C80, 0x2CE4},
+    {0x2D00, 0x2D25}, {0x2D30, 0x2D65}, {0x2D6F, 0x2D6F}, {0x2D80, 0x2D96}, {0x2DA0, 0x2DA6}, {0x2DA8, 0x2DAE},
+    {0x2DB0, 0x2DB6}, {0x2DB8, 0x2DBE}, {0x2DC0, 0x2DC6}, {0x2DC8, 0x2DCE}, {0x2DD0, 0x2DD6}, {0x2DD8, 0x2DDE},
+    {0x3005, 0x3007}, {0x3021, 0x3029}, {0x3031, 0x3035}, {0x3038, 0x303C}, {0x3041, 0x3096}, {0x309B, 0x309F},
+    {0x30A1, 0x30FA}, {0x30FC, 0x30FF}, {0x3105, 0x312C}, {0x3131, 0x318E}, {0x31A0, 0x31B7}, {0x31F0, 0x31FF},
+    {0x3400, 0x4DB5}, {0x4E00, 0x9FBB}, {0xA000, 0xA48C}, {0xA800, 0xA801}, {0xA803, 0xA805}, {0xA807, 0xA80A},
+    {0xA80C, 0xA822}, {0xAC00, 0xD7A3}, {0xF900, 0xFA2D}, {0xFA30, 0xFA6A}, {0xFA70, 0xFAD9}, {0xFB00, 0xFB06},
+    {0xFB13, 0xFB17}, {0xFB1D, 0xFB1D}, {0xFB1F, 0xFB28}, {0xFB2A, 0xFB36}, {0xFB38, 0xFB3C}, {0xFB3E, 0xFB3E},
+    {0xFB40, 0xFB41}, {0xFB43, 0xFB44}, {0xFB46, 0xFBB1}, {0xFBD3, 0xFD3D}, {0xFD50, 0xFD8F}, {0xFD92, 0xFDC7},
+    {0xFDF0, 0xFDFB}, {0xFE70, 0xFE74}, {0xFE76, 0xFEFC}, {0xFF21, 0xFF3A}, {0xFF41, 0xFF5A}, {0xFF66, 0xFFBE},
+    {0xFFC2, 0xFFC7}, {0xFFCA, 0xFFCF}, {0xFFD2, 0xFFD7}, {0xFFDA, 0xFFDC},
+};
+const CodeRange ID_CONTINUE_RANGES[] = {
+    {0x0300, 0x036F}, {0x0483, 0x0486}, {0x0591, 0x05B9}, {0x05BB, 0x05BD}, {0x05BF, 0x05BF}, {0x05C1, 0x05C2},
+    {0x05C4, 0x05C5}, {0x05C7, 0x05C7}, {0x0610, 0x0615}, {0x064B, 0x065E}, {0x0660, 0x0669}, {0x0670, 0x0670},
+    {0x06D6, 0x06DC}, {0x06DF, 0x06E4}, {0x06E7, 0x06E8}, {0x06EA, 0x06ED}, {0x06F0, 0x06F9}, {0x0711, 0x0711},
+    {0x0730, 0x074A}, {0x07A6, 0x07B0}, {0x0901, 0x0903}, {0x093C, 0x093C}, {0x093E, 0x094D}, {0x0951, 0x0954},
+    {0x0962, 0x0963}, {0x0966, 0x096F}, {0x0981, 0x0983}, {0x09BC, 0x09BC}, {0x09BE, 0x09C4}, {0x09C7, 0x09C8},
+    {0x09CB, 0x09CD}, {0x09D7, 0x09D7}, {0x09E2, 0x09E3}, {0x09E6, 0x09EF}, {0x0A01, 0x0A03}, {0x0A3C, 0x0A3C},
+    {0x0A3E, 0x0A42}, {0x0A47, 0x0A48}, {0x0A4B, 0x0A4D}, {0x0A66, 0x0A71}, {0x0A81, 0x0A83}, {0x0ABC, 0x0ABC},
+    {0x0ABE, 0x0AC5}, {0x0AC7, 0x0AC9}, {0x0ACB, 0x0ACD}, {0x0AE2, 0x0AE3}, {0x0AE6, 0x0AEF}, {0x0B01, 0x0B03},
+    {0x0B3C, 0x0B3C}, {0x0B3E, 0x0B43}, {0x0B47, 0x0B48}, {0x0B4B, 0x0B4D}, {0x0B56, 0x0B57}, {0x0B66, 0x0B6F},
+    {0x0B82, 0x0B82}, {0x0BBE, 0x0BC2}, {0x0BC6, 0x0BC8}, {0x0BCA, 0x0BCD}, {0x0BD7, 0x0BD7}, {0x0BE6, 0x0BEF},
+    {0x0C01, 0x0C03}, {0x0C3E, 0x0C44}, {0x0C46, 0x0C48}, {0x0C4A, 0x0C4D}, {0x0C55, 0x0C56}, {0x0C66, 0x0C6F},
+    {0x0C82, 0x0C83}, {0x0CBC, 0x0CBC}, {0x0CBE, 0x0CC4}, {0x0CC6, 0x0CC8}, {0x0CCA, 0x0CCD}, {0x0CD5, 0x0CD6},
+    {0x0CE6, 0x0CEF}, {0x0D02, 0x0D03}, {0x0D3E, 0x0D43}, {0x0D46, 0x0D48}, {0x0D4A, 0x0D4D}, {0x0D57, 0x0D57},
+    {0x0D66, 0x0D6F}, {0x0D82, 0x0D83}, {0x0DCA, 0x0DCA}, {0x0DCF, 0x0DD4}, {0x0DD6, 0x0DD6}, {0x0DD8, 0x0DDF},
+    {0x0DF2, 0x0DF3}, {0x0E31, 0x0E31}, {0x0E34, 0x0E3A}, {0x0E47, 0x0E4E}, {0x0E50, 0x0E59}, {0x0EB1, 0x0EB1},
+    {0x0EB4, 0x0EB9}, {0x0EBB, 0x0EBC}, {0x0EC8, 0x0ECD}, {0x0ED0, 0x0ED9}, {0x0F18, 0x0F19}, {0x0F20, 0x0F29},
+    {0x0F35, 0x0F35}, {0x0F37, 0x0F37}, {0x0F39, 0x0F39}, {0x0F3E, 0x0F3F}, {0x0F71, 0x0F84}, {0x0F86, 0x0F87},
+    {0x0F90, 0x0F97}, {0x0F99, 0x0FBC}, {0x0FC6, 0x0FC6}, {0x102C, 0x1032}, {0x1036, 0x1039}, {0x1040, 0x1049},
+    {0x1056, 0x1059}, {0x135F, 0x135F}, {0x1369, 0x1371}, {0x1712, 0x1714}, {0x1732, 0x1734}, {0x1752, 0x1753},
+    {0x1772, 0x1773}, {0x17B6, 0x17D3}, {0x17DD, 0x17DD}, {0x17E0, 0x17E9}, {0x180B, 0x180D}, {0x1810, 0x1819},
+    {0x18A9, 0x18A9}, {0x1920, 0x192B}, {0x1930, 0x193B}, {0x1946, 0x194F}, {0x19B0, 0x19C0}, {0x19C8, 0x19C9},
+    {0x19D0, 0x19D9}, {0x1A17, 0x1A1B}, {0x1DC0, 0x1DC3}, {0x203F, 0x2040}, {0x2054, 0x2054}, {0x20D0, 0x20DC},
+    {0x20E1, 0x20E1}, {0x20E5, 0x20EB}, {0x302A, 0x302F}, {0x3099, 0x309A}, {0xA802, 0xA802}, {0xA806, 0xA806},
+    {0xA80B, 0xA80B}, {0xA823, 0xA827}, {0xFB1E, 0xFB1E}, {0xFE00, 0xFE0F}, {0xFE20, 0xFE23}, {0xFE33, 0xFE34},
+    {0xFE4D, 0xFE4F}, {0xFF10, 0xFF19}, {0xFF3F, 0xFF3F},
+};
+
+template <size_t N>
+bool inRanges(const CodeRange (&ranges)[N], uint32_t codePoint) {
+    auto it = std::upper_bound(std::begin(ranges), std::end(ranges), codePoint,
+                               [](uint32_t value, const CodeRange& range) { return value < range.first; });
+    return it != std::begin(ranges) && codePoint <= (it - 1)->last;
+}
+
+bool isContinuation(unsigned char byte) { return (byte & 0xC0) == 0x80; }
+
+bool isLineEnd(unsigned char byte) { return byte == '\r' || byte == '\n' || byte == '\f'; }
+
+bool isHexDigit(unsigned char byte) {
+    return CHAR_CLASSES[byte] == DIGIT || (byte >= 'a' && byte <= 'f') || (byte >= 'A' && byte <= 'F');
+}
+
+// Tabs advance to the next multiple of eight, as in the lexer's
+// getIndentationCount
+int indentation(std::string_view spaces) {
+    int count = 0;
+    for (char c : spaces) count = c == '\t' ? count + 8 - count % 8 : count + 1;
+    return count;
+}
+
+struct Match {
+    size_t type;
+    size_t length;
+};
+
+class Scanner {
+public:
+    explicit Scanner(std::string_view source)
+        : s(source), n(source.size()),
+          ascii(std::none_of(source.begin(), source.end(), [](char c) { return c & 0x80; })) {}
+
+    std::vector<PyToken> run() {
+        tokens.reserve(n / 3 + 16);
+        while (step()) {}
+        return std::move(tokens);
+    }
+
+    // One call of Python3Lexer::nextToken, which checks for the end of the
+    // input before handing out each token, queued or not, and only runs the
+    // lexer proper once its queue is empty. False once the last token is in
+    // tokens.
+    bool step() {
+        if (done) return false;
+        if (pos == n && !indents.empty()) {
+            closeBlocks();
+            done = true;
+            return false;
+        }
+        if (returned == tokens.size()) lexToken();
+        done = tokens[returned++].type == TOKEN_EOF;
+        return !done;
+    }
+
+    std::vector<PyToken>& output() { return tokens; }
+
+    void discard(size_t count) {
+        tokens.erase(tokens.begin(), tokens.begin() + count);
+        returned -= std::min(returned, count);
+    }
+
+private:
+    std::string_view s;
+    size_t n;
+    bool ascii;// columns are byte offsets unless the source has multi-byte characters
+    size_t pos = 0;
+    uint32_t line = 1;
+    size_t lineStart = 0;
+    std::vector<int> indents;
+    int opened = 0;
+    int formatMode = 0;
+    bool exprMode = false;
+    std::vector<PyToken> tokens;
+    size_t returned = 0;// tokens nextToken has handed out; the rest are queued
+    bool done = false;
+
+    unsigned char at(size_t i) const { return i < n ? static_cast<unsigned char>(s[i]) : 0; }
+
+    uint32_t columnOf(size_t offset) const {
+        if (ascii) return offset - lineStart;
+        uint32_t column = 0;
+        for (size_t i = lineStart; i < offset; i++) column += !isContinuation(s[i]);
+        return column;
+    }
+
+    void advance(size_t length) {
+        for (size_t end = pos + length; pos < end; pos++) {
+            if (s[pos] == '\n') {
+                line++;
+                lineStart = pos + 1;
+            }
+        }
+    }
+
+    // A token the lexer creates in an action: it sits where the lexer is,
+    // not where its text is
+    void synthetic(size_t type, std::string_view text) {
+        tokens.push_back(PyToken{type, text, line, columnOf(pos), static_cast<uint32_t>(pos)});
+    }
+
+    // The text of such a token is the last count characters matched so far,
+    // or "<EOF>" if there are not that many
+    std::string_view lastChars(size_t count) const {
+        size_t start = pos;
+        while (count-- > 0) {
+            if (start == 0) return "<EOF>";
+            while (--start > 0 && isContinuation(s[start])) {}
+        }
+        return s.substr(start, pos - start);
+    }
+
+    size_t codePointLength(size_t i) const {
+        unsigned char lead = s[i];
+        size_t length = lead < 0xC0 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+        return std::min(length, n - i);
+    }
+
+    uint32_t decode(size_t i, size_t& length) const {
+        length = codePointLength(i);
+        unsigned char lead = s[i];
+        uint32_t codePoint = length == 1 ? lead : lead & (0x7F >> length);
+        for (size_t k = 1; k < length; k++) codePoint = codePoint << 6 | (s[i + k] & 0x3F);
+        return codePoint;
+    }
+
+    void lexToken() {
+        for (;;) {
+            if (pos == n) {
+                synthetic(TOKEN_EOF, "<EOF>");
+                return;
+            }
+            Match match = longestMatch();
+            size_t start = pos;
+            uint32_t startLine = line;
+            uint32_t startColumn = columnOf(start);
+            advance(match.length);
+            switch (match.type) {
+                case Python3Lexer::SKIP_:
+                    continue;
+                case Python3Lexer::NEWLINE:
+                    if (newline(start)) return;
+                    continue;
+                case Python3Lexer::OPEN_PAREN:
+                case Python3Lexer::OPEN_BRACK:
+                    opened++;
+                    break;
+                case Python3Lexer::CLOSE_PAREN:
+                case Python3Lexer::CLOSE_BRACK:
+                    opened--;
+                    break;
+                case Python3Lexer::OPEN_BRACE:
+                    opened++;
+                    exprMode = true;
+                    break;
+                case Python3Lexer::CLOSE_BRACE:
+                    opened--;
+                    exprMode = false;
+                    break;
+                case Python3Lexer::FORMAT_QUOTATION:
+                    formatMode++;
+                    exprMode = false;
+                    break;
+                case Python3Lexer::QUOTATION:
+                    formatMode--;
+                    if (formatMode > 0) exprMode = true;
+                    break;
+            }
+            tokens.push_back(PyToken{match.type, s.substr(start, match.length), startLine, startColumn,
+                                     static_cast<uint32_t>(start)});
+            return;
+        }
+    }
+
+    // Candidates are tried in the order their rules appear in the grammar,
+    // and only a strictly longer match replaces an earlier one
+    Match longestMatch() const {
+        Match best{Python3Lexer::UNKNOWN_CHAR, 0};
+        auto consider = [&](size_t type, size_t length) {
+            if (length > best.length) best = Match{type, length};
+        };
+        unsigned char c = s[pos];
+        bool formatText = formatMode > 0 && !exprMode;
+        switch (CHAR_CLASSES[c]) {
+            case LETTER: {
+                consider(Python3Lexer::STRING, matchString(!formatText));
+                size_t length = matchName();
+                consider(keywordOr(Python3Lexer::NAME, length), length);
+                break;
+            }
+            case DIGIT:
+            case DOT:
+                consider(Python3Lexer::NUMBER, matchNumber());
+                break;
+            case QUOTE:
+                consider(Python3Lexer::STRING, matchString(!formatText));
+                break;
+            case SPACE:
+                if (pos == 0) consider(Python3Lexer::NEWLINE, spaces(pos));
+                break;
+            case LINE_END:
+                consider(Python3Lexer::NEWLINE, matchNewline());
+                break;
+            case NON_ASCII:
+                consider(Python3Lexer::NAME, matchName());
+                break;
+        }
+        if (formatText) consider(Python3Lexer::FORMAT_STRING_LITERAL, matchFormatText());
+        if (c < 0x80 && OPERATOR_STARTS[c] < OPERATOR_COUNT) {
+            Match op = matchOperator(OPERATOR_STARTS[c]);
+            consider(op.type, op.length);
+        }
+        if (c == 'f' && at(pos + 1) == '"') consider(Python3Lexer::FORMAT_QUOTATION, 2);
+        if (c == '"' && formatText) consider(Python3Lexer::QUOTATION, 1);
+        consider(Python3Lexer::SKIP_, matchSkip());
+        consider(Python3Lexer::UNKNOWN_CHAR, codePointLength(pos));
+        return best;
+    }
+
+    size_t spaces(size_t from) const {
+        size_t i = from;
+        while (i < n && CHAR_CLASSES[static_cast<unsigned char>(s[i])] == SPACE) i++;
+        return i - from;
+    }
+
+    size_t digits(size_t from) const {
+        size_t i = from;
+        while (i < n && CHAR_CLASSES[static_cast<unsigned char>(s[i])] == DIGIT) i++;
+        return i - from;
+    }
+
+    size_t keywordOr(size_t type, size_t length) const {
+        for (const Literal& keyword : KEYWORDS) {
+            if (std::strlen(keyword.text) == length && s.compare(pos, length, keyword.text) == 0) return keyword.type;
+        }
+        return type;
+    }
+
+    Match matchOperator(size_t first) const {
+        for (size_t i = first; i < OPERATOR_COUNT && OPERATORS[i].text[0] == s[pos]; i++) {
+            size_t length = std::strlen(OPERATORS[i].text);
+            if (s.compare(pos, length, OPERATORS[i].text, length) == 0) return Match{OPERATORS[i].type, length};
+        }
+        return Match{Python3Lexer::UNKNOWN_CHAR, 0};
+    }
+
+    // NAME: ID_START ID_CONTINUE*
+    size_t matchName() const {
+        size_t i = pos;
+        for (bool first = true; i < n; first = false) {
+            unsigned char c = s[i];
+            uint8_t charClass = CHAR_CLASSES[c];
+            if (charClass == LETTER || (charClass == DIGIT && !first)) {
+                i++;
+            } else if (charClass == NON_ASCII) {
+                size_t length;
+                uint32_t codePoint = decode(i, length);
+                if (!inRanges(ID_START_RANGES, codePoint) && (first || !inRanges(ID_CONTINUE_RANGES, codePoint))) {
+                    break;
+                }
+                i += length;
+            } else {
+                break;
+            }
+        }
+        return i - pos;
+    }
+
+    // NUMBER: the longest of the integer, float and imaginary forms
+    size_t matchNumber() const {
+        size_t intPart = digits(pos);
+        size_t intEnd = pos + intPart;
+        size_t best = 0;
+        if (intPart > 0) {
+            best = s[pos] == '0' ? std::find_if(s.begin() + pos, s.begin() + intEnd, [](char c) { return c != '0'; }) -
+                                           (s.begin() + pos)
+                                 : intPart;
+            unsigned char base = at(pos + 1) | 0x20;
+            if (s[pos] == '0' && (base == 'o' || base == 'x' || base == 'b')) {
+                size_t i = pos + 2;
+                while (i < n && (base == 'x'   ? isHexDigit(s[i])
+                                 : base == 'o' ? s[i] >= '0' && s[i] <= '7'
+                                               : s[i] == '0' || s[i] == '1')) {
+                    i++;
+                }
+                if (i > pos + 2) best = std::max(best, i - pos);
+            }
+        }
+
+        // Ends of FLOAT_NUMBER, any of which may be followed by j for
+        // IMAG_NUMBER; so may INT_PART, which on its own is no number
+        if (intPart > 0 && (at(intEnd) | 0x20) == 'j') best = std::max(best, intPart + 1);
+        size_t ends[3];
+        size_t count = 0;
+        if (size_t exponent = intPart > 0 ? matchExponent(intEnd) : 0) ends[count++] = intEnd + exponent;
+        if (at(intEnd) == '.') {
+            size_t fraction = digits(intEnd + 1);
+            if (intPart > 0 || fraction > 0) {
+                size_t pointEnd = intEnd + 1 + fraction;
+                ends[count++] = pointEnd;
+                if (size_t exponent = matchExponent(pointEnd)) ends[count++] = pointEnd + exponent;
+            }
+        }
+        for (size_t i = 0; i < count; i++) {
+            size_t end = ends[i] + ((at(ends[i]) | 0x20) == 'j');
+            best = std::max(best, end - pos);
+        }
+        return best;
+    }
+
+    size_t matchExponent(size_t from) const {
+        if ((at(from) | 0x20) != 'e') return 0;
+        size_t i = from + 1;
+        if (at(i) == '+' || at(i) == '-') i++;
+        size_t count = digits(i);
+        return count > 0 ? i + count - from : 0;
+    }
+
+    // STRING: an optional prefix, then a short or long string. Text strings
+    // are only recognized outside the literal parts of an f-string.
+    size_t matchString(bool textAllowed) const {
+        size_t prefix = 0;
+        bool bytes = false;
+        if (CHAR_CLASSES[static_cast<unsigned char>(s[pos])] != QUOTE) {
+            unsigned char first = s[pos] | 0x20;
+            if (CHAR_CLASSES[at(pos + 1)] == QUOTE) {
+                if (first == 'b') {
+                    bytes = true;
+                } else if (first != 'r' && first != 'u') {
+                    return 0;
+                }
+                prefix = 1;
+            } else if (CHAR_CLASSES[at(pos + 2)] == QUOTE) {
+                unsigned char second = at(pos + 1) | 0x20;
+                if ((first == 'b' && second == 'r') || (first == 'r' && second == 'b')) {
+                    bytes = true;
+                } else if (!(first == 'f' && second == 'r') && !(first == 'r' && second == 'f')) {
+                    return 0;
+                }
+                prefix = 2;
+            } else {
+                return 0;
+            }
+        }
+        if (!bytes && !textAllowed) return 0;
+
+        size_t quote = pos + prefix;
+        char q = s[quote];
+        size_t length = shortString(quote, bytes);
+        if (at(quote + 1) == q && at(quote + 2) == q) length = std::max(length, longString(quote, bytes));
+        return length > 0 ? prefix + length : 0;
+    }
+
+    size_t shortString(size_t quote, bool bytes) const {
+        char q = s[quote];
+        for (size_t i = quote + 1; i < n;) {
+            unsigned char c = s[i];
+            if (c == q) return i + 1 - quote;
+            if (c == '\\') {
+                if (i + 1 == n || (bytes && at(i + 1) >= 0x80)) return 0;
+                // An escaped \r\n is one escape, through STRING_ESCAPE_SEQ's '\\' NEWLINE
+                i += !bytes && s[i + 1] == '\r' && at(i + 2) == '\n' ? 3 : 2;
+                continue;
+            }
+            if (c == '\n' || c == '\r' || (bytes ? c >= 0x80 : c == '\f')) return 0;
+            i++;
+        }
+        return 0;
+    }
+
+    // Long strings are matched non-greedily: they end at the first unescaped
+    // triple quote
+    size_t longString(size_t quote, bool bytes) const {
+        char q = s[quote];
+        for (size_t i = quote + 3; i < n;) {
+            unsigned char c = s[i];
+            if (c == q && at(i + 1) == q && at(i + 2) == q) return i + 3 - quote;
+            if (c == '\\') {
+                if (i + 1 == n || (bytes && at(i + 1) >= 0x80)) return 0;
+                i += 2;
+                continue;
+            }
+            if (bytes && c >= 0x80) return 0;
+            i++;
+        }
+        return 0;
+    }
+
+    // FORMAT_STRING_LITERAL: (STRING_ESCAPE_SEQ | ~[\\\r\n\f"{}] | '{{' | '}}')+
+    size_t matchFormatText() const {
+        size_t i = pos;
+        while (i < n) {
+            unsigned char c = s[i];
+            if (c == '\\') {
+                if (i + 1 == n) break;
+                i += s[i + 1] == '\r' && at(i + 2) == '\n' ? 3 : 2;
+            } else if (c == '{' || c == '}') {
+                if (at(i + 1) != c) break;
+                i += 2;
+            } else if (isLineEnd(c) || c == '"') {
+                break;
+            } else {
+                i++;
+            }
+        }
+        return i - pos;
+    }
+
+    // NEWLINE: ('\r'? '\n' | '\r' | '\f') SPACES?
+    size_t matchNewline() const {
+        size_t length = s[pos] == '\r' && at(pos + 1) == '\n' ? 2 : 1;
+        return length + spaces(pos + length);
+    }
+
+    // SKIP_: SPACES | COMMENT | LINE_JOINING
+    size_t matchSkip() const {
+        unsigned char c = s[pos];
+        if (CHAR_CLASSES[c] == SPACE) return spaces(pos);
+        if (c == '#') {
+            size_t i = pos + 1;
+            while (i < n && !isLineEnd(s[i])) i++;
+            return i - pos;
+        }
+        if (c == '\\') {
+            size_t i = pos + 1 + spaces(pos + 1);
+            if (at(i) == '\r' && at(i + 1) == '\n') return i + 2 - pos;
+            return isLineEnd(at(i)) ? i + 1 - pos : 0;
+        }
+        return 0;
+    }
+
+    // The NEWLINE action: drops line breaks inside brackets and before blank
+    // or comment lines, and otherwise emits NEWLINE followed by an INDENT or
+    // DEDENTs. False if the match was skipped.
+    bool newline(size_t start) {
+        std::string_view text = s.substr(start, pos - start);
+        size_t breaks = 0;
+        while (breaks < text.size() && isLineEnd(text[breaks])) breaks++;
+        unsigned char next = at(pos);
+        if (opened > 0 || (pos < n && (isLineEnd(next) || next == '#'))) return false;
+
+        synthetic(Python3Lexer::NEWLINE, lastChars(std::max<size_t>(breaks, 1)));
+        int indent = indentation(text.substr(breaks));
+        int previous = indents.empty() ? 0 : indents.back();
+        if (indent > previous) {
+            indents.push_back(indent);
+            synthetic(Python3Lexer::INDENT, lastChars(text.size() - breaks));
+        } else {
+            while (!indents.empty() && indents.back() > indent) {
+                synthetic(Python3Lexer::DEDENT, "DEDENT");
+                indents.pop_back();
+            }
+        }
+        return true;
+    }
+
+    // End of input inside a block: a NEWLINE to end the last statement, a
+    // DEDENT per open block and EOF
+    void closeBlocks() {
+        synthetic(Python3Lexer::NEWLINE, lastChars(1));
+        for (; !indents.empty(); indents.pop_back()) synthetic(Python3Lexer::DEDENT, "DEDENT");
+        synthetic(TOKEN_EOF, lastChars(5));
+    }
+};
+
+// A token whose text is a view into the source
+class ViewToken : public antlr4::WritableToken {
+public:
+    ViewToken(const PyToken& token, antlr4::TokenSource* source)
+        : type(token.type), text(token.text), line(token.line), column(token.column), offset(token.offset),
+          source(source) {}
+
+    std::string getText() const override { return std::string(text); }
+    size_t getType() const override { return type; }
+    size_t getLine() const override { return line; }
+    size_t getCharPositionInLine() const override { return column; }
+    size_t getChannel() const override { return channel; }
+    size_t getTokenIndex() const override { return index; }
+    size_t getStartIndex() const override { return offset; }
+    size_t getStopIndex() const override { return offset + text.size() - 1; }
+    antlr4::TokenSource* getTokenSource() const override { return source; }
+    antlr4::CharStream* getInputStream() const override { return nullptr; }
+
+    std::string toString() const override {
+        return "[@" + std::to_string(static_cast<long long>(index)) + ",'" + getText() + "',<" +
+               std::to_string(static_cast<long long>(type)) + ">," + std::to_string(line) + ":" +
+               std::to_string(column) + "]";
+    }
+
+    void setText(const std::string& replacement) override {
+        ownText = replacement;
+        text = ownText;
+    }
+    void setType(size_t ttype) override { type = ttype; }
+    void setLine(size_t newLine) override { line = newLine; }
+    void setCharPositionInLine(size_t position) override { column = position; }
+    void setChannel(size_t newChannel) override { channel = newChannel; }
+    void setTokenIndex(size_t newIndex) override { index = newIndex; }
+
+private:
+    size_t type;
+    std::string_view text;
+    size_t line;
+    size_t column;
+    size_t offset;
+    antlr4::TokenSource* source;
+    size_t channel = DEFAULT_CHANNEL;
+    size_t index = INVALID_INDEX;
+    std::string ownText;
+};
+
+}// namespace
+
+std::vector<PyToken> tokenize(std::string_view source) { return Scanner(source).run(); }
+
+struct TokenScanner::Impl {
+    explicit Impl(std::string_view source) : scanner(source) {}
+    Scanner scanner;
+};
+
+TokenScanner::TokenScanner(std::string_view source) : impl(std::make_unique<Impl>(source)) {}
+
+TokenScanner::~TokenScanner() = default;
+
+bool TokenScanner::scan() {
+    std::vector<PyToken>& tokens = impl->scanner.output();
+    size_t before = tokens.size();
+    while (tokens.size() == before && impl->scanner.step()) {}
+    return tokens.size() > before;
+}
+
+std::vector<PyToken>& TokenScanner::tokens() { return impl->scanner.output(); }
+
+void TokenScanner::discard(size_t count) { impl->scanner.discard(count); }
+
+TokenizerSource::TokenizerSource(std::string_view source) : tokens(tokenize(source)) {}
+
+std::unique_ptr<antlr4::Token> TokenizerSource::nextToken() {
+    const PyToken& token = tokens[next];
+    if (next + 1 < tokens.size()) next++;// keep handing out EOF at the end
+    return std::make_unique<ViewToken>(token, this);
+}
+
+size_t TokenizerSource::getLine() const { return tokens[next].line; }
+
+size_t TokenizerSource::getCharPositionInLine() { return tokens[next].column; }
+
+antlr4::TokenFactory<antlr4::CommonToken>* TokenizerSource::getTokenFactory() {
+    return antlr4::CommonTokenFactory::DEFAULT.get();
+}
@@ -0,0 +1,70 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_TOKENIZER_H
+#define PYTHON_INTERPRETER_TOKENIZER_H
+
+#include "antlr4-runtime.h"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// One token as Python3Lexer would emit it: its type (a Python3Lexer token
+// type or antlr4::Token::EOF), its text and where it starts. Text points
+// into the tokenized source or, for DEDENT and EOF, at a static string.
+struct PyToken {
+    size_t type;
+    std::string_view text;
+    uint32_t line;  // from 1
+    uint32_t column;// in code points, from 0
+    uint32_t offset;// in bytes
+};
+
+// Hand-written replacement for the generated Python3Lexer. It yields the
+// token stream that lexer hands the parser, including the NEWLINE, INDENT
+// and DEDENT tokens its actions insert, their placement at the end of the
+// input and the tokens of f-strings, but scans the UTF-8 source directly
+// with character class tables instead of simulating the lexer ATN.
+//
+// Where several lexer rules match, the longest match wins and ties go to
+// the rule listed first in Python3Lexer.g4, as in ANTLR. The result always
+// ends with exactly one EOF token.
+std::vector<PyToken> tokenize(std::string_view source);
+
+// Produces tokenize()'s tokens a few at a time, so that parsing can start
+// before the whole source is scanned. The source must outlive the tokens.
+class TokenScanner {
+public:
+    explicit TokenScanner(std::string_view source);
+    ~TokenScanner();
+
+    // Appends at least one more token to tokens(); false once the EOF
+    // token is there and nothing is left to scan
+    bool scan();
+    std::vector<PyToken>& tokens();
+    // Drops the first count tokens, which the parser is done with
+    void discard(size_t count);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+// Feeds tokenize()'s output to an ANTLR parser. The source must outlive
+// the token stream and the parse tree.
+class TokenizerSource : public antlr4::TokenSource {
+public:
+    explicit TokenizerSource(std::string_view source);
+
+    std::unique_ptr<antlr4::Token> nextToken() override;
+    size_t getLine() const override;
+    size_t getCharPositionInLine() override;
+    antlr4::CharStream* getInputStream() override { return nullptr; }
+    std::string getSourceName() override { return antlr4::IntStream::UNKNOWN_SOURCE_NAME; }
+    antlr4::TokenFactory<antlr4::CommonToken>* getTokenFactory() override;
+
+private:
+    std::vector<PyToken> tokens;
+    size_t next = 0;
+};
+
+#endif//PYTHON_INTERPRETER_TOKENIZER_H
@@ -0,0 +1,503 @@
+#include "TypeInference.h"
+#include "Resolver.h"
+#include <unordered_map>
+#include <vector>
+
+using namespace ast;
+
+namespace {
+
+// StaticType extended with a bottom, NONE_YET, for values not seen yet:
+// the fixed point starts from it and joins types in as they turn up
+enum class Type : uint8_t { NONE_YET, INT, FLOAT, BOOL, STR, ANY };
+
+Type join(Type a, Type b) {
+    if (a == Type::NONE_YET) return b;
+    if (b == Type::NONE_YET) return a;
+    return a == b ? a : Type::ANY;
+}
+
+StaticType toStatic(Type type) {
+    switch (type) {
+        case Type::INT: return StaticType::INT;
+        case Type::FLOAT: return StaticType::FLOAT;
+        case Type::BOOL: return StaticType::BOOL;
+        case Type::STR: return StaticType::STR;
+        default: return StaticType::ANY;
+    }
+}
+
+Type typeOf(const Value& value) {
+    switch (value.type) {
+        case ValueType::INT: return Type::INT;
+        case ValueType::FLOAT: return Type::FLOAT;
+        case ValueType::BOOL: return Type::BOOL;
+        case ValueType::STRING: return Type::STR;
+        default: return Type::ANY;
+    }
+}
+
+bool isNumber(Type type) { return type == Type::INT || type == Type::FLOAT; }
+
+// Result types of the Value operators
+Type unaryType(UnaryOp op, Type operand) {
+    if (operand == Type::NONE_YET) return operand;
+    switch (op) {
+        case UnaryOp::NEG: return isNumber(operand) ? operand : Type::ANY;
+        case UnaryOp::POS: return operand;
+        case UnaryOp::NOT: return Type::BOOL;
+    }
+    return Type::ANY;
+}
+
+Type binaryType(BinaryOp op, Type lhs, Type rhs) {
+    if (lhs == Type::NONE_YET || rhs == Type::NONE_YET) return Type::NONE_YET;
+    bool ints = lhs == Type::INT && rhs == Type::INT;
+    bool numbers = isNumber(lhs) && isNumber(rhs);
+    switch (op) {
+        case BinaryOp::ADD:
+            if (lhs == Type::STR || rhs == Type::STR) return Type::STR;
+            return ints ? Type::INT : numbers ? Type::FLOAT : Type::ANY;
+        case BinaryOp::SUB:
+            return ints ? Type::INT : numbers ? Type::FLOAT : Type::ANY;
+        case BinaryOp::MUL:
+            if ((lhs == Type::STR && rhs == Type::INT) || (lhs == Type::INT && rhs == Type::STR)) return Type::STR;
+            return ints ? Type::INT : numbers ? Type::FLOAT : Type::ANY;
+        case BinaryOp::DIV:
+            return Type::FLOAT;
+        case BinaryOp::FLOORDIV:
+            // Anything but two ints is divided as floats
+            if (ints) return Type::INT;
+            return lhs == Type::ANY || rhs == Type::ANY ? Type::ANY : Type::FLOAT;
+        case BinaryOp::MOD:
+            return ints ? Type::INT : Type::ANY;
+    }
+    return Type::ANY;
+}
+
+Type builtinType(Builtin builtin) {
+    switch (builtin) {
+        case Builtin::INT: return Type::INT;
+        case Builtin::FLOAT: return Type::FLOAT;
+        case Builtin::STR: return Type::STR;
+        case Builtin::BOOL: return Type::BOOL;
+        default: return Type::ANY;
+    }
+}
+
+// Whether running body can reach its end, so the call returns None
+bool mayFallThrough(Span<Stmt*> body) {
+    if (body.empty()) return true;
+    const Stmt* last = body[body.size - 1];
+    if (last->kind == StmtKind::RETURN) return false;
+    if (last->kind != StmtKind::IF) return true;
+    auto ifStmt = static_cast<const If*>(last);
+    if (ifStmt->orelse.empty() || mayFallThrough(ifStmt->orelse)) return true;
+    for (const IfBranch& branch : ifStmt->branches) {
+        if (mayFallThrough(branch.body)) return true;
+    }
+    return false;
+}
+
+// Flags the locals of one function that can not be typed: those some read
+// may find unbound, because not every path to it assigns them first, and
+// those that may stand for a global instead
+class SlotChecker {
+public:
+    SlotChecker(const FuncDef* def, const std::vector<char>& moduleAssigned)
+        : def(def), moduleAssigned(moduleAssigned), untyped(def->localCount, false) {}
+
+    std::vector<char> check() {
+        std::vector<char> assigned(def->localCount, false);
+        std::fill(assigned.begin(), assigned.begin() + def->params.size, true);
+        checkBlock(def->body, assigned);
+        return untyped;
+    }
+
+private:
+    const FuncDef* def;
+    const std::vector<char>& moduleAssigned;
+    std::vector<char> untyped;
+
+    void use(Symbol name, int32_t slot, bool bound) {
+        if (slot == NO_SLOT) return;
+        bool local = static_cast<size_t>(slot) < def->params.size || !moduleAssigned[name];
+        if (!bound || !local) untyped[slot] = true;
+    }
+
+    void assign(const Target& target, std::vector<char>& assigned) {
+        if (target.name == NO_SYMBOL || target.slot == NO_SLOT) return;
+        use(target.name, target.slot, true);
+        assigned[target.slot] = true;
+    }
+
+    void checkBlock(Span<Stmt*> body, std::vector<char>& assigned) {
+        for (const Stmt* stmt : body) checkStmt(stmt, assigned);
+    }
+
+    // Takes the locals assigned on every path through a branch
+    static void meet(std::vector<char>& into, const std::vector<char>& branch) {
+        for (size_t i = 0; i < into.size(); i++) into[i] = into[i] && branch[i];
+    }
+
+    void checkStmt(const Stmt* stmt, std::vector<char>& assigned) {
+        switch (stmt->kind) {
+            case StmtKind::EXPR:
+                read(static_cast<const ExprStmt*>(stmt)->value, assigned);
+                break;
+            case StmtKind::ASSIGN: {
+                auto assign = static_cast<const Assign*>(stmt);
+                for (const Expr* value : assign->values) read(value, assigned);
+                for (const Span<Target>& targets : assign->targets) {
+                    if (targets.size != assign->values.size && targets.size != 1) continue;
+                    for (const Target& target : targets) this->assign(target, assigned);
+                }
+                break;
+            }
+            case StmtKind::AUG_ASSIGN: {
+                auto assign = static_cast<const AugAssign*>(stmt);
+                const Target& target = assign->target;
+                if (target.name != NO_SYMBOL) use(target.name, target.slot, target.slot == NO_SLOT || assigned[target.slot]);
+                read(assign->value, assigned);
+                this->assign(target, assigned);
+                break;
+            }
+            case StmtKind::IF: {
+                auto ifStmt = static_cast<const If*>(stmt);
+                std::vector<char> after(assigned.size(), true);
+                for (const IfBranch& branch : ifStmt->branches) {
+                    read(branch.condition, assigned);
+                    std::vector<char> inBranch = assigned;
+                    checkBlock(branch.body, inBranch);
+                    meet(after, inBranch);
+                }
+                std::vector<char> inElse = assigned;
+                checkBlock(ifStmt->orelse, inElse);
+                meet(after, inElse);
+                assigned = std::move(after);
+                break;
+            }
+            case StmtKind::WHILE: {
+                auto loop = static_cast<const While*>(stmt);
+                read(loop->condition, assigned);
+                std::vector<char> inBody = assigned;
+                checkBlock(loop->body, inBody);
+                break;
+            }
+            case StmtKind::FUNCDEF:
+                for (const Expr* value : static_cast<const FuncDef*>(stmt)->defaults) read(value, assigned);
+                break;
+            case StmtKind::RETURN:
+                if (const Expr* value = static_cast<const Return*>(stmt)->value) read(value, assigned);
+                break;
+            case StmtKind::BREAK:
+            case StmtKind::CONTINUE:
+                break;
+        }
+    }
+
+    void read(const Expr* expr, const std::vector<char>& assigned) {
+        switch (expr->kind) {
+            case ExprKind::CONSTANT:
+                break;
+            case ExprKind::NAME: {
+                auto name = static_cast<const Name*>(expr);
+                if (name->slot != NO_SLOT) use(name->name, name->slot, assigned[name->slot]);
+                break;
+            }
+            case ExprKind::UNARY:
+                read(static_cast<const Unary*>(expr)->operand, assigned);
+                break;
+            case ExprKind::BINARY:
+                read(static_cast<const Binary*>(expr)->lhs, assigned);
+                read(static_cast<const Binary*>(expr)->rhs, assigned);
+                break;
+            case ExprKind::COMPARE:
+                for (const Expr* operand : static_cast<const Compare*>(expr)->operands) read(operand, assigned);
+                break;
+            case ExprKind::BOOL_OP:
+                for (const Expr* operand : static_cast<const BoolOp*>(expr)->operands) read(operand, assigned);
+                break;
+            case ExprKind::CALL:
+                for (const Argument& arg : static_cast<const Call*>(expr)->args) read(arg.value, assigned);
+                break;
+            case ExprKind::FORMAT:
+                for (const FormatPart& part : static_cast<const FormatString*>(expr)->parts) {
+                    for (const Expr* value : part.values) read(value, assigned);
+                }
+                break;
+        }
+    }
+};
+
+class TypeInferrer {
+public:
+    explicit TypeInferrer(Program& program) : program(program) {}
+
+    void run() {
+        std::vector<char> moduleAssigned = moduleAssignedNames(program);
+        std::vector<uint32_t> defs = definitionCounts(program);
+        for (size_t i = 0; i < program.body.size; i++) collect(program.body[i], i);
+        target.assign(program.symbols.size(), NO_FUNCTION);
+        for (const Stmt* stmt : program.body) {
+            if (stmt->kind != StmtKind::FUNCDEF) continue;
+            auto def = static_cast<const FuncDef*>(stmt);
+            if (defs[def->name] == 1) target[def->name] = indexOf[def];
+        }
+        for (Function& function : functions) {
+            function.locals.assign(function.def->localCount, Type::NONE_YET);
+            function.untyped = SlotChecker(function.def, moduleAssigned).check();
+            function.defaults.assign(function.def->defaults.size, Type::NONE_YET);
+            // Calls of other functions can not be told apart by name
+            if (target[function.def->name] != indexOf[function.def]) {
+                std::fill(function.locals.begin(), function.locals.begin() + function.def->params.size, Type::ANY);
+            }
+        }
+
+        do {
+            changed = false;
+            walkProgram();
+        } while (changed);
+        annotating = true;
+        walkProgram();
+
+        for (Function& function : functions) {
+            std::vector<StaticType> types(function.locals.size(), StaticType::ANY);
+            bool typed = false;
+            for (size_t slot = 0; slot < types.size(); slot++) {
+                if (function.untyped[slot]) continue;
+                types[slot] = toStatic(function.locals[slot]);
+                typed = typed || types[slot] != StaticType::ANY;
+            }
+            if (typed) function.def->localTypes = copyToArena(program.arena, types);
+        }
+    }
+
+private:
+    static constexpr size_t NO_FUNCTION = SIZE_MAX;
+
+    struct Function {
+        FuncDef* def;
+        size_t position;// of the module-level statement the def is in
+        std::vector<Type> locals;// by slot
+        std::vector<char> untyped;// by slot, see SlotChecker
+        std::vector<Type> defaults;
+        Type returns = Type::NONE_YET;
+    };
+
+    Program& program;
+    std::vector<Function> functions;
+    std::unordered_map<const FuncDef*, size_t> indexOf;
+    std::vector<size_t> target;// by symbol, the function every call of it reaches
+    Function* current = nullptr;// nullptr at module level
+    size_t position = 0;// of the module-level statement being walked, or of current's def
+    bool changed = false;
+    bool annotating = false;// the fixed point is reached, record the types
+
+    void collect(Span<Stmt*> body, size_t position) {
+        for (Stmt* stmt : body) collect(stmt, position);
+    }
+
+    void collect(Stmt* stmt, size_t position) {
+        switch (stmt->kind) {
+            case StmtKind::IF: {
+                auto ifStmt = static_cast<If*>(stmt);
+                for (const IfBranch& branch : ifStmt->branches) collect(branch.body, position);
+                collect(ifStmt->orelse, position);
+                break;
+            }
+            case StmtKind::WHILE:
+                collect(static_cast<While*>(stmt)->body, position);
+                break;
+            case StmtKind::FUNCDEF: {
+                auto def = static_cast<FuncDef*>(stmt);
+                indexOf[def] = functions.size();
+                functions.push_back(Function{def, position, {}, {}, {}});
+                collect(def->body, position);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    void update(Type& type, Type joined) {
+        joined = join(type, joined);
+        if (joined == type) return;
+        type = joined;
+        changed = true;
+    }
+
+    void walkProgram() {
+        current = nullptr;
+        for (position = 0; position < program.body.size; position++) walkStmt(program.body[position]);
+        for (Function& function : functions) {
+            current = &function;
+            position = function.position;
+            walkBlock(function.def->body);
+            if (mayFallThrough(function.def->body)) update(function.returns, Type::ANY);
+        }
+        current = nullptr;
+    }
+
+    void walkBlock(Span<Stmt*> body) {
+        for (Stmt* stmt : body) walkStmt(stmt);
+    }
+
+    void walkStmt(Stmt* stmt) {
+        switch (stmt->kind) {
+            case StmtKind::EXPR:
+                typeExpr(static_cast<ExprStmt*>(stmt)->value);
+                break;
+            case StmtKind::ASSIGN: {
+                auto assign = static_cast<Assign*>(stmt);
+                std::vector<Type> values;
+                for (Expr* value : assign->values) values.push_back(typeExpr(value));
+                for (const Span<Target>& targets : assign->targets) {
+                    if (targets.size == values.size()) {
+                        for (size_t i = 0; i < targets.size; i++) store(targets[i], values[i]);
+                    } else if (targets.size == 1) {
+                        store(targets[0], values[0]);
+                    }
+                }
+                break;
+            }
+            case StmtKind::AUG_ASSIGN: {
+                auto assign = static_cast<AugAssign*>(stmt);
+                Type value = typeExpr(assign->value);
+                store(assign->target, binaryType(assign->op, load(assign->target.slot), value));
+                break;
+            }
+            case StmtKind::IF: {
+                auto ifStmt = static_cast<If*>(stmt);
+                for (const IfBranch& branch : ifStmt->branches) {
+                    typeExpr(branch.condition);
+                    walkBlock(branch.body);
+                }
+                walkBlock(ifStmt->orelse);
+                break;
+            }
+            case StmtKind::WHILE: {
+                auto loop = static_cast<While*>(stmt);
+                typeExpr(loop->condition);
+                walkBlock(loop->body);
+                break;
+            }
+            case StmtKind::FUNCDEF: {
+                // Only the defaults run here; bodies are walked on their own
+                auto def = static_cast<FuncDef*>(stmt);
+                Function& function = functions[indexOf[def]];
+                for (size_t i = 0; i < def->defaults.size; i++) update(function.defaults[i], typeExpr(def->defaults[i]));
+                break;
+            }
+            case StmtKind::RETURN: {
+                auto ret = static_cast<Return*>(stmt);
+                Type value = ret->value ? typeExpr(ret->value) : Type::ANY;
+                if (current) update(current->returns, value);
+                break;
+            }
+            case StmtKind::BREAK:
+            case StmtKind::CONTINUE:
+                break;
+        }
+    }
+
+    Type load(int32_t slot) const {
+        if (!current || slot == NO_SLOT || current->untyped[slot]) return Type::ANY;
+        return current->locals[slot];
+    }
+
+    void store(const Target& target, Type type) {
+        if (!current || target.name == NO_SYMBOL || target.slot == NO_SLOT) return;
+        update(current->locals[target.slot], type);
+    }
+
+    Type typeExpr(Expr* expr) {
+        Type type = Type::ANY;
+        switch (expr->kind) {
+            case ExprKind::CONSTANT:
+                type = typeOf(program.constants[static_cast<Constant*>(expr)->index]);
+                break;
+            case ExprKind::NAME:
+                type = load(static_cast<Name*>(expr)->slot);
+                break;
+            case ExprKind::UNARY: {
+                auto unary = static_cast<Unary*>(expr);
+                type = unaryType(unary->op, typeExpr(unary->operand));
+                break;
+            }
+            case ExprKind::BINARY: {
+                auto binary = static_cast<Binary*>(expr);
+                Type lhs = typeExpr(binary->lhs);
+                type = binaryType(binary->op, lhs, typeExpr(binary->rhs));
+                break;
+            }
+            case ExprKind::COMPARE:
+                for (Expr* operand : static_cast<Compare*>(expr)->operands) typeExpr(operand);
+                type = Type::BOOL;
+                break;
+            case ExprKind::BOOL_OP:
+                // The result is one of the operands
+                type = Type::NONE_YET;
+                for (Expr* operand : static_cast<BoolOp*>(expr)->operands) type = join(type, typeExpr(operand));
+                break;
+            case ExprKind::CALL:
+                type = typeCall(static_cast<Call*>(expr));
+                break;
+            case ExprKind::FORMAT:
+                for (const FormatPart& part : static_cast<FormatString*>(expr)->parts) {
+                    for (Expr* value : part.values) typeExpr(value);
+                }
+                type = Type::STR;
+                break;
+        }
+        if (annotating) expr->type = toStatic(type);
+        return type;
+    }
+
+    // Binds the argument types to the parameters like the engines bind the
+    // values; missing parameters take their default, or None
+    Type typeCall(Call* call) {
+        std::vector<Type> args;
+        for (const Argument& arg : call->args) args.push_back(typeExpr(arg.value));
+        if (call->builtin != Builtin::NONE) return builtinType(call->builtin);
+        if (target[call->callee] == NO_FUNCTION) return Type::ANY;
+
+        Function& callee = functions[target[call->callee]];
+        const FuncDef* def = callee.def;
+        std::vector<char> given(def->params.size, false);
+        size_t position = 0;
+        for (size_t i = 0; i < args.size(); i++) {
+            Symbol keyword = call->args[i].keyword;
+            if (keyword == NO_SYMBOL) {
+                if (position < def->params.size) {
+                    update(callee.locals[position], args[i]);
+                    given[position++] = true;
+                }
+                continue;
+            }
+            for (size_t p = 0; p < def->params.size; p++) {
+                if (def->params[p] != keyword) continue;
+                update(callee.locals[p], args[i]);
+                given[p] = true;
+                break;
+            }
+        }
+        size_t firstDefault = def->params.size - def->defaults.size;
+        for (size_t p = 0; p < def->params.size; p++) {
+            if (given[p]) continue;
+            update(callee.locals[p], p >= firstDefault ? callee.defaults[p - firstDefault] : Type::ANY);
+        }
+        // A call that may run before the def does not reach it. Module-level
+        // code runs in order, and a body only once its def has run; defaults
+        // are evaluated before the def binds the name.
+        bool defined = current ? callee.position <= position : callee.position < position;
+        return defined ? callee.returns : Type::ANY;
+    }
+};
+
+}// namespace
+
+void inferTypes(Program& program) {
+    TypeInferrer(program).run();
+}
@@ -0,0 +1,22 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_TYPEINFERENCE_H
+#define PYTHON_INTERPRETER_TYPEINFERENCE_H
+
+#include "Ast.h"
+
+// Proves which expressions and function locals only ever hold an int, a
+// float, a bool or a str, recording it in Expr::type and
+// FuncDef::localTypes.
+//
+// The analysis is flow-insensitive: a local's type is the join of every
+// value assigned to it anywhere in the function, and a parameter's the
+// join of the arguments at every call of the function, so only functions
+// with a single def at module level get typed parameters. Return types
+// are inferred the same way and all of it iterated to a fixed point.
+//
+// Only certainly-local names are typed, and only when every read follows
+// an assignment on all paths, since reading an unbound local gives None.
+// Runs after all other passes that rewrite the AST.
+void inferTypes(ast::Program& program);
+
+#endif//PYTHON_INTERPRETER_TYPEINFERENCE_H
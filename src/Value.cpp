@@ -0,0 +1,612 @@
+#include "Value.h"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+// ============ BigInt Implementation ============
+
+namespace {
+
+// Divisors of up to this many digits fit a uint64_t, and so does a partial
+// remainder times ten plus the next digit, so they divide in a single pass
+constexpr size_t SMALL_DIGITS = 18;
+
+uint64_t smallValue(const std::string& digits) {
+    uint64_t result = 0;
+    for (char c : digits) result = result * 10 + (c - '0');
+    return result;
+}
+
+// The k for which divisor divides 10^k, or 0 if there is none within
+// SMALL_DIGITS: 2 and 10 need the last digit, 4 and 25 the last two, ...
+size_t decimalTailDigits(uint64_t divisor) {
+    size_t twos = 0;
+    size_t fives = 0;
+    for (; divisor % 2 == 0; divisor /= 2) twos++;
+    for (; divisor % 5 == 0; divisor /= 5) fives++;
+    size_t digits = std::max<size_t>(std::max(twos, fives), 1);
+    return divisor == 1 && digits <= SMALL_DIGITS ? digits : 0;
+}
+
+}// namespace
+
+void BigInt::removeLeadingZeros() {
+    while (value.length() > 1 && value[0] == '0') {
+        value = value.substr(1);
+    }
+    if (value == "0") negative = false;
+}
+
+bool BigInt::absGreater(const std::string& a, const std::string& b) {
+    if (a.length() != b.length()) return a.length() > b.length();
+    return a > b;
+}
+
+std::string BigInt::absAdd(const std::string& a, const std::string& b) {
+    std::string result;
+    int carry = 0;
+    int i = a.length() - 1, j = b.length() - 1;
+    
+    while (i >= 0 || j >= 0 || carry) {
+        int sum = carry;
+        if (i >= 0) sum += a[i--] - '0';
+        if (j >= 0) sum += b[j--] - '0';
+        result = char('0' + sum % 10) + result;
+        carry = sum / 10;
+    }
+    return result;
+}
+
+std::string BigInt::absSub(const std::string& a, const std::string& b) {
+    std::string result;
+    int borrow = 0;
+    int i = a.length() - 1, j = b.length() - 1;
+    
+    while (i >= 0) {
+        int diff = (a[i--] - '0') - borrow;
+        if (j >= 0) diff -= (b[j--] - '0');
+        if (diff < 0) {
+            diff += 10;
+            borrow = 1;
+        } else {
+            borrow = 0;
+        }
+        result = char('0' + diff) + result;
+    }
+    
+    while (result.length() > 1 && result[0] == '0') {
+        result = result.substr(1);
+    }
+    return result;
+}
+
+std::string BigInt::absMul(const std::string& a, const std::string& b) {
+    if (a == "0" || b == "0") return "0";
+    std::vector<int> result(a.length() + b.length(), 0);
+    
+    for (int i = a.length() - 1; i >= 0; i--) {
+        for (int j = b.length() - 1; j >= 0; j--) {
+            int mul = (a[i] - '0') * (b[j] - '0');
+            int p1 = i + j, p2 = i + j + 1;
+            int sum = mul + result[p2];
+            result[p2] = sum % 10;
+            result[p1] += sum / 10;
+        }
+    }
+    
+    std::string str;
+    bool leadingZero = true;
+    for (int num : result) {
+        if (num != 0) leadingZero = false;
+        if (!leadingZero) str += char('0' + num);
+    }
+    return str.empty() ? "0" : str;
+}
+
+std::pair<std::string, std::string> BigInt::absDiv(const std::string& a, const std::string& b) {
+    if (b == "0") throw std::runtime_error("Division by zero");
+    if (!absGreater(a, b) && a != b) return {"0", a};
+    if (b.length() <= SMALL_DIGITS) {
+        uint64_t divisor = smallValue(b);
+        uint64_t remainder = 0;
+        std::string quotient;
+        quotient.reserve(a.length());
+        for (char digit : a) {
+            remainder = remainder * 10 + (digit - '0');
+            if (!quotient.empty() || remainder >= divisor) quotient += char('0' + remainder / divisor);
+            remainder %= divisor;
+        }
+        return {quotient, std::to_string(remainder)};
+    }
+    if (a == b) return {"1", "0"};
+    
+    std::string quotient, remainder;
+    for (char digit : a) {
+        remainder += digit;
+        while (remainder.length() > 1 && remainder[0] == '0') {
+            remainder = remainder.substr(1);
+        }
+        
+        int count = 0;
+        while (absGreater(remainder, b) || remainder == b) {
+            remainder = absSub(remainder, b);
+            count++;
+        }
+        quotient += char('0' + count);
+    }
+    
+    while (quotient.length() > 1 && quotient[0] == '0') {
+        quotient = quotient.substr(1);
+    }
+    if (remainder.empty()) remainder = "0";
+    
+    return {quotient, remainder};
+}
+
+// Only the remainder of absDiv, without building the quotient. Divisors of
+// a power of ten, such as 2, 10 or 1024, only need the last few digits.
+std::string BigInt::absMod(const std::string& a, const std::string& b) {
+    if (b == "0") throw std::runtime_error("Division by zero");
+    if (b.length() > SMALL_DIGITS) return absDiv(a, b).second;
+    uint64_t divisor = smallValue(b);
+    size_t tail = decimalTailDigits(divisor);
+    size_t start = tail && tail < a.length() ? a.length() - tail : 0;
+    uint64_t remainder = 0;
+    for (size_t i = start; i < a.length(); i++) {
+        remainder = (remainder * 10 + (a[i] - '0')) % divisor;
+    }
+    return std::to_string(remainder);
+}
+
+BigInt::BigInt() : value("0"), negative(false) {}
+
+BigInt::BigInt(const std::string& s) {
+    if (s.empty() || s == "-") {
+        value = "0";
+        negative = false;
+        return;
+    }
+    
+    negative = (s[0] == '-');
+    value = negative ? s.substr(1) : s;
+    removeLeadingZeros();
+}
+
+BigInt::BigInt(long long n) {
+    negative = n < 0;
+    value = std::to_string(negative ? -n : n);
+    removeLeadingZeros();
+}
+
+BigInt::BigInt(int n) : BigInt((long long)n) {}
+
+std::string BigInt::toString() const {
+    return (negative ? "-" : "") + value;
+}
+
+double BigInt::toDouble() const {
+    double result = 0.0;
+    for (char c : value) {
+        result = result * 10 + (c - '0');
+    }
+    return negative ? -result : result;
+}
+
+bool BigInt::toLongLong(long long& out) const {
+    if (value.size() > 18) return false;
+    long long result = 0;
+    for (char c : value) result = result * 10 + (c - '0');
+    out = negative ? -result : result;
+    return true;
+}
+
+bool BigInt::toBool() const {
+    return value != "0";
+}
+
+BigInt BigInt::operator+(const BigInt& other) const {
+    if (negative == other.negative) {
+        BigInt result;
+        result.value = absAdd(value, other.value);
+        result.negative = negative;
+        result.removeLeadingZeros();
+        return result;
+    } else {
+        if (absGreater(value, other.value)) {
+            BigInt result;
+            result.value = absSub(value, other.value);
+            result.negative = negative;
+            result.removeLeadingZeros();
+            return result;
+        } else if (value == other.value) {
+            return BigInt();
+        } else {
+            BigInt result;
+            result.value = absSub(other.value, value);
+            result.negative = other.negative;
+            result.removeLeadingZeros();
+            return result;
+        }
+    }
+}
+
+BigInt BigInt::operator-(const BigInt& other) const {
+    return *this + (-other);
+}
+
+BigInt BigInt::operator*(const BigInt& other) const {
+    BigInt result;
+    result.value = absMul(value, other.value);
+    result.negative = (negative != other.negative) && result.value != "0";
+    result.removeLeadingZeros();
+    return result;
+}
+
+BigInt BigInt::operator/(const BigInt& other) const {
+    auto [q, r] = absDiv(value, other.value);
+    BigInt result;
+    result.value = q;
+    result.negative = (negative != other.negative) && result.value != "0";
+    
+    // Python floor division: if signs differ and there's a remainder, subtract 1 from quotient
+    if (negative != other.negative && r != "0") {
+        result = result - BigInt(1);
+    }
+    
+    result.removeLeadingZeros();
+    return result;
+}
+
+BigInt BigInt::operator%(const BigInt& other) const {
+    std::string r = absMod(value, other.value);
+    BigInt result;
+    result.value = r;
+    
+    // Python modulo: result has same sign as divisor (other)
+    // a = b*q + r where r has same sign as b
+    if (r != "0") {
+        if (negative && !other.negative) {
+            // negative % positive: result = b - r
+            result = other - BigInt(r);
+        } else if (!negative && other.negative) {
+            // positive % negative: result = -(|b| - r) = r - |b|
+            result = BigInt(r) + other;  // other is negative, so this subtracts
+        } else if (negative && other.negative) {
+            // negative % negative: result is negative
+            result.value = r;
+            result.negative = true;
+        } else {
+            // positive % positive
+            result.value = r;
+            result.negative = false;
+        }
+    } else {
+        result.value = "0";
+        result.negative = false;
+    }
+    
+    result.removeLeadingZeros();
+    return result;
+}
+
+BigInt BigInt::operator-() const {
+    BigInt result = *this;
+    if (value != "0") result.negative = !negative;
+    return result;
+}
+
+bool BigInt::operator<(const BigInt& other) const {
+    if (negative != other.negative) return negative;
+    if (negative) return absGreater(value, other.value);
+    return !absGreater(value, other.value) && value != other.value;
+}
+
+bool BigInt::operator>(const BigInt& other) const {
+    return other < *this;
+}
+
+bool BigInt::operator<=(const BigInt& other) const {
+    return !(*this > other);
+}
+
+bool BigInt::operator>=(const BigInt& other) const {
+    return !(*this < other);
+}
+
+bool BigInt::operator==(const BigInt& other) const {
+    return negative == other.negative && value == other.value;
+}
+
+bool BigInt::operator!=(const BigInt& other) const {
+    return !(*this == other);
+}
+
+// ============ Value Implementation ============
+
+Value::Value() : type(ValueType::NONE) {}
+
+Value::Value(bool b) : type(ValueType::BOOL), boolVal(b) {}
+
+Value::Value(const BigInt& i) : type(ValueType::INT), intVal(i) {}
+
+Value::Value(double f) : type(ValueType::FLOAT), floatVal(f) {}
+
+Value::Value(const std::string& s) : type(ValueType::STRING), stringVal(s) {}
+
+std::string Value::toString() const {
+    switch (type) {
+        case ValueType::NONE:
+            return "None";
+        case ValueType::BOOL:
+            return boolVal ? "True" : "False";
+        case ValueType::INT:
+            return intVal.toString();
+        case ValueType::FLOAT: {
+            std::ostringstream oss;
+            oss << std::fixed << std::setprecision(6) << floatVal;
+            return oss.str();
+        }
+        case ValueType::STRING:
+            return stringVal;
+    }
+    return "";
+}
+
+bool Value::toBool() const {
+    switch (type) {
+        case ValueType::NONE:
+            return false;
+        case ValueType::BOOL:
+            return boolVal;
+        case ValueType::INT:
+            return intVal.toBool();
+        case ValueType::FLOAT:
+            return floatVal != 0.0;
+        case ValueType::STRING:
+            return !stringVal.empty();
+    }
+    return false;
+}
+
+Value Value::toInt() const {
+    switch (type) {
+        case ValueType::BOOL:
+            return Value(BigInt(boolVal ? 1 : 0));
+        case ValueType::INT:
+            return *this;
+        case ValueType::FLOAT:
+            return Value(BigInt((long long)floatVal));
+        case ValueType::STRING: {
+            try {
+                // Remove leading/trailing spaces
+                std::string s = stringVal;
+                s.erase(0, s.find_first_not_of(" \t\n\r"));
+                s.erase(s.find_last_not_of(" \t\n\r") + 1);
+                
+                if (s.find('.') != std::string::npos) {
+                    return Value(BigInt((long long)std::stod(s)));
+                }
+                return Value(BigInt(s));
+            } catch (...) {
+                return Value(BigInt(0));
+            }
+        }
+        default:
+            return Value(BigInt(0));
+    }
+}
+
+Value Value::toFloat() const {
+    switch (type) {
+        case ValueType::BOOL:
+            return Value(boolVal ? 1.0 : 0.0);
+        case ValueType::INT:
+            return Value(intVal.toDouble());
+        case ValueType::FLOAT:
+            return *this;
+        case ValueType::STRING:
+            try {
+                return Value(std::stod(stringVal));
+            } catch (...) {
+                return Value(0.0);
+            }
+        default:
+            return Value(0.0);
+    }
+}
+
+Value Value::toStr() const {
+    if (type == ValueType::STRING) return *this;
+    return Value(toString());
+}
+
+Value Value::operator+(const Value& other) const {
+    if (type == ValueType::STRING || other.type == ValueType::STRING) {
+        return Value(toString() + other.toString());
+    }
+    // Handle BOOL as numeric
+    if (type == ValueType::FLOAT || other.type == ValueType::FLOAT) {
+        return Value(toFloat().floatVal + other.toFloat().floatVal);
+    }
+    // Both are INT or BOOL - convert BOOL to INT
+    if ((type == ValueType::INT || type == ValueType::BOOL) && 
+        (other.type == ValueType::INT || other.type == ValueType::BOOL)) {
+        BigInt v1 = (type == ValueType::BOOL) ? BigInt(boolVal ? 1 : 0) : intVal;
+        BigInt v2 = (other.type == ValueType::BOOL) ? BigInt(other.boolVal ? 1 : 0) : other.intVal;
+        return Value(v1 + v2);
+    }
+    return Value();
+}
+
+Value Value::operator-(const Value& other) const {
+    // Handle BOOL as numeric
+    if (type == ValueType::FLOAT || other.type == ValueType::FLOAT) {
+        return Value(toFloat().floatVal - other.toFloat().floatVal);
+    }
+    // Both are INT or BOOL - convert BOOL to INT
+    if ((type == ValueType::INT || type == ValueType::BOOL) && 
+        (other.type == ValueType::INT || other.type == ValueType::BOOL)) {
+        BigInt v1 = (type == ValueType::BOOL) ? BigInt(boolVal ? 1 : 0) : intVal;
+        BigInt v2 = (other.type == ValueType::BOOL) ? BigInt(other.boolVal ? 1 : 0) : other.intVal;
+        return Value(v1 - v2);
+    }
+    return Value();
+}
+
+Value Value::operator*(const Value& other) const {
+    // String repetition
+    if (type == ValueType::STRING && (other.type == ValueType::INT || other.type == ValueType::BOOL)) {
+        std::string result;
+        BigInt count = (other.type == ValueType::BOOL) ? BigInt(other.boolVal ? 1 : 0) : other.intVal;
+        long long n = count.toDouble();
+        if (n > 0) {
+            for (long long i = 0; i < n; i++) {
+                result += stringVal;
+            }
+        }
+        return Value(result);
+    }
+    if ((type == ValueType::INT || type == ValueType::BOOL) && other.type == ValueType::STRING) {
+        std::string result;
+        BigInt count = (type == ValueType::BOOL) ? BigInt(boolVal ? 1 : 0) : intVal;
+        long long n = count.toDouble();
+        if (n > 0) {
+            for (long long i = 0; i < n; i++) {
+                result += other.stringVal;
+            }
+        }
+        return Value(result);
+    }
+    
+    // Handle BOOL as numeric
+    if (type == ValueType::FLOAT || other.type == ValueType::FLOAT) {
+        return Value(toFloat().floatVal * other.toFloat().floatVal);
+    }
+    // Both are INT or BOOL - convert BOOL to INT
+    if ((type == ValueType::INT || type == ValueType::BOOL) && 
+        (other.type == ValueType::INT || other.type == ValueType::BOOL)) {
+        BigInt v1 = (type == ValueType::BOOL) ? BigInt(boolVal ? 1 : 0) : intVal;
+        BigInt v2 = (other.type == ValueType::BOOL) ? BigInt(other.boolVal ? 1 : 0) : other.intVal;
+        return Value(v1 * v2);
+    }
+    return Value();
+}
+
+Value Value::operator/(const Value& other) const {
+    return Value(toFloat().floatVal / other.toFloat().floatVal);
+}
+
+Value Value::operator%(const Value& other) const {
+    if (type == ValueType::INT && other.type == ValueType::INT) {
+        return Value(intVal % other.intVal);
+    }
+    return Value();
+}
+
+Value Value::floordiv(const Value& other) const {
+    if (type == ValueType::INT && other.type == ValueType::INT) {
+        return Value(intVal / other.intVal);
+    }
+    double result = std::floor(toFloat().floatVal / other.toFloat().floatVal);
+    return Value(result);
+}
+
+Value Value::operator-() const {
+    if (type == ValueType::INT) {
+        return Value(-intVal);
+    }
+    if (type == ValueType::FLOAT) {
+        return Value(-floatVal);
+    }
+    return Value();
+}
+
+bool Value::operator<(const Value& other) const {
+    // Handle BOOL as numeric for comparison
+    if ((type == ValueType::BOOL || type == ValueType::INT || type == ValueType::FLOAT) &&
+        (other.type == ValueType::BOOL || other.type == ValueType::INT || other.type == ValueType::FLOAT)) {
+        // Convert both to float for comparison
+        double v1 = (type == ValueType::BOOL) ? (boolVal ? 1.0 : 0.0) : toFloat().floatVal;
+        double v2 = (other.type == ValueType::BOOL) ? (other.boolVal ? 1.0 : 0.0) : other.toFloat().floatVal;
+        return v1 < v2;
+    }
+    
+    if (type == ValueType::STRING && other.type == ValueType::STRING) {
+        return stringVal < other.stringVal;
+    }
+    return false;
+}
+
+bool Value::operator>(const Value& other) const {
+    return other < *this;
+}
+
+bool Value::operator<=(const Value& other) const {
+    return !(*this > other);
+}
+
+bool Value::operator>=(const Value& other) const {
+    return !(*this < other);
+}
+
+bool Value::operator==(const Value& other) const {
+    // Handle BOOL as numeric for comparison
+    if ((type == ValueType::BOOL || type == ValueType::INT || type == ValueType::FLOAT) &&
+        (other.type == ValueType::BOOL || other.type == ValueType::INT || other.type == ValueType::FLOAT)) {
+        // Convert both to float for comparison
+        double v1 = (type == ValueType::BOOL) ? (boolVal ? 1.0 : 0.0) : toFloat().floatVal;
+        double v2 = (other.type == ValueType::BOOL) ? (other.boolVal ? 1.0 : 0.0) : other.toFloat().floatVal;
+        return v1 == v2;
+    }
+    
+    if (type != other.type) {
+        return false;
+    }
+    
+    switch (type) {
+        case ValueType::NONE:
+            return true;
+        case ValueType::BOOL:
+            return boolVal == other.boolVal;
+        case ValueType::INT:
+            return intVal == other.intVal;
+        case ValueType::FLOAT:
+            return floatVal == other.floatVal;
+        case ValueType::STRING:
+            return stringVal == other.stringVal;
+    }
+    return false;
+}
+
+bool Value::operator!=(const Value& other) const {
+    return !(*this == other);
+}
+
+std::string decodeStringLiteral(const std::string& s) {
+    std::string result;
+    bool escaped = false;
+    
+    // Remove quotes
+    std::string content = s.substr(1, s.length() - 2);
+    
+    for (size_t i = 0; i < content.length(); i++) {
+        if (escaped) {
+            switch (content[i]) {
+                case 'n': result += '\n'; break;
+                case 't': result += '\t'; break;
+                case 'r': result += '\r'; break;
+                case '\\': result += '\\'; break;
+                case '\'': result += '\''; break;
+                case '\"': result += '\"'; break;
+                default: result += content[i]; break;
+            }
+            escaped = false;
+        } else if (content[i] == '\\') {
+            escaped = true;
+        } else {
+            result += content[i];
+        }
+    }
+    
+    return result;
+}
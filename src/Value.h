@@ -0,0 +1,94 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_VALUE_H
+#define PYTHON_INTERPRETER_VALUE_H
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+
+// Big integer class for arbitrary precision arithmetic
+class BigInt {
+private:
+    std::string value;
+    bool negative;
+    
+    void removeLeadingZeros();
+    static bool absGreater(const std::string& a, const std::string& b);
+    static std::string absAdd(const std::string& a, const std::string& b);
+    static std::string absSub(const std::string& a, const std::string& b);
+    static std::string absMul(const std::string& a, const std::string& b);
+    static std::pair<std::string, std::string> absDiv(const std::string& a, const std::string& b);
+    static std::string absMod(const std::string& a, const std::string& b);
+    
+public:
+    BigInt();
+    BigInt(const std::string& s);
+    BigInt(long long n);
+    BigInt(int n);
+    
+    std::string toString() const;
+    double toDouble() const;
+    bool toBool() const;
+    // The value as a machine integer, if it has at most 18 digits
+    bool toLongLong(long long& out) const;
+    
+    BigInt operator+(const BigInt& other) const;
+    BigInt operator-(const BigInt& other) const;
+    BigInt operator*(const BigInt& other) const;
+    BigInt operator/(const BigInt& other) const;
+    BigInt operator%(const BigInt& other) const;
+    BigInt operator-() const;
+    
+    bool operator<(const BigInt& other) const;
+    bool operator>(const BigInt& other) const;
+    bool operator<=(const BigInt& other) const;
+    bool operator>=(const BigInt& other) const;
+    bool operator==(const BigInt& other) const;
+    bool operator!=(const BigInt& other) const;
+};
+
+// Value type for interpreter
+enum class ValueType { NONE, BOOL, INT, FLOAT, STRING };
+
+class Value {
+public:
+    ValueType type;
+    bool boolVal;
+    BigInt intVal;
+    double floatVal;
+    std::string stringVal;
+    
+    Value();
+    Value(bool b);
+    Value(const BigInt& i);
+    Value(double f);
+    Value(const std::string& s);
+    
+    std::string toString() const;
+    bool toBool() const;
+    Value toInt() const;
+    Value toFloat() const;
+    Value toStr() const;
+    
+    Value operator+(const Value& other) const;
+    Value operator-(const Value& other) const;
+    Value operator*(const Value& other) const;
+    Value operator/(const Value& other) const;
+    Value operator%(const Value& other) const;
+    Value floordiv(const Value& other) const;
+    Value operator-() const;
+    
+    bool operator<(const Value& other) const;
+    bool operator>(const Value& other) const;
+    bool operator<=(const Value& other) const;
+    bool operator>=(const Value& other) const;
+    bool operator==(const Value& other) const;
+    bool operator!=(const Value& other) const;
+};
+
+// Decodes a quoted string literal token, handling backslash escapes
+std::string decodeStringLiteral(const std::string& s);
+
+#endif//PYTHON_INTERPRETER_VALUE_H
@@ -0,0 +1,470 @@
+#include "Vm.h"
+#include "Builtins.h"
+#include <algorithm>
+
+// The dispatch loop is direct-threaded where labels-as-values are
+// available: every handler ends by jumping straight to the handler of the
+// next instruction, so each opcode gets its own indirect branch. Other
+// compilers, or builds defining PYINTERP_SWITCH_DISPATCH, use a switch.
+#if defined(__GNUC__) && !defined(PYINTERP_SWITCH_DISPATCH)
+#define VM_THREADED 1
+#endif
+
+#ifdef VM_THREADED
+#define VM_CASE(op) L_##op:
+#define VM_LABEL(op) static_cast<char*>(&&L_##op)
+#define VM_HANDLER(op) static_cast<int32_t>(VM_LABEL(op) - VM_LABEL(LOADK))
+#define VM_NEXT()                                  \
+    do {                                           \
+        in = pc++;                                 \
+        goto *(VM_LABEL(LOADK) + in->handler);     \
+    } while (false)
+#define VM_RELINK() (in->handler = handlers[static_cast<size_t>(in->op)])
+#define VM_FALLTHROUGH() ((void) 0)
+#else
+#define VM_CASE(op) case Opcode::op:
+#define VM_NEXT() continue
+#define VM_RELINK() ((void) 0)
+#define VM_FALLTHROUGH() [[fallthrough]]
+#endif
+
+// Generic arithmetic and comparisons rewrite themselves to the variant for
+// the operand types they see, unless that variant has failed too often
+#define VM_QUICKEN()                                                    \
+    do {                                                                \
+        if (in->x < MAX_QUICKEN_MISSES) {                               \
+            in->op = quickened(in->op, R[in->b], R[in->c]);             \
+            VM_RELINK();                                                \
+        }                                                               \
+    } while (false)
+
+// A quickened instruction: when check fails it reverts to its generic
+// opcode and is dispatched again
+#define VM_QUICK(opcode, check, body)                                       \
+    VM_CASE(opcode)                                                     \
+        if (check) {                                                    \
+            body;                                                       \
+            VM_NEXT();                                                  \
+        }                                                               \
+        in->x++;                                                        \
+        in->op = genericOpcode(in->op);                                 \
+        VM_RELINK();                                                    \
+        pc--;                                                           \
+        VM_NEXT();
+
+// LOADK followed by an integer operation: both run in one dispatch when
+// the operands are ints, otherwise the operation is dispatched on its own
+#define VM_LOADK_ARITH(opcode, op)                                                      \
+    VM_CASE(LOADK_##opcode)                                                             \
+        R[in->a] = constants[in->d];                                                    \
+        if (R[pc->b].type == ValueType::INT && R[pc->c].type == ValueType::INT) {       \
+            setInt(R[pc->a], R[pc->b].intVal op R[pc->c].intVal);                       \
+            pc++;                                                                       \
+        }                                                                               \
+        VM_NEXT();
+
+// A comparison and the JUMPIFNOT testing its result, with the same form
+// preceded by the LOADK of an operand falling through into it
+#define VM_COMPARE_JUMP(opcode, op)                                                     \
+    VM_CASE(LOADK_##opcode##_JUMPIFNOT)                                                 \
+        R[in->a] = constants[in->d];                                                    \
+        in = pc++;                                                                      \
+        VM_FALLTHROUGH();                                                               \
+    VM_CASE(opcode##_JUMPIFNOT) {                                                       \
+        bool holds = VM_INTS() ? R[in->b].intVal.toDouble() op R[in->c].intVal.toDouble() \
+                               : R[in->b] op R[in->c];                                  \
+        setBool(R[in->a], holds);                                                       \
+        pc = holds ? pc + 1 : code + pc->d;                                             \
+        VM_NEXT();                                                                      \
+    }
+
+#define VM_INTS() (R[in->b].type == ValueType::INT && R[in->c].type == ValueType::INT)
+#define VM_FLOATS() (R[in->b].type == ValueType::FLOAT && R[in->c].type == ValueType::FLOAT)
+#define VM_STRINGS() (R[in->b].type == ValueType::STRING && R[in->c].type == ValueType::STRING)
+
+namespace {
+
+// Failed type checks after which an instruction stays generic
+constexpr uint8_t MAX_QUICKEN_MISSES = 4;
+
+// The variant of a generic opcode specialised for operands x and y, or op
+// itself when there is none
+Opcode quickened(Opcode op, const Value& x, const Value& y) {
+    bool ints = x.type == ValueType::INT && y.type == ValueType::INT;
+    bool floats = x.type == ValueType::FLOAT && y.type == ValueType::FLOAT;
+    bool strings = x.type == ValueType::STRING && y.type == ValueType::STRING;
+    switch (op) {
+        case Opcode::ADD: return ints ? Opcode::ADD_INT : floats ? Opcode::ADD_FLOAT : strings ? Opcode::ADD_STR : op;
+        case Opcode::SUB: return ints ? Opcode::SUB_INT : floats ? Opcode::SUB_FLOAT : op;
+        case Opcode::MUL: return ints ? Opcode::MUL_INT : floats ? Opcode::MUL_FLOAT : op;
+        case Opcode::DIV: return floats ? Opcode::DIV_FLOAT : op;
+        case Opcode::FLOORDIV: return ints ? Opcode::FLOORDIV_INT : op;
+        case Opcode::MOD: return ints ? Opcode::MOD_INT : op;
+        case Opcode::LT: return ints ? Opcode::LT_INT : op;
+        case Opcode::GT: return ints ? Opcode::GT_INT : op;
+        case Opcode::LE: return ints ? Opcode::LE_INT : op;
+        case Opcode::GE: return ints ? Opcode::GE_INT : op;
+        case Opcode::EQ: return ints ? Opcode::EQ_INT : op;
+        case Opcode::NE: return ints ? Opcode::NE_INT : op;
+        default: return op;
+    }
+}
+
+// Results of quickened instructions are stored in place, which saves
+// building and copying a whole Value
+inline void setInt(Value& dst, BigInt value) {
+    dst.intVal = std::move(value);
+    dst.type = ValueType::INT;
+}
+
+inline void setFloat(Value& dst, double value) {
+    dst.floatVal = value;
+    dst.type = ValueType::FLOAT;
+}
+
+inline void setBool(Value& dst, bool value) {
+    dst.boolVal = value;
+    dst.type = ValueType::BOOL;
+}
+
+inline void setString(Value& dst, std::string value) {
+    dst.stringVal = std::move(value);
+    dst.type = ValueType::STRING;
+}
+
+}// namespace
+
+// Iterations after which a loop is handed to the JIT
+constexpr uint32_t JIT_THRESHOLD = 32;
+
+Vm::Vm(BytecodeProgram& program, VmOptions options, MemoCache* memo) : program(program), memo(memo) {
+    if (options.jit) jit = std::make_unique<Jit>(program, options.perfMap);
+}
+
+void Vm::reserveStack(size_t size) {
+    if (stack.size() >= size) return;
+    size_t capacity = std::max(size, stack.size() * 2);
+    stack.resize(capacity);
+    bound.resize(capacity);
+}
+
+// Sets up the parameters and locals of a callee whose frame starts at base,
+// where the caller left argc argument values
+void Vm::bindArguments(const Function& function, const CallSite& site, size_t base, size_t argc) {
+    const FunctionProto& proto = *function.proto;
+    size_t paramCount = proto.params.size();
+    size_t firstDefault = paramCount - function.defaults.size();
+    Value* regs = stack.data() + base;
+    char* given = bound.data() + base;
+    std::fill(given, given + proto.localCount, false);
+
+    if (site.keywords.empty()) {
+        // Positional arguments already sit in the parameter registers
+        for (size_t i = 0; i < std::min(argc, paramCount); i++) given[i] = true;
+    } else {
+        scratch.assign(regs, regs + argc);
+        size_t position = 0;
+        for (size_t i = 0; i < argc; i++) {
+            if (site.keywords[i] == ast::NO_SYMBOL) {
+                if (position < paramCount) {
+                    regs[position] = std::move(scratch[i]);
+                    given[position++] = true;
+                }
+                continue;
+            }
+            for (size_t p = 0; p < paramCount; p++) {
+                if (proto.params[p] == site.keywords[i]) {
+                    regs[p] = std::move(scratch[i]);
+                    given[p] = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Missing parameters take their default, or None
+    for (size_t i = 0; i < paramCount; i++) {
+        if (given[i]) continue;
+        regs[i] = i >= firstDefault ? function.defaults[i - firstDefault] : Value();
+    }
+    std::fill(given, given + paramCount, false);
+    for (size_t i = paramCount; i < proto.localCount; i++) regs[i] = Value();
+}
+
+// Looks up the call of callee whose frame starts at base, preparing frame
+// to store the result when it is not cached yet
+const Value* Vm::lookupMemo(Frame& frame, const FunctionProto& callee, size_t base) {
+    if (!memo->memoizes(callee.name)) return nullptr;
+    frame.memoized = MemoCache::makeKey(callee.name, stack.data() + base, callee.params.size(), frame.memoKey);
+    return frame.memoized ? memo->lookup(callee.name, frame.memoKey) : nullptr;
+}
+
+void Vm::run() {
+    size_t symbolCount = program.symbols->size();
+    globals.resize(symbolCount);
+    globalBound.resize(symbolCount);
+    functions.resize(symbolCount);
+
+#ifdef VM_THREADED
+    // Link every instruction to its handler, stored as an offset from the
+    // first handler label so it fits next to the operands
+    const int32_t handlers[] = {
+        VM_HANDLER(LOADK), VM_HANDLER(MOVE), VM_HANDLER(GETGLOBAL), VM_HANDLER(SETGLOBAL),
+        VM_HANDLER(GETNAME), VM_HANDLER(SETNAME), VM_HANDLER(ADD), VM_HANDLER(SUB),
+        VM_HANDLER(MUL), VM_HANDLER(DIV), VM_HANDLER(FLOORDIV), VM_HANDLER(MOD),
+        VM_HANDLER(NEG), VM_HANDLER(NOT), VM_HANDLER(LT), VM_HANDLER(GT),
+        VM_HANDLER(LE), VM_HANDLER(GE), VM_HANDLER(EQ), VM_HANDLER(NE),
+        VM_HANDLER(JUMP), VM_HANDLER(JUMPIF), VM_HANDLER(JUMPIFNOT), VM_HANDLER(CALL),
+        VM_HANDLER(BUILTIN), VM_HANDLER(FORMAT), VM_HANDLER(DEFINE), VM_HANDLER(LOOP),
+        VM_HANDLER(TAILCALL), VM_HANDLER(RETURN), VM_HANDLER(ADD_INT), VM_HANDLER(SUB_INT), VM_HANDLER(MUL_INT),
+        VM_HANDLER(FLOORDIV_INT), VM_HANDLER(MOD_INT), VM_HANDLER(ADD_FLOAT), VM_HANDLER(SUB_FLOAT),
+        VM_HANDLER(MUL_FLOAT), VM_HANDLER(DIV_FLOAT), VM_HANDLER(ADD_STR), VM_HANDLER(LT_INT),
+        VM_HANDLER(GT_INT), VM_HANDLER(LE_INT), VM_HANDLER(GE_INT), VM_HANDLER(EQ_INT),
+        VM_HANDLER(NE_INT), VM_HANDLER(LOADK_ADD), VM_HANDLER(LOADK_SUB), VM_HANDLER(LOADK_MOD),
+        VM_HANDLER(LT_JUMPIFNOT), VM_HANDLER(GT_JUMPIFNOT), VM_HANDLER(LE_JUMPIFNOT),
+        VM_HANDLER(GE_JUMPIFNOT), VM_HANDLER(EQ_JUMPIFNOT), VM_HANDLER(NE_JUMPIFNOT),
+        VM_HANDLER(LOADK_LT_JUMPIFNOT), VM_HANDLER(LOADK_GT_JUMPIFNOT), VM_HANDLER(LOADK_LE_JUMPIFNOT),
+        VM_HANDLER(LOADK_GE_JUMPIFNOT), VM_HANDLER(LOADK_EQ_JUMPIFNOT), VM_HANDLER(LOADK_NE_JUMPIFNOT),
+    };
+    static_assert(sizeof(handlers) / sizeof(handlers[0]) == OPCODE_COUNT, "one handler per opcode");
+    for (const auto& function : program.functions) {
+        for (Instr& instr : function->code) instr.handler = handlers[static_cast<size_t>(instr.op)];
+    }
+#endif
+
+    FunctionProto* module = program.functions[0].get();
+    reserveStack(module->frameSize);
+    const Value* constants = program.constants.data();
+    FunctionProto* proto = module;
+    Instr* code = module->code.data();
+    Instr* pc = code;
+    Instr* in;
+    size_t base = 0;
+    Value* R = stack.data();
+
+#ifdef VM_THREADED
+    VM_NEXT();
+#else
+    for (;;) {
+        in = pc++;
+        switch (in->op) {
+#endif
+
+    VM_CASE(LOADK)
+        R[in->a] = constants[in->d];
+        VM_NEXT();
+    VM_CASE(MOVE)
+        R[in->a] = R[in->b];
+        VM_NEXT();
+    VM_CASE(GETGLOBAL)
+        R[in->a] = globalBound[in->d] ? globals[in->d] : Value();
+        VM_NEXT();
+    VM_CASE(SETGLOBAL)
+        globals[in->d] = R[in->a];
+        globalBound[in->d] = true;
+        VM_NEXT();
+    VM_CASE(GETNAME)
+        if (bound[base + in->b]) {
+            R[in->a] = R[in->b];
+        } else {
+            R[in->a] = globalBound[in->d] ? globals[in->d] : Value();
+        }
+        VM_NEXT();
+    VM_CASE(SETNAME)
+        // An unbound local only shadows a global that does not exist yet
+        if (bound[base + in->b] || !globalBound[in->d]) {
+            R[in->b] = R[in->a];
+            bound[base + in->b] = true;
+        } else {
+            globals[in->d] = R[in->a];
+        }
+        VM_NEXT();
+    VM_CASE(ADD)
+        VM_QUICKEN();
+        R[in->a] = R[in->b] + R[in->c];
+        VM_NEXT();
+    VM_CASE(SUB)
+        VM_QUICKEN();
+        R[in->a] = R[in->b] - R[in->c];
+        VM_NEXT();
+    VM_CASE(MUL)
+        VM_QUICKEN();
+        R[in->a] = R[in->b] * R[in->c];
+        VM_NEXT();
+    VM_CASE(DIV)
+        VM_QUICKEN();
+        R[in->a] = R[in->b] / R[in->c];
+        VM_NEXT();
+    VM_CASE(FLOORDIV)
+        VM_QUICKEN();
+        R[in->a] = R[in->b].floordiv(R[in->c]);
+        VM_NEXT();
+    VM_CASE(MOD)
+        VM_QUICKEN();
+        R[in->a] = R[in->b] % R[in->c];
+        VM_NEXT();
+    VM_CASE(NEG)
+        R[in->a] = -R[in->b];
+        VM_NEXT();
+    VM_CASE(NOT)
+        R[in->a] = Value(!R[in->b].toBool());
+        VM_NEXT();
+    VM_CASE(LT)
+        VM_QUICKEN();
+        R[in->a] = Value(R[in->b] < R[in->c]);
+        VM_NEXT();
+    VM_CASE(GT)
+        VM_QUICKEN();
+        R[in->a] = Value(R[in->b] > R[in->c]);
+        VM_NEXT();
+    VM_CASE(LE)
+        VM_QUICKEN();
+        R[in->a] = Value(R[in->b] <= R[in->c]);
+        VM_NEXT();
+    VM_CASE(GE)
+        VM_QUICKEN();
+        R[in->a] = Value(R[in->b] >= R[in->c]);
+        VM_NEXT();
+    VM_CASE(EQ)
+        VM_QUICKEN();
+        R[in->a] = Value(R[in->b] == R[in->c]);
+        VM_NEXT();
+    VM_CASE(NE)
+        VM_QUICKEN();
+        R[in->a] = Value(R[in->b] != R[in->c]);
+        VM_NEXT();
+    VM_CASE(JUMP)
+        pc = code + in->d;
+        VM_NEXT();
+    VM_CASE(JUMPIF)
+        if (R[in->a].toBool()) pc = code + in->d;
+        VM_NEXT();
+    VM_CASE(JUMPIFNOT)
+        if (!R[in->a].toBool()) pc = code + in->d;
+        VM_NEXT();
+    VM_CASE(TAILCALL) {
+        // The callee takes over the frame of the running function: the
+        // arguments move to the parameter registers and its body starts in
+        // place, returning straight to our caller. A memoized callee needs
+        // a frame of its own to store its result, so it gets an ordinary
+        // call, falling through to CALL, as does a call from module code.
+        const CallSite& site = program.callSites[in->d];
+        const Function* function = functions[site.callee].get();
+        if (function && !frames.empty() && (!memo || !memo->memoizes(function->proto->name))) {
+            FunctionProto* callee = function->proto;
+            reserveStack(base + callee->frameSize);
+            R = stack.data() + base;
+            for (uint16_t i = 0; i < in->c; i++) R[i] = std::move(R[in->b + i]);
+            bindArguments(*function, site, base, in->c);
+            proto = callee;
+            code = callee->code.data();
+            pc = code;
+            VM_NEXT();
+        }
+        // Otherwise it runs as an ordinary call
+        VM_FALLTHROUGH();
+    }
+    VM_CASE(CALL) {
+        // Calling a name that is not (yet) a function yields None
+        const CallSite& site = program.callSites[in->d];
+        const Function* function = functions[site.callee].get();
+        if (!function) {
+            R[in->a] = Value();
+            VM_NEXT();
+        }
+        FunctionProto* callee = function->proto;
+        size_t calleeBase = base + in->b;
+        reserveStack(calleeBase + callee->frameSize);
+        bindArguments(*function, site, calleeBase, in->c);
+        frames.push_back(Frame{proto, pc, base, in->a, false, {}});
+        if (memo) {
+            if (const Value* result = lookupMemo(frames.back(), *callee, calleeBase)) {
+                R[in->a] = *result;
+                frames.pop_back();
+                VM_NEXT();
+            }
+        }
+        proto = callee;
+        code = callee->code.data();
+        pc = code;
+        base = calleeBase;
+        R = stack.data() + base;
+        VM_NEXT();
+    }
+    VM_CASE(BUILTIN)
+        R[in->a] = invokeBuiltin(static_cast<Builtin>(in->x), R + in->b, in->c);
+        VM_NEXT();
+    VM_CASE(FORMAT) {
+        std::string text;
+        for (uint16_t i = 0; i < in->c; i++) text += R[in->b + i].toString();
+        R[in->a] = Value(text);
+        VM_NEXT();
+    }
+    VM_CASE(DEFINE) {
+        auto function = std::make_unique<Function>();
+        function->proto = program.functions[in->d].get();
+        function->defaults.assign(R + in->b, R + in->b + in->c);
+        functions[function->proto->name] = std::move(function);
+        VM_NEXT();
+    }
+    VM_CASE(LOOP) {
+        LoopSite& loop = proto->loops[in->a];
+        if (loop.compiled) {
+            uint32_t resume = jit->run(*loop.compiled, R, globals, globalBound);
+            if (resume != Jit::NOT_ENTERED) pc = code + resume;
+        } else if (!loop.rejected && ++loop.hits >= JIT_THRESHOLD) {
+            loop.compiled = jit ? jit->compile(*proto, loop, R, globals, globalBound) : nullptr;
+            loop.rejected = !loop.compiled;
+        }
+        VM_NEXT();
+    }
+    VM_CASE(RETURN) {
+        // Returning from the module body ends the program
+        if (frames.empty()) return;
+        Value result = std::move(R[in->a]);
+        Frame& caller = frames.back();
+        if (caller.memoized) memo->store(std::move(caller.memoKey), result);
+        proto = caller.proto;
+        code = proto->code.data();
+        pc = caller.returnPc;
+        base = caller.base;
+        R = stack.data() + base;
+        R[caller.result] = std::move(result);
+        frames.pop_back();
+        VM_NEXT();
+    }
+
+    // Integer comparisons go through double like the generic ones, which
+    // only differs from comparing the BigInts beyond 2^53
+    VM_QUICK(ADD_INT, VM_INTS(), setInt(R[in->a], R[in->b].intVal + R[in->c].intVal))
+    VM_QUICK(SUB_INT, VM_INTS(), setInt(R[in->a], R[in->b].intVal - R[in->c].intVal))
+    VM_QUICK(MUL_INT, VM_INTS(), setInt(R[in->a], R[in->b].intVal * R[in->c].intVal))
+    VM_QUICK(FLOORDIV_INT, VM_INTS(), setInt(R[in->a], R[in->b].intVal / R[in->c].intVal))
+    VM_QUICK(MOD_INT, VM_INTS(), setInt(R[in->a], R[in->b].intVal % R[in->c].intVal))
+    VM_QUICK(ADD_FLOAT, VM_FLOATS(), setFloat(R[in->a], R[in->b].floatVal + R[in->c].floatVal))
+    VM_QUICK(SUB_FLOAT, VM_FLOATS(), setFloat(R[in->a], R[in->b].floatVal - R[in->c].floatVal))
+    VM_QUICK(MUL_FLOAT, VM_FLOATS(), setFloat(R[in->a], R[in->b].floatVal * R[in->c].floatVal))
+    VM_QUICK(DIV_FLOAT, VM_FLOATS(), setFloat(R[in->a], R[in->b].floatVal / R[in->c].floatVal))
+    VM_QUICK(ADD_STR, VM_STRINGS(), setString(R[in->a], R[in->b].stringVal + R[in->c].stringVal))
+    VM_QUICK(LT_INT, VM_INTS(), setBool(R[in->a], R[in->b].intVal.toDouble() < R[in->c].intVal.toDouble()))
+    VM_QUICK(GT_INT, VM_INTS(), setBool(R[in->a], R[in->b].intVal.toDouble() > R[in->c].intVal.toDouble()))
+    VM_QUICK(LE_INT, VM_INTS(), setBool(R[in->a], R[in->b].intVal.toDouble() <= R[in->c].intVal.toDouble()))
+    VM_QUICK(GE_INT, VM_INTS(), setBool(R[in->a], R[in->b].intVal.toDouble() >= R[in->c].intVal.toDouble()))
+    VM_QUICK(EQ_INT, VM_INTS(), setBool(R[in->a], R[in->b].intVal.toDouble() == R[in->c].intVal.toDouble()))
+    VM_QUICK(NE_INT, VM_INTS(), setBool(R[in->a], R[in->b].intVal.toDouble() != R[in->c].intVal.toDouble()))
+
+    VM_LOADK_ARITH(ADD, +)
+    VM_LOADK_ARITH(SUB, -)
+    VM_LOADK_ARITH(MOD, %)
+    VM_COMPARE_JUMP(LT, <)
+    VM_COMPARE_JUMP(GT, >)
+    VM_COMPARE_JUMP(LE, <=)
+    VM_COMPARE_JUMP(GE, >=)
+    VM_COMPARE_JUMP(EQ, ==)
+    VM_COMPARE_JUMP(NE, !=)
+
+#ifndef VM_THREADED
+        }
+    }
+#endif
+}
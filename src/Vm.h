@@ -0,0 +1,59 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_VM_H
+#define PYTHON_INTERPRETER_VM_H
+
+#include "Bytecode.h"
+#include "Jit.h"
+#include "Memo.h"
+#include "Value.h"
+#include <memory>
+#include <vector>
+
+struct VmOptions {
+    bool jit = true;// compile hot integer loops to native code where supported
+    bool perfMap = false;// describe JIT code in /tmp/perf-<pid>.map for perf
+};
+
+// Executes register bytecode. Calls do not recurse on the C++ stack: each
+// call pushes a Frame and continues in the same dispatch loop, and the
+// callee's registers start at the caller's first argument register.
+class Vm {
+public:
+    // memo: cache for the results of pure functions, or nullptr
+    explicit Vm(BytecodeProgram& program, VmOptions options = {}, MemoCache* memo = nullptr);
+
+    void run();
+
+private:
+    // A def that has been executed, with its defaults evaluated at that time
+    struct Function {
+        FunctionProto* proto;
+        std::vector<Value> defaults;
+    };
+
+    struct Frame {
+        FunctionProto* proto;
+        Instr* returnPc;
+        size_t base;
+        uint16_t result;// caller register receiving the return value
+        bool memoized = false;// the result is stored in the memo under memoKey
+        std::string memoKey;
+    };
+
+    BytecodeProgram& program;
+    std::vector<Value> stack;// registers of all active frames
+    std::vector<char> bound;// per register, used by GETNAME / SETNAME
+    std::vector<Value> globals;
+    std::vector<char> globalBound;
+    std::vector<std::unique_ptr<Function>> functions;// by symbol
+    std::vector<Frame> frames;
+    std::vector<Value> scratch;
+    std::unique_ptr<Jit> jit;// null when disabled
+    MemoCache* memo;
+
+    void reserveStack(size_t size);
+    void bindArguments(const Function& function, const CallSite& site, size_t base, size_t argc);
+    const Value* lookupMemo(Frame& frame, const FunctionProto& callee, size_t base);
+};
+
+#endif//PYTHON_INTERPRETER_VM_H
@@ -1,12 +1,183 @@
+#include "ClosureEngine.h"
+#include "Compiler.h"
+#include "DfaCache.h"
 #include "Evalvisitor.h"
+#include "Frontend.h"
+#include "Interpreter.h"
+#include "Memo.h"
 #include "Python3Lexer.h"
 #include "Python3Parser.h"
+#include "Vm.h"
 #include "antlr4-runtime.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <string>
 using namespace antlr4;
+
+namespace {
+
+// Engines that can run a program: the compact-AST interpreter, the
+// register bytecode VM, the AST compiled to closures, or the original
+// visitor that evaluates the ANTLR parse tree directly
+enum class Engine { AST, VM, CLOSURE, VISITOR };
+
+struct Options {
+    Engine engine = Engine::AST;
+    bool dumpBytecode = false;
+    bool parseStats = false;
+    ParserKind parser = ParserKind::ANTLR;
+    unsigned parseThreads = 0;// for recursive descent, 0 for one per core
+    bool stream = false;// run each statement as soon as it is parsed
+    bool lazyDefs = false;// parse function bodies on their first call
+    std::string cacheDir;// empty: no program cache
+    std::string dfaCache;// empty: parse on cold DFAs
+    VmOptions vm;
+    size_t memoBytes = 0;// 0 when memoization is off
+};
+
+Options parseOptions(int argc, const char *argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--engine=ast") == 0) {
+            options.engine = Engine::AST;
+        } else if (std::strcmp(argv[i], "--engine=vm") == 0) {
+            options.engine = Engine::VM;
+        } else if (std::strcmp(argv[i], "--engine=closure") == 0) {
+            options.engine = Engine::CLOSURE;
+        } else if (std::strcmp(argv[i], "--engine=visitor") == 0) {
+            options.engine = Engine::VISITOR;
+        } else if (std::strcmp(argv[i], "--dump-bytecode") == 0) {
+            options.dumpBytecode = true;
+        } else if (std::strcmp(argv[i], "--stream") == 0) {
+            options.stream = true;
+        } else if (std::strcmp(argv[i], "--lazy-defs") == 0) {
+            options.lazyDefs = true;
+        } else if (std::strcmp(argv[i], "--parse-stats") == 0) {
+            options.parseStats = true;
+        } else if (std::strcmp(argv[i], "--parser=antlr") == 0) {
+            options.parser = ParserKind::ANTLR;
+        } else if (std::strcmp(argv[i], "--parser=rd") == 0) {
+            options.parser = ParserKind::RECURSIVE_DESCENT;
+        } else if (std::strncmp(argv[i], "--parse-threads=", 16) == 0 && std::atoi(argv[i] + 16) > 0) {
+            options.parseThreads = std::atoi(argv[i] + 16);
+        } else if (std::strncmp(argv[i], "--cache-dir=", 12) == 0 && argv[i][12] != '\0') {
+            options.cacheDir = argv[i] + 12;
+        } else if (std::strncmp(argv[i], "--dfa-cache=", 12) == 0 && argv[i][12] != '\0') {
+            options.dfaCache = argv[i] + 12;
+        } else if (std::strcmp(argv[i], "--no-jit") == 0) {
+            options.vm.jit = false;
+        } else if (std::strcmp(argv[i], "--perf-map") == 0) {
+            options.vm.perfMap = true;
+        } else if (std::strcmp(argv[i], "--memoize") == 0) {
+            options.memoBytes = size_t(64) << 20;
+        } else if (std::strncmp(argv[i], "--memoize=", 10) == 0 && std::atol(argv[i] + 10) > 0) {
+            options.memoBytes = static_cast<size_t>(std::atol(argv[i] + 10)) << 20;
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--engine=ast|vm|closure|visitor] [--dump-bytecode]"
+                      << " [--parser=antlr|rd] [--parse-threads=N] [--stream] [--lazy-defs] [--parse-stats] [--cache-dir=DIR] [--dfa-cache=FILE] [--no-jit] [--perf-map] [--memoize[=MiB]] < program.py" << std::endl;
+            std::exit(2);
+        }
+    }
+    if (options.stream && (options.engine != Engine::AST || options.memoBytes > 0 || !options.cacheDir.empty())) {
+        std::cerr << "--stream runs on the ast engine, without --memoize or --cache-dir" << std::endl;
+        std::exit(2);
+    }
+    if (options.lazyDefs && (options.engine != Engine::AST || options.memoBytes > 0 || !options.cacheDir.empty() ||
+                             options.stream)) {
+        std::cerr << "--lazy-defs runs on the ast engine, without --memoize, --cache-dir or --stream" << std::endl;
+        std::exit(2);
+    }
+    if (!options.dfaCache.empty() && (options.parser != ParserKind::ANTLR || options.engine == Engine::VISITOR ||
+                                      options.stream || options.lazyDefs)) {
+        std::cerr << "--dfa-cache warms the antlr parser, without --parser=rd, --engine=visitor, --stream or"
+                  << " --lazy-defs" << std::endl;
+        std::exit(2);
+    }
+    return options;
+}
+
+void reportParseStats(const ParseStats& stats) {
+    if (stats.cached) {
+        std::cerr << std::fixed << std::setprecision(1) << "parse stats: loaded from cache in "
+                  << stats.lowerSeconds * 1000 << " ms" << std::endl;
+        return;
+    }
+    std::string mode = stats.parser == ParserKind::RECURSIVE_DESCENT ? "recursive descent"
+                       : stats.fullLL                                  ? "SLL failed, LL"
+                                                                       : "SLL";
+    if (stats.parseChunks > 0) {
+        mode += ", " + std::to_string(stats.parseChunks) + " chunks on " + std::to_string(stats.parseThreads) +
+                " threads";
+    }
+    std::cerr << std::fixed << std::setprecision(1) << "parse stats: lex " << stats.lexSeconds * 1000
+              << " ms, parse " << stats.parseSeconds * 1000 << " ms (" << mode << "), lower "
+              << stats.lowerSeconds * 1000 << " ms" << std::endl;
+}
+
+}// namespace
+
 // TODO: regenerating files in directory named "generated" is dangerous.
 //       if you really need to regenerate,please ask TA for help.
 int main(int argc, const char *argv[]) {
+	Options options = parseOptions(argc, argv);
+	if (options.stream) {
+		// Always parsed by recursive descent, the parser that can stop after a statement
+		StatementStream stream(std::cin);
+		Interpreter interpreter(stream.program());
+		while (const ast::Stmt *stmt = stream.next()) {
+			if (!interpreter.runStatement(stmt, stream.firstConstant())) break;
+		}
+		return 0;
+	}
+	if (options.lazyDefs) {
+		// Always parsed by recursive descent, the parser that can resume at a body
+		ParseStats stats;
+		LazyProgram lazy(std::cin, &stats);
+		if (options.parseStats) reportParseStats(stats);
+		Interpreter interpreter(lazy.program(), nullptr, &lazy);
+		interpreter.run();
+		return 0;
+	}
+	if (options.engine != Engine::VISITOR) {
+		std::unique_ptr<DfaCache> dfaCache;
+		if (!options.dfaCache.empty()) {
+			auto start = std::chrono::steady_clock::now();
+			dfaCache = std::make_unique<DfaCache>(options.dfaCache);
+			size_t states = dfaCache->load();
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			if (options.parseStats) {
+				std::cerr << std::fixed << std::setprecision(1) << "dfa cache: " << states << " states loaded in "
+				          << elapsed.count() << " ms" << std::endl;
+			}
+		}
+		ParseStats stats;
+		auto program = options.cacheDir.empty()
+		                       ? parseProgram(std::cin, &stats, options.parser, options.parseThreads)
+		                       : loadProgram(std::cin, options.cacheDir, &stats, options.parser, options.parseThreads);
+		if (options.parseStats) reportParseStats(stats);
+		if (dfaCache) dfaCache->store();
+		std::unique_ptr<MemoCache> memo;
+		if (options.memoBytes > 0) memo = std::make_unique<MemoCache>(pureFunctions(*program), options.memoBytes);
+		if (options.engine == Engine::AST) {
+			Interpreter interpreter(*program, memo.get());
+			interpreter.run();
+		} else if (options.engine == Engine::VM) {
+			auto bytecode = Compiler(*program).compile();
+			if (options.dumpBytecode) disassemble(*bytecode, std::cerr);
+			Vm vm(*bytecode, options.vm, memo.get());
+			vm.run();
+		} else {
+			ClosureEngine engine(*program, memo.get());
+			engine.run();
+		}
+		if (memo) memo->report(std::cerr, program->symbols);
+		return 0;
+	}
+
 	// TODO: please don't modify the code below the construction of ifs if you want to use visitor mode
 	ANTLRInputStream input(std::cin);
 	Python3Lexer lexer(&input);